@@ -0,0 +1,64 @@
+// Benchmark of the BMP loader and writer
+// - loadBMP and saveBMP throughput in MB/s of pixel data at several image sizes
+// - Odd widths keep row padding and the scalar tail after the SSSE3 loop in the measurement
+// - The file stays in the file system cache, so this measures conversion rather than the disk
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <limits>
+#include <string>
+
+#include <ppgso/ppgso.h>
+
+using namespace ppgso;
+using Clock = std::chrono::steady_clock;
+
+const std::string FILE_NAME = "image_bmp_bench.bmp";
+const unsigned REPEATS = 20;
+
+static double millisecondsSince(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Best of several runs, the first run also pays for allocating the file
+template<typename F>
+static double bestOf(unsigned repeats, F &&run) {
+  auto best = std::numeric_limits<double>::max();
+  for (unsigned r = 0; r < repeats; r++) {
+    auto start = Clock::now();
+    run();
+    best = std::min(best, millisecondsSince(start));
+  }
+  return best;
+}
+
+int main() {
+  std::cout << "Threads: " << JobSystem::shared().getThreadCount() << std::endl;
+
+  struct Size {
+    int width, height;
+  };
+  for (auto size : {Size{257, 255}, Size{1023, 767}, Size{2049, 2047}, Size{4097, 4095}}) {
+    Image image{size.width, size.height};
+    for (int y = 0; y < size.height; y++)
+      for (int x = 0; x < size.width; x++)
+        image.setPixel(x, y, x & 255, y & 255, (x + y) & 255);
+    auto megabytes = size.width * size.height * sizeof(Image::Pixel) / (1024.0 * 1024.0);
+
+    auto save = bestOf(REPEATS, [&] { image::saveBMP(image, FILE_NAME); });
+    int width = 0;
+    auto load = bestOf(REPEATS, [&] { width = image::loadBMP(FILE_NAME).width; });
+    if (width != size.width) {
+      std::cerr << "Loaded image has the wrong size" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    std::cout << size.width << "x" << size.height << ": saveBMP " << save << " ms, " << megabytes / (save / 1000.0)
+              << " MB/s, loadBMP " << load << " ms, " << megabytes / (load / 1000.0) << " MB/s" << std::endl;
+  }
+
+  std::remove(FILE_NAME.c_str());
+  return EXIT_SUCCESS;
+}
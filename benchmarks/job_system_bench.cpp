@@ -0,0 +1,83 @@
+// Microbenchmark of ppgso::JobSystem
+// - Cost of queueing and finishing one empty job
+// - parallelFor over a simple loop at several grain sizes compared to a serial loop
+// - Latency of a frame wait while long background jobs keep the workers busy
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include <ppgso/ppgso.h>
+
+using namespace ppgso;
+using Clock = std::chrono::steady_clock;
+
+const unsigned JOBS = 100000;
+const size_t ITEMS = 1 << 20;
+const unsigned REPEATS = 20;
+
+static double millisecondsSince(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Some floating point work per item so ranges are not limited by memory bandwidth alone
+static void work(std::vector<float> &data, size_t first, size_t last) {
+  for (auto i = first; i < last; i++)
+    data[i] = std::sqrt(data[i] * 1.0001f + 1.0f);
+}
+
+int main() {
+  auto &jobs = JobSystem::shared();
+  std::cout << "Threads: " << jobs.getThreadCount() << std::endl;
+
+  // Empty jobs, measures queue and counter overhead
+  {
+    JobSystem::Counter counter;
+    auto start = Clock::now();
+    for (unsigned i = 0; i < JOBS; i++)
+      jobs.run([] {}, &counter);
+    jobs.wait(counter);
+    auto time = millisecondsSince(start);
+    std::cout << "Empty job: " << time * 1e6 / JOBS << " ns" << std::endl;
+  }
+
+  // Serial reference and parallelFor at different grains
+  std::vector<float> data(ITEMS, 1.0f);
+  {
+    auto start = Clock::now();
+    for (unsigned r = 0; r < REPEATS; r++)
+      work(data, 0, ITEMS);
+    std::cout << "Serial loop: " << millisecondsSince(start) / REPEATS << " ms" << std::endl;
+  }
+  for (size_t grain : {256, 4096, 65536}) {
+    auto start = Clock::now();
+    for (unsigned r = 0; r < REPEATS; r++)
+      jobs.parallelFor(ITEMS, grain, [&](size_t first, size_t last) { work(data, first, last); });
+    std::cout << "parallelFor grain " << grain << ": " << millisecondsSince(start) / REPEATS << " ms" << std::endl;
+  }
+
+  // Frame waits next to background jobs, wait must not pick up the long jobs
+  {
+    JobSystem::Counter background;
+    std::atomic<bool> release{false};
+    for (unsigned i = 0; i < jobs.getThreadCount() * 2; i++)
+      jobs.runBackground([&] {
+        while (!release) std::this_thread::yield();
+      }, &background);
+
+    double worst = 0;
+    for (unsigned r = 0; r < REPEATS; r++) {
+      auto start = Clock::now();
+      jobs.parallelFor(ITEMS / 16, 4096, [&](size_t first, size_t last) { work(data, first, last); });
+      worst = std::max(worst, millisecondsSince(start));
+    }
+    release = true;
+    jobs.wait(background);
+    std::cout << "Worst frame wait with busy workers: " << worst << " ms" << std::endl;
+  }
+
+  return EXIT_SUCCESS;
+}
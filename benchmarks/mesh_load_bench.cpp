@@ -0,0 +1,116 @@
+// Benchmark of Wavefront .obj loading
+// - tinyobj::LoadObj parse time and throughput on one thread and on all threads
+// - Mesh_Tiny::load without a MeshCache, parses the .obj and writes the cache
+// - Mesh_Tiny::load with a valid MeshCache, the CPU side of the time to first frame
+// - Mesh_Assimp::load instead when built with ASSIMP, which does not use the MeshCache
+// Run from the data directory or pass .obj paths as arguments
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <ppgso/ppgso.h>
+#include <ppgso/tiny_obj_loader.h>
+
+using namespace ppgso;
+using Mesh = AssetLoader::Mesh;
+using Clock = std::chrono::steady_clock;
+
+const unsigned REPEATS = 10;
+
+static double millisecondsSince(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Best of several runs, the first run also pays for the file system cache
+template<typename F>
+static double bestOf(unsigned repeats, F &&run) {
+  auto best = std::numeric_limits<double>::max();
+  for (unsigned r = 0; r < repeats; r++) {
+    auto start = Clock::now();
+    run();
+    best = std::min(best, millisecondsSince(start));
+  }
+  return best;
+}
+
+// Read every float so the pages of a mapped cache are actually loaded
+static float touch(const Mesh::Data &data) {
+  float sum = 0;
+  for (auto &part : data.parts) {
+#ifdef USE_ASSIMP
+    for (size_t i = 0; i < part.vertexCount * 3; i++) sum += part.positions[i];
+    for (size_t i = 0; part.texcoords && i < part.vertexCount * 3; i++) sum += part.texcoords[i];
+    for (size_t i = 0; part.normals && i < part.vertexCount * 3; i++) sum += part.normals[i];
+    for (auto index : part.indices) sum += index;
+#else
+    for (size_t i = 0; i < part.positionCount; i++) sum += part.positions[i];
+    for (size_t i = 0; i < part.texcoordCount; i++) sum += part.texcoords[i];
+    for (size_t i = 0; i < part.normalCount; i++) sum += part.normals[i];
+    for (size_t i = 0; i < part.indexCount; i++) sum += part.indices[i];
+#endif
+  }
+  return sum;
+}
+
+int main(int argc, char *argv[]) {
+  std::vector<std::string> files{"fish2/13007_Blue-Green_Reef_Chromis_v2_l3.obj",
+                                 "jellyfish/21443_Jellyfish_V1.obj",
+                                 "seaweed/maya2sketchfab.obj"};
+  if (argc > 1) files.assign(argv + 1, argv + argc);
+
+  std::cout << "Threads: " << JobSystem::shared().getThreadCount() << std::endl;
+  float checksum = 0;
+
+  for (auto &file : files) {
+    std::ifstream stream{file, std::ios::binary | std::ios::ate};
+    if (!stream) {
+      std::cerr << "Cannot open " << file << std::endl;
+      return EXIT_FAILURE;
+    }
+    auto megabytes = stream.tellg() / (1024.0 * 1024.0);
+    std::cout << file << " (" << megabytes << " MB)" << std::endl;
+
+    // Parse only
+    for (unsigned threads : {1u, 0u}) {
+      auto time = bestOf(REPEATS, [&] {
+        std::vector<tinyobj::shape_t> shapes;
+        std::vector<tinyobj::material_t> materials;
+        auto err = tinyobj::LoadObj(shapes, materials, file.c_str(), nullptr, threads);
+        if (!err.empty()) std::cerr << err << std::endl;
+      });
+      std::cout << "  LoadObj " << (threads ? "1 thread" : "all threads") << ": " << time << " ms, "
+                << megabytes / (time / 1000.0) << " MB/s" << std::endl;
+    }
+
+#ifdef USE_ASSIMP
+    // Assimp imports the .obj on every load, there is no cache to compare against
+    auto import = bestOf(REPEATS, [&] {
+      checksum += touch(Mesh::load(file));
+    });
+    std::cout << "  Mesh_Assimp::load: " << import << " ms" << std::endl;
+#else
+    // Without a cache every load parses the .obj and writes a new cache
+    auto cold = bestOf(REPEATS, [&] {
+      std::remove(MeshCache::path(file).c_str());
+      checksum += touch(Mesh::load(file));
+    });
+    std::cout << "  Mesh_Tiny::load, no cache: " << cold << " ms" << std::endl;
+
+    // The cache written by the last run is valid from here on
+    auto hit = bestOf(REPEATS, [&] {
+      checksum += touch(Mesh::load(file));
+    });
+    std::cout << "  Mesh_Tiny::load, cache hit: " << hit << " ms (" << cold / hit << "x faster)" << std::endl;
+#endif
+  }
+
+  // Keeps the touched data from being optimized away
+  std::cout << "Checksum: " << checksum << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -8,8 +8,8 @@
 
 
 // Static resources
-std::unique_ptr<ppgso::Mesh> Asteroid::mesh;
-std::unique_ptr<ppgso::Texture> Asteroid::texture;
+std::shared_ptr<ppgso::Mesh> Asteroid::mesh;
+std::shared_ptr<ppgso::Texture> Asteroid::texture;
 std::unique_ptr<ppgso::Shader> Asteroid::shader;
 
 Asteroid::Asteroid() {
@@ -21,8 +21,8 @@ Asteroid::Asteroid() {
 
   // Initialize static resources if needed
   if (!shader) shader = std::make_unique<ppgso::Shader>(diffuse_vert_glsl, diffuse_frag_glsl);
-  if (!texture) texture = std::make_unique<ppgso::Texture>(ppgso::image::loadBMP("asteroid.bmp"));
-  if (!mesh) mesh = std::make_unique<ppgso::Mesh>("asteroid.obj");
+  if (!texture) texture = ppgso::ResourceCache::getTexture("asteroid.bmp");
+  if (!mesh) mesh = ppgso::ResourceCache::getMesh("asteroid.obj");
 }
 
 bool Asteroid::update(Scene &scene, float dt) {
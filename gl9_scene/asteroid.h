@@ -15,9 +15,9 @@
 class Asteroid final : public Object {
 private:
   // Static resources (Shared between instances)
-  static std::unique_ptr<ppgso::Mesh> mesh;
+  static std::shared_ptr<ppgso::Mesh> mesh;
   static std::unique_ptr<ppgso::Shader> shader;
-  static std::unique_ptr<ppgso::Texture> texture;
+  static std::shared_ptr<ppgso::Texture> texture;
 
   // Age of the object in seconds
   float age{0.0f};
@@ -6,8 +6,8 @@
 #include <shaders/texture_frag_glsl.h>
 
 // static resources
-std::unique_ptr<ppgso::Mesh> Explosion::mesh;
-std::unique_ptr<ppgso::Texture> Explosion::texture;
+std::shared_ptr<ppgso::Mesh> Explosion::mesh;
+std::shared_ptr<ppgso::Texture> Explosion::texture;
 std::unique_ptr<ppgso::Shader> Explosion::shader;
 
 Explosion::Explosion() {
@@ -18,8 +18,8 @@ Explosion::Explosion() {
 
   // Initialize static resources if needed
   if (!shader) shader = std::make_unique<ppgso::Shader>(texture_vert_glsl, texture_frag_glsl);
-  if (!texture) texture = std::make_unique<ppgso::Texture>(ppgso::image::loadBMP("explosion.bmp"));
-  if (!mesh) mesh = std::make_unique<ppgso::Mesh>("asteroid.obj");
+  if (!texture) texture = ppgso::ResourceCache::getTexture("explosion.bmp");
+  if (!mesh) mesh = ppgso::ResourceCache::getMesh("asteroid.obj");
 }
 
 void Explosion::render(Scene &scene) {
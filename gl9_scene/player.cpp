@@ -8,8 +8,8 @@
 #include <shaders/diffuse_frag_glsl.h>
 
 // shared resources
-std::unique_ptr<ppgso::Mesh> Player::mesh;
-std::unique_ptr<ppgso::Texture> Player::texture;
+std::shared_ptr<ppgso::Mesh> Player::mesh;
+std::shared_ptr<ppgso::Texture> Player::texture;
 std::unique_ptr<ppgso::Shader> Player::shader;
 
 Player::Player() {
@@ -18,8 +18,8 @@ Player::Player() {
 
   // Initialize static resources if needed
   if (!shader) shader = std::make_unique<ppgso::Shader>(diffuse_vert_glsl, diffuse_frag_glsl);
-  if (!texture) texture = std::make_unique<ppgso::Texture>(ppgso::image::loadBMP("corsair.bmp"));
-  if (!mesh) mesh = std::make_unique<ppgso::Mesh>("corsair.obj");
+  if (!texture) texture = ppgso::ResourceCache::getTexture("corsair.bmp");
+  if (!mesh) mesh = ppgso::ResourceCache::getMesh("corsair.obj");
 }
 
 bool Player::update(Scene &scene, float dt) {
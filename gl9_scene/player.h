@@ -11,9 +11,9 @@
 class Player final : public Object {
 private:
   // Static resources (Shared between instances)
-  static std::unique_ptr<ppgso::Mesh> mesh;
+  static std::shared_ptr<ppgso::Mesh> mesh;
   static std::unique_ptr<ppgso::Shader> shader;
-  static std::unique_ptr<ppgso::Texture> texture;
+  static std::shared_ptr<ppgso::Texture> texture;
 
   // Delay fire and fire rate
   float fireDelay{0.0f};
@@ -7,9 +7,9 @@
 
 
 // shared resources
-std::unique_ptr<ppgso::Mesh> Projectile::mesh;
+std::shared_ptr<ppgso::Mesh> Projectile::mesh;
 std::unique_ptr<ppgso::Shader> Projectile::shader;
-std::unique_ptr<ppgso::Texture> Projectile::texture;
+std::shared_ptr<ppgso::Texture> Projectile::texture;
 
 Projectile::Projectile() {
   // Set default speed
@@ -18,8 +18,8 @@ Projectile::Projectile() {
 
   // Initialize static resources if needed
   if (!shader) shader = std::make_unique<ppgso::Shader>(diffuse_vert_glsl, diffuse_frag_glsl);
-  if (!texture) texture = std::make_unique<ppgso::Texture>(ppgso::image::loadBMP("missile.bmp"));
-  if (!mesh) mesh = std::make_unique<ppgso::Mesh>("missile.obj");
+  if (!texture) texture = ppgso::ResourceCache::getTexture("missile.bmp");
+  if (!mesh) mesh = ppgso::ResourceCache::getMesh("missile.obj");
 }
 
 bool Projectile::update(Scene &scene, float dt) {
@@ -13,9 +13,9 @@
 class Space final : public Object {
 private:
   // Static resources (Shared between instances)
-  static std::unique_ptr<ppgso::Mesh> mesh;
+  static std::shared_ptr<ppgso::Mesh> mesh;
   static std::unique_ptr<ppgso::Shader> shader;
-  static std::unique_ptr<ppgso::Texture> texture;
+  static std::shared_ptr<ppgso::Texture> texture;
 
   glm::vec2 textureOffset;
 public:
@@ -1,23 +1,33 @@
+#include <algorithm>
 #include <glm/glm.hpp>
 #include <sstream>
 
 #include "Mesh_Assimp.h"
+#include "mesh_optimizer.h"
+#include "state_cache.h"
 
-ppgso::Mesh_Assimp::Mesh_Assimp(const std::string &obj_file) {
+ppgso::Mesh_Assimp::Mesh_Assimp(const std::string &obj_file, const MeshOptions &options) {
 #ifdef DEBBUG_MODE
     std::cout << "Using ASSIMP Loader!" << std::endl;
 #endif
+    upload(load(obj_file, options));
+}
+
+ppgso::Mesh_Assimp::Data ppgso::Mesh_Assimp::load(const std::string &obj_file, const MeshOptions &options) {
+    Data data;
+    data.options = options;
 
-    Assimp::Importer importer;
-    scene = importer.ReadFile(obj_file, aiProcess_Triangulate | aiProcess_FlipUVs);
+    // The importer owns the scene, it is kept in the data until the upload
+    data.importer.reset(new Assimp::Importer);
+    auto scene = data.importer->ReadFile(obj_file, aiProcess_Triangulate | aiProcess_FlipUVs);
 
     if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
         std::stringstream msg;
-        msg << importer.GetErrorString() << std::endl << "Failed to load OBJ file " << obj_file << "!" << std::endl;
+        msg << data.importer->GetErrorString() << std::endl << "Failed to load OBJ file " << obj_file << "!" << std::endl;
         throw std::runtime_error(msg.str());
     }
 
-    processNode(scene->mRootNode, scene);
+    processNode(data, scene->mRootNode, scene);
 
     for (unsigned int i = 0; i < scene->mNumMaterials; ++i) {
         aiMaterial* material = scene->mMaterials[i];
@@ -25,117 +35,274 @@ ppgso::Mesh_Assimp::Mesh_Assimp(const std::string &obj_file) {
         // Diffuse color
         aiColor3D diffuseColor(0.f, 0.f, 0.f);
         material->Get(AI_MATKEY_COLOR_DIFFUSE, diffuseColor);
-        this->diffuse.emplace_back(diffuseColor.r, diffuseColor.g, diffuseColor.b);
+        data.diffuse.emplace_back(diffuseColor.r, diffuseColor.g, diffuseColor.b);
 
         // Ambient color
         aiColor3D ambientColor(0.f, 0.f, 0.f);
         material->Get(AI_MATKEY_COLOR_AMBIENT, ambientColor);
-        this->ambient.emplace_back(ambientColor.r, ambientColor.g, ambientColor.b);
+        data.ambient.emplace_back(ambientColor.r, ambientColor.g, ambientColor.b);
 
         // Specular color
         aiColor3D specularColor(0.f, 0.f, 0.f);
         material->Get(AI_MATKEY_COLOR_SPECULAR, specularColor);
-        this->specular.emplace_back(specularColor.r, specularColor.g, specularColor.b);
+        data.specular.emplace_back(specularColor.r, specularColor.g, specularColor.b);
     }
+    return data;
 }
 
 ppgso::Mesh_Assimp::~Mesh_Assimp() {
+    release();
+}
+
+void ppgso::Mesh_Assimp::release() {
     for(auto& buffer : buffers) {
         glDeleteBuffers(1, &buffer.ibo);
         glDeleteBuffers(1, &buffer.nbo);
         glDeleteBuffers(1, &buffer.tbo);
         glDeleteBuffers(1, &buffer.vbo);
+        StateCache::forgetVertexArray(buffer.vao);
         glDeleteVertexArrays(1, &buffer.vao);
     }
+    buffers.clear();
+    cpuData.reset();
+    gpuBytes = 0;
+    bounds = BoundingBox{};
+    sphere = BoundingSphere{};
+    radius = 0.0f;
 }
 
-void ppgso::Mesh_Assimp::processNode(aiNode *node, const aiScene *pScene) {
+void ppgso::Mesh_Assimp::processNode(Data &data, aiNode *node, const aiScene *pScene) {
     for (unsigned int i = 0; i < node->mNumMeshes; ++i) {
         aiMesh *mesh = pScene->mMeshes[node->mMeshes[i]];
-        processMesh(mesh);
+        processMesh(data, mesh);
     }
 
     for (unsigned int i = 0; i < node->mNumChildren; ++i) {
-        processNode(node->mChildren[i], pScene);
+        processNode(data, node->mChildren[i], pScene);
+    }
+}
+
+void ppgso::Mesh_Assimp::processMesh(Data &data, aiMesh *mesh) {
+    // Process indices
+    std::vector<unsigned int> indices;
+    for (unsigned int i = 0; i < mesh->mNumFaces; ++i) {
+        aiFace face = mesh->mFaces[i];
+        for (unsigned int j = 0; j < face.mNumIndices; ++j) {
+            indices.push_back(face.mIndices[j]);
+        }
+    }
+
+    if (data.options.optimize && !indices.empty()) {
+        // Reorder triangles and then the vertices of the imported mesh in place, the triangle order only if it improves
+        auto original = indices;
+        auto before = mesh_optimizer::computeACMR(indices.data(), indices.size(), mesh->mNumVertices);
+        mesh_optimizer::optimizeVertexCache(indices.data(), indices.size(), mesh->mNumVertices);
+        auto after = mesh_optimizer::computeACMR(indices.data(), indices.size(), mesh->mNumVertices);
+        auto kept = after >= before;
+        if (kept) indices = std::move(original);
+        auto remap = mesh_optimizer::optimizeVertexFetch(indices.data(), indices.size(), mesh->mNumVertices);
+        mesh_optimizer::remapVertices(mesh->mVertices, 1, remap);
+        if (mesh->HasTextureCoords(0)) mesh_optimizer::remapVertices(mesh->mTextureCoords[0], 1, remap);
+        if (mesh->HasNormals()) mesh_optimizer::remapVertices(mesh->mNormals, 1, remap);
+        std::cout << "Optimized " << mesh->mName.C_Str() << ": ACMR " << before << " -> " << after
+                  << (kept ? ", kept the original order" : "") << std::endl;
+    }
+
+    Data::Part part;
+    part.vertexCount = mesh->mNumVertices;
+    if (mesh->HasPositions()) part.positions = &mesh->mVertices[0].x;
+    if (mesh->HasTextureCoords(0)) part.texcoords = &mesh->mTextureCoords[0][0].x;
+    if (mesh->HasNormals()) part.normals = &mesh->mNormals[0].x;
+
+    // Simplify the levels of detail here so the upload only copies, without levels the indices are kept as they are
+    if (indices.empty()) {
+        part.lods.assign(1, IndexRange{});
+    } else if (data.options.lodRatios.empty()) {
+        part.lods.assign(1, IndexRange{(GLsizei) indices.size(), 0});
+        part.indices = std::move(indices);
+    } else {
+        buildLodIndices(data.options, part.positions, part.vertexCount, indices.data(), indices.size(), part.indices,
+                        part.lods);
     }
+    data.parts.push_back(std::move(part));
 }
 
-void ppgso::Mesh_Assimp::processMesh(aiMesh *mesh) {
-    gl_buffer buffer;
+void ppgso::Mesh_Assimp::upload(Data &&data) {
+    release();
+    options = data.options;
+    ambient = std::move(data.ambient);
+    diffuse = std::move(data.diffuse);
+    specular = std::move(data.specular);
+
+    for (auto &part : data.parts) {
+        if (part.positions) expandBounds(part.positions, part.vertexCount);
+        if (options.residency == Residency::CpuOnly)
+            continue;
+
+        gl_buffer buffer;
 
-    // Process vertices
-    if (mesh->HasPositions()) {
         // Generate a vertex array object
         glGenVertexArrays(1, &buffer.vao);
-        glBindVertexArray(buffer.vao);
-
-        // Extract vertex positions from aiMesh and upload to GPU
-        glGenBuffers(1, &buffer.vbo);
-        glBindBuffer(GL_ARRAY_BUFFER, buffer.vbo);
-        glBufferData(GL_ARRAY_BUFFER, mesh->mNumVertices * sizeof(aiVector3D), mesh->mVertices, GL_STATIC_DRAW);
-        // Enable and set up vertex attribute pointer for positions
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
-    }
+        StateCache::bindVertexArray(buffer.vao);
+
+        if (options.interleaved || options.halfTexCoords || options.packedNormals) {
+            // Single buffer with all attributes, texture coordinates are read from the 3D vectors directly
+            VertexSource source;
+            source.count = part.vertexCount;
+            source.positions = part.positions;
+            source.texcoords = part.texcoords;
+            source.texcoordStride = 3;
+            source.normals = part.normals;
+            buffer.vbo = uploadInterleavedVertices(options, source);
+        } else {
+            // Process vertices
+            if (part.positions) {
+                // Upload vertex positions to GPU
+                glGenBuffers(1, &buffer.vbo);
+                glBindBuffer(GL_ARRAY_BUFFER, buffer.vbo);
+                glBufferData(GL_ARRAY_BUFFER, part.vertexCount * 3 * sizeof(float), part.positions, GL_STATIC_DRAW);
+                // Enable and set up vertex attribute pointer for positions
+                glEnableVertexAttribArray(0);
+                glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+            }
+
+            // Process texture coordinates
+            if (part.texcoords) {
+                std::vector<aiVector2D> textureCoords;
+                for (size_t i = 0; i < part.vertexCount; ++i) {
+                    // Assuming single texture channel (index 0)
+                    textureCoords.push_back(aiVector2D(part.texcoords[i * 3], part.texcoords[i * 3 + 1]));
+                }
+
+                glGenBuffers(1, &buffer.tbo);
+                glBindBuffer(GL_ARRAY_BUFFER, buffer.tbo);
+                glBufferData(GL_ARRAY_BUFFER, textureCoords.size() * sizeof(aiVector2D), textureCoords.data(), GL_STATIC_DRAW);
 
-    // Process texture coordinates
-    if (mesh->HasTextureCoords(0)) {
-        std::vector<aiVector2D> textureCoords;
-        for (unsigned int i = 0; i < mesh->mNumVertices; ++i) {
-            aiVector3D texCoord = mesh->mTextureCoords[0][i]; // Assuming single texture channel (index 0)
-            textureCoords.push_back(aiVector2D(texCoord.x, texCoord.y));
+                glEnableVertexAttribArray(1);
+                glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+            }
+
+            // Process normals
+            if (part.normals) {
+                glGenBuffers(1, &buffer.nbo);
+                glBindBuffer(GL_ARRAY_BUFFER, buffer.nbo);
+                glBufferData(GL_ARRAY_BUFFER, part.vertexCount * 3 * sizeof(float), part.normals, GL_STATIC_DRAW);
+
+                glEnableVertexAttribArray(2);
+                glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+            }
         }
 
-        glGenBuffers(1, &buffer.tbo);
-        glBindBuffer(GL_ARRAY_BUFFER, buffer.tbo);
-        glBufferData(GL_ARRAY_BUFFER, textureCoords.size() * sizeof(aiVector2D), textureCoords.data(), GL_STATIC_DRAW);
+        // Upload the indices of all levels of detail into one buffer
+        if (!part.indices.empty()) {
+            buffer.ibo = uploadIndices(options, part.vertexCount, part.indices.data(), part.indices.size(),
+                                       buffer.indexType);
+        }
+        buffer.lods = part.lods;
+        gpuBytes += getBufferSize(buffer.vbo) + getBufferSize(buffer.tbo) + getBufferSize(buffer.nbo) +
+                    getBufferSize(buffer.ibo);
 
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+        buffers.push_back(buffer);
     }
 
+    // The part arrays point into the imported scene, the importer owning it moves along with the data
+    if (options.residency != Residency::GpuOnly)
+        cpuData.reset(new Data(std::move(data)));
+}
 
-    // Process normals
-    if (mesh->HasNormals()) {
-        std::vector<aiVector3D> normals;
-        for (unsigned int i = 0; i < mesh->mNumVertices; ++i) {
-            aiVector3D normal = mesh->mNormals[i];
-            normals.push_back(normal);
-        }
+const ppgso::Mesh_Assimp::Data *ppgso::Mesh_Assimp::getData() const {
+    return cpuData.get();
+}
 
-        glGenBuffers(1, &buffer.nbo);
-        glBindBuffer(GL_ARRAY_BUFFER, buffer.nbo);
-        glBufferData(GL_ARRAY_BUFFER, normals.size() * sizeof(aiVector3D), normals.data(), GL_STATIC_DRAW);
+ppgso::ResidentBytes ppgso::Mesh_Assimp::getResidentBytes() const {
+    ResidentBytes bytes;
+    bytes.gpu = gpuBytes;
+    if (cpuData) {
+        // Positions, texture coordinates and normals are 3 floats per vertex in the imported scene
+        for (auto &part : cpuData->parts)
+            bytes.cpu += ((part.positions ? 3 : 0) + (part.texcoords ? 3 : 0) + (part.normals ? 3 : 0)) *
+                         part.vertexCount * sizeof(float) + part.indices.size() * sizeof(unsigned int);
+    }
+    return bytes;
+}
 
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+void ppgso::Mesh_Assimp::render(unsigned int lod) {
+    for (auto &buffer : buffers) {
+        // Draw object
+        auto &range = buffer.lods[std::min<size_t>(lod, buffer.lods.size() - 1)];
+        StateCache::bindVertexArray(buffer.vao);
+        glDrawElements(GL_TRIANGLES, range.count, buffer.indexType, indexOffset(buffer.indexType, range));
     }
+}
+
+unsigned int ppgso::Mesh_Assimp::selectLod(float screenSize) const {
+    return ppgso::selectLod(options, screenSize);
+}
 
+float ppgso::Mesh_Assimp::getRadius() const {
+    return radius;
+}
 
-    // Process indices
-    if (mesh->HasFaces()) {
-        std::vector<unsigned int> indices;
-        for (unsigned int i = 0; i < mesh->mNumFaces; ++i) {
-            aiFace face = mesh->mFaces[i];
-            for (unsigned int j = 0; j < face.mNumIndices; ++j) {
-                indices.push_back(face.mIndices[j]);
-            }
-        }
+const ppgso::BoundingBox &ppgso::Mesh_Assimp::getBounds() const {
+    return bounds;
+}
 
-        // Upload indices to GPU
-        glGenBuffers(1, &buffer.ibo);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer.ibo);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
-        buffer.size = static_cast<GLsizei>(indices.size());
+const ppgso::BoundingSphere &ppgso::Mesh_Assimp::getBoundingSphere() const {
+    return sphere;
+}
+
+void ppgso::Mesh_Assimp::expandBounds(const float *positions, size_t vertex_count) {
+    for (size_t i = 0; i < vertex_count; ++i) {
+        glm::vec3 position{positions[i * 3], positions[i * 3 + 1], positions[i * 3 + 2]};
+        bounds.expand(position);
+        radius = std::max(radius, glm::length(position));
     }
+    if (bounds.empty()) return;
 
-    buffers.push_back(buffer);
+    // Centered on the box, use whichever of the half diagonal or the origin sphere is tighter
+    sphere.center = bounds.center();
+    sphere.radius = std::min(glm::length(bounds.max - sphere.center), radius + glm::length(sphere.center));
 }
 
-void ppgso::Mesh_Assimp::render() {
+void ppgso::Mesh_Assimp::setInstanceMatrices(GLuint buffer, GLuint location, size_t first) {
+    for (auto &gl_buffer : buffers) {
+        StateCache::bindVertexArray(gl_buffer.vao);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+
+        // A mat4 attribute takes up four vec4 locations, one per column
+        for (GLuint column = 0; column < 4; ++column) {
+            glEnableVertexAttribArray(location + column);
+            glVertexAttribPointer(location + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                                  reinterpret_cast<void *>(first * sizeof(glm::mat4) + column * sizeof(glm::vec4)));
+            glVertexAttribDivisor(location + column, 1);
+        }
+    }
+}
+
+void ppgso::Mesh_Assimp::setInstanceAttribute(GLuint buffer, GLuint location, GLint size, size_t first) {
+    for (auto &gl_buffer : buffers) {
+        StateCache::bindVertexArray(gl_buffer.vao);
+
+        // Without a buffer the shader reads the default attribute value instead
+        if (!buffer) {
+            glDisableVertexAttribArray(location);
+            continue;
+        }
+
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(location, size, GL_FLOAT, GL_FALSE, size * sizeof(float),
+                              reinterpret_cast<void *>(first * size * sizeof(float)));
+        glVertexAttribDivisor(location, 1);
+    }
+}
+
+void ppgso::Mesh_Assimp::renderInstanced(GLsizei instances, unsigned int lod) {
     for (auto &buffer : buffers) {
-        // Draw object
-        glBindVertexArray(buffer.vao);
-        glDrawElements(GL_TRIANGLES, buffer.size, GL_UNSIGNED_INT, nullptr);
+        // Draw all instances at once
+        auto &range = buffer.lods[std::min<size_t>(lod, buffer.lods.size() - 1)];
+        StateCache::bindVertexArray(buffer.vao);
+        glDrawElementsInstanced(GL_TRIANGLES, range.count, buffer.indexType, indexOffset(buffer.indexType, range),
+                                instances);
     }
 }
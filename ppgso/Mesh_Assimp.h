@@ -9,8 +9,10 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "bounds.h"
 #include "shader.h"
 #include "texture.h"
+#include "vertex_layout.h"
 
 // Edit by: Samuel Zaprazny
 // Adding assimp library
@@ -23,12 +25,22 @@ namespace ppgso {
     class Mesh_Assimp {
         struct gl_buffer {
         public:
-            GLuint vao, vbo, tbo, nbo, ibo = 0;
-            GLsizei size = 0;
+            GLuint vao = 0, vbo = 0, tbo = 0, nbo = 0, ibo = 0;
+            GLenum indexType = GL_UNSIGNED_INT;
+            std::vector<IndexRange> lods;  // Full detail first
         };
 
         std::vector<gl_buffer> buffers;
-        const aiScene * scene;
+        MeshOptions options;
+        float radius = 0.0f;
+        BoundingBox bounds;
+        BoundingSphere sphere;
+
+        // Grow the bounds by the positions of one part, 3 floats per vertex
+        void expandBounds(const float *positions, size_t vertex_count);
+
+        // Delete all GL objects of the mesh
+        void release();
 
         // Loaded materials
         std::vector<glm::vec3> ambient;
@@ -37,6 +49,44 @@ namespace ppgso {
 
     public:
 
+        /*!
+         * Geometry of a mesh prepared on the CPU and ready to be uploaded, see load.
+         */
+        struct Data {
+            // One part per imported mesh, the attribute arrays point into the imported scene
+            struct Part {
+                const float *positions = nullptr;
+                const float *texcoords = nullptr;  // 3 floats per vertex, the third is ignored
+                const float *normals = nullptr;
+                size_t vertexCount = 0;
+                std::vector<unsigned int> indices;  // Indices of all levels of detail
+                std::vector<IndexRange> lods;       // Full detail first
+            };
+
+            MeshOptions options;
+            std::vector<Part> parts;
+            std::unique_ptr<Assimp::Importer> importer;
+
+            // Loaded materials
+            std::vector<glm::vec3> ambient;
+            std::vector<glm::vec3> diffuse;
+            std::vector<glm::vec3> specular;
+        };
+
+        /*!
+         * Import, optimize and simplify a Wavefront .obj file without touching OpenGL, so it can run on any thread.
+         *
+         * @param obj - File path to the obj file to load.
+         * @param options - GPU storage formats of the geometry, see MeshOptions.
+         * @return - Geometry to pass to upload.
+         */
+        static Data load(const std::string &obj, const MeshOptions &options = {});
+
+        /*!
+         * Create an empty mesh that draws nothing until geometry is uploaded.
+         */
+        Mesh_Assimp() = default;
+
         /*!
          * Load 3D geometry from a na Wavefront .obj file.
          *
@@ -46,19 +96,107 @@ namespace ppgso {
          * vec3 Normal - Normal vector, position 2
          *
          * @param obj - File path to the obj file to load.
+         * @param options - GPU storage formats of the geometry, see MeshOptions.
          */
-        Mesh_Assimp(const std::string &obj);
+        Mesh_Assimp(const std::string &obj, const MeshOptions &options = {});
 
         ~Mesh_Assimp();
 
-        void processNode(aiNode *node, const aiScene *pScene);
+        /*!
+         * Create the OpenGL buffers from prepared geometry, replacing the previous geometry.
+         *
+         * @param data - Geometry returned by load.
+         */
+        void upload(Data &&data);
+
+        static void processNode(Data &data, aiNode *node, const aiScene *pScene);
 
-        void processMesh(aiMesh *mesh);
+        static void processMesh(Data &data, aiMesh *mesh);
+
+        /*!
+         * Get the geometry kept on the CPU, see MeshOptions::residency.
+         *
+         * @return - Geometry of the last upload, nullptr for Residency::GpuOnly meshes.
+         */
+        const Data *getData() const;
+
+        /*!
+         * Get the memory held by the mesh.
+         *
+         * @return - Bytes of the geometry kept on the CPU and of the OpenGL buffers.
+         */
+        ResidentBytes getResidentBytes() const;
 
         /*!
          * Render the geometry associated with the mesh using glDrawElements.
+         *
+         * @param lod - Level of detail to draw, clamped to the available levels.
          */
-        void render();
+        void render(unsigned int lod = 0);
+
+        /*!
+         * Select a level of detail for an object drawn with this mesh, see MeshOptions::lodRatios.
+         *
+         * @param screenSize - Projected diameter of the object as a fraction of the viewport height.
+         * @return - Level of detail to pass to render.
+         */
+        unsigned int selectLod(float screenSize) const;
+
+        /*!
+         * Get the distance of the farthest vertex from the mesh origin.
+         *
+         * @return - Radius of the bounding sphere centered at the origin.
+         */
+        float getRadius() const;
+
+        /*!
+         * Get the axis aligned bounds of all vertices in object space.
+         *
+         * @return - Bounding box of the mesh.
+         */
+        const BoundingBox &getBounds() const;
+
+        /*!
+         * Get a sphere enclosing all vertices in object space.
+         *
+         * @return - Bounding sphere of the mesh.
+         */
+        const BoundingSphere &getBoundingSphere() const;
+
+        /*!
+         * Attach a buffer of per-instance model matrices to the mesh.
+         *
+         * The matrices are bound as a mat4 attribute occupying four consecutive
+         * locations starting at "location", advanced once per instance.
+         *
+         * @param buffer - OpenGL buffer holding tightly packed glm::mat4 values.
+         * @param location - First attribute location of the mat4 shader input.
+         * @param first - Index of the matrix read by the first instance.
+         */
+        void setInstanceMatrices(GLuint buffer, GLuint location = 3, size_t first = 0);
+
+        /*!
+         * Attach a buffer of per-instance vectors to the mesh.
+         *
+         * @param buffer - OpenGL buffer holding tightly packed float vectors, 0 disables the attribute.
+         * @param location - Attribute location of the shader input.
+         * @param size - Number of float components per instance (1-4).
+         * @param first - Index of the vector read by the first instance.
+         */
+        void setInstanceAttribute(GLuint buffer, GLuint location, GLint size, size_t first = 0);
+
+        /*!
+         * Render multiple instances of the geometry using glDrawElementsInstanced.
+         *
+         * @param instances - Number of instances to draw.
+         * @param lod - Level of detail to draw, clamped to the available levels.
+         */
+        void renderInstanced(GLsizei instances, unsigned int lod = 0);
+
+    private:
+        // Geometry kept after the upload unless the mesh is GPU only
+        std::unique_ptr<Data> cpuData;
+        size_t gpuBytes = 0;
     };
 }
 
@@ -1,17 +1,75 @@
+#include <algorithm>
 #include <glm/glm.hpp>
 #include <sstream>
 
 #include "Mesh_Tiny.h"
+#include "mesh_cache.h"
+#include "mesh_optimizer.h"
+#include "state_cache.h"
+#include "hash.h"
 
-ppgso::Mesh_Tiny::Mesh_Tiny(const std::string &obj_file) {
+ppgso::Mesh_Tiny::Mesh_Tiny(const std::string &obj_file, const MeshOptions &options) {
 #ifdef DEBBUG_MODE
     std::cout << "Using Tiny Obj Loader!" << std::endl;
 #endif
+  upload(load(obj_file, options));
+}
+
+// Add one shape to the prepared data, levels of detail are simplified here so upload only copies
+static void addPart(ppgso::Mesh_Tiny::Data &data, const float *positions, size_t position_count,
+                    const float *texcoords, size_t texcoord_count, const float *normals, size_t normal_count,
+                    const unsigned int *indices, size_t index_count) {
+  ppgso::Mesh_Tiny::Data::Part part;
+  part.positions = positions;
+  part.positionCount = position_count;
+  part.texcoords = texcoords;
+  part.texcoordCount = texcoord_count;
+  part.normals = normals;
+  part.normalCount = normal_count;
+
+  // Without levels of detail the indices are uploaded straight from the shape or the mapped cache
+  if (data.options.lodRatios.empty()) {
+    part.indices = indices;
+    part.indexCount = index_count;
+    part.lods.assign(1, ppgso::IndexRange{(GLsizei) index_count, 0});
+  } else {
+    ppgso::buildLodIndices(data.options, positions, position_count / 3, indices, index_count, part.lodIndices,
+                           part.lods);
+    part.indices = part.lodIndices.data();
+    part.indexCount = part.lodIndices.size();
+  }
+  data.parts.push_back(std::move(part));
+}
+
+ppgso::Mesh_Tiny::Data ppgso::Mesh_Tiny::load(const std::string &obj_file, const MeshOptions &options) {
+  Data data;
+  data.options = options;
+
+  // The cache is only valid for the exact contents of the .obj file
+  uint64_t source_hash = 0;
+  auto use_cache = MeshCache::enabled();
+  if (use_cache) {
+    MappedFile source{obj_file};
+    use_cache = source.valid();
+    if (use_cache)
+      source_hash = hashData(source.data(), source.size());
+  }
+
+  // Use the arrays straight from the mapped cache file
+  if (use_cache) {
+    std::unique_ptr<MeshCache> cache{new MeshCache{MeshCache::path(obj_file), source_hash}};
+    if (cache->valid() && (cache->optimized || !options.optimize)) {
+      for(auto& shape : cache->getShapes())
+        addPart(data, shape.positions, shape.positionCount, shape.texcoords, shape.texcoordCount,
+                shape.normals, shape.normalCount, shape.indices, shape.indexCount);
+      data.cache = std::move(cache);
+      return data;
+    }
+  }
 
   // Load OBJ file
-  shapes.clear();
-  materials.clear();
-  std::string err = tinyobj::LoadObj(shapes, materials, obj_file.c_str());
+  std::vector<tinyobj::material_t> materials;
+  std::string err = tinyobj::LoadObj(data.shapes, materials, obj_file.c_str());
 
   if (!err.empty()) {
     std::stringstream msg;
@@ -19,73 +77,229 @@ ppgso::Mesh_Tiny::Mesh_Tiny(const std::string &obj_file) {
     throw std::runtime_error(msg.str());
   }
 
-  // Initialize OpenGL Buffers
-  for(auto& shape : shapes) {
+  for(auto& shape : data.shapes) {
+    if(options.optimize)
+      optimizeShape(shape, obj_file);
+    addPart(data, shape.mesh.positions.data(), shape.mesh.positions.size(), shape.mesh.texcoords.data(),
+            shape.mesh.texcoords.size(), shape.mesh.normals.data(), shape.mesh.normals.size(),
+            shape.mesh.indices.data(), shape.mesh.indices.size());
+  }
+
+  if (use_cache)
+    MeshCache::write(MeshCache::path(obj_file), source_hash, data.shapes, options.optimize);
+  return data;
+}
+
+void ppgso::Mesh_Tiny::optimizeShape(tinyobj::shape_t &shape, const std::string &obj_file) {
+  auto &mesh = shape.mesh;
+  auto vertex_count = mesh.positions.size() / 3;
+  if(mesh.indices.empty())
+    return;
+
+  // The greedy reordering can lose on meshes already in a good order, keep the original then
+  auto original = mesh.indices;
+  auto before = mesh_optimizer::computeACMR(mesh.indices.data(), mesh.indices.size(), vertex_count);
+  mesh_optimizer::optimizeVertexCache(mesh.indices.data(), mesh.indices.size(), vertex_count);
+  auto after = mesh_optimizer::computeACMR(mesh.indices.data(), mesh.indices.size(), vertex_count);
+  auto kept = after >= before;
+  if(kept)
+    mesh.indices = std::move(original);
+
+  // Attributes not covering every vertex are left alone, uploadShape skips them anyway
+  auto remap = mesh_optimizer::optimizeVertexFetch(mesh.indices.data(), mesh.indices.size(), vertex_count);
+  mesh_optimizer::remapVertices(mesh.positions.data(), 3, remap);
+  if(mesh.texcoords.size() == vertex_count * 2) mesh_optimizer::remapVertices(mesh.texcoords.data(), 2, remap);
+  if(mesh.normals.size() == vertex_count * 3) mesh_optimizer::remapVertices(mesh.normals.data(), 3, remap);
+
+  std::cout << "Optimized " << obj_file << (shape.name.empty() ? "" : ":") << shape.name
+            << ": ACMR " << before << " -> " << after << (kept ? ", kept the original order" : "") << std::endl;
+}
+
+void ppgso::Mesh_Tiny::upload(Data &&data) {
+  release();
+  options = data.options;
+
+  for(auto& part : data.parts) {
+    expandBounds(part.positions, part.positionCount / 3);
+    if(options.residency == Residency::CpuOnly)
+      continue;
+
     gl_buffer buffer;
 
-    if(!shape.mesh.positions.empty()) {
-      // Generate a vertex array object
-      glGenVertexArrays(1, &buffer.vao);
-      glBindVertexArray(buffer.vao);
+    // Generate a vertex array object
+    glGenVertexArrays(1, &buffer.vao);
+    StateCache::bindVertexArray(buffer.vao);
 
-      // Generate and upload a buffer with vertex positions to GPU
-      glGenBuffers(1, &buffer.vbo);
-      glBindBuffer(GL_ARRAY_BUFFER, buffer.vbo);
-      glBufferData(GL_ARRAY_BUFFER, shape.mesh.positions.size() * sizeof(float), shape.mesh.positions.data(),
-                   GL_STATIC_DRAW);
+    if(options.interleaved || options.halfTexCoords || options.packedNormals) {
+      // Single buffer with all attributes, skip attributes that do not cover every vertex
+      VertexSource source;
+      source.count = part.positionCount / 3;
+      source.positions = part.positions;
+      if(part.texcoordCount == source.count * 2) source.texcoords = part.texcoords;
+      if(part.normalCount == source.count * 3) source.normals = part.normals;
+      buffer.vbo = uploadInterleavedVertices(options, source);
+    } else {
+      if(part.positionCount) {
+        // Generate and upload a buffer with vertex positions to GPU
+        glGenBuffers(1, &buffer.vbo);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer.vbo);
+        glBufferData(GL_ARRAY_BUFFER, part.positionCount * sizeof(float), part.positions, GL_STATIC_DRAW);
 
-      // Bind the buffer to "Position" attribute in program
-      glEnableVertexAttribArray(0);
-      glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
-    }
+        // Bind the buffer to "Position" attribute in program
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+      }
 
-    if(!shape.mesh.texcoords.empty()) {
-      // Generate and upload a buffer with texture coordinates to GPU
-      glGenBuffers(1, &buffer.tbo);
-      glBindBuffer(GL_ARRAY_BUFFER, buffer.tbo);
-      glBufferData(GL_ARRAY_BUFFER, shape.mesh.texcoords.size() * sizeof(float), shape.mesh.texcoords.data(),
-                   GL_STATIC_DRAW);
+      if(part.texcoordCount) {
+        // Generate and upload a buffer with texture coordinates to GPU
+        glGenBuffers(1, &buffer.tbo);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer.tbo);
+        glBufferData(GL_ARRAY_BUFFER, part.texcoordCount * sizeof(float), part.texcoords, GL_STATIC_DRAW);
 
-      glEnableVertexAttribArray(1);
-      glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
-    }
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+      }
 
-    if(!shape.mesh.normals.empty()) {
-      // Generate and upload a buffer with texture coordinates to GPU
-      glGenBuffers(1, &buffer.nbo);
-      glBindBuffer(GL_ARRAY_BUFFER, buffer.nbo);
-      glBufferData(GL_ARRAY_BUFFER, shape.mesh.normals.size() * sizeof(float), shape.mesh.normals.data(),
-                   GL_STATIC_DRAW);
+      if(part.normalCount) {
+        // Generate and upload a buffer with texture coordinates to GPU
+        glGenBuffers(1, &buffer.nbo);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer.nbo);
+        glBufferData(GL_ARRAY_BUFFER, part.normalCount * sizeof(float), part.normals, GL_STATIC_DRAW);
 
-      glEnableVertexAttribArray(2);
-      glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+      }
     }
 
-    // Generate and upload a buffer with indices to GPU
-    glGenBuffers(1, &buffer.ibo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer.ibo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, shape.mesh.indices.size() * sizeof(unsigned int), shape.mesh.indices.data(), GL_STATIC_DRAW);
-    buffer.size = (GLsizei) shape.mesh.indices.size();
+    // Upload the indices of all levels of detail into one buffer
+    buffer.ibo = uploadIndices(options, part.positionCount / 3, part.indices, part.indexCount, buffer.indexType);
+    buffer.lods = part.lods;
+    gpuBytes += getBufferSize(buffer.vbo) + getBufferSize(buffer.tbo) + getBufferSize(buffer.nbo) +
+                getBufferSize(buffer.ibo);
 
     // Copy it to the end of the buffers vector
     buffers.push_back(buffer);
   }
+
+  // The part arrays point into the shapes or the mapped cache, both move along with the data
+  if(options.residency != Residency::GpuOnly)
+    cpuData.reset(new Data(std::move(data)));
 }
 
 ppgso::Mesh_Tiny::~Mesh_Tiny() {
+  release();
+}
+
+void ppgso::Mesh_Tiny::release() {
   for(auto& buffer : buffers) {
     glDeleteBuffers(1, &buffer.ibo);
     glDeleteBuffers(1, &buffer.nbo);
     glDeleteBuffers(1, &buffer.tbo);
     glDeleteBuffers(1, &buffer.vbo);
+    StateCache::forgetVertexArray(buffer.vao);
     glDeleteVertexArrays(1, &buffer.vao);
   }
+  buffers.clear();
+  cpuData.reset();
+  gpuBytes = 0;
+  bounds = BoundingBox{};
+  sphere = BoundingSphere{};
+  radius = 0.0f;
 }
 
-void ppgso::Mesh_Tiny::render() {
+void ppgso::Mesh_Tiny::render(unsigned int lod) {
   for(auto& buffer : buffers) {
     // Draw object
-    glBindVertexArray(buffer.vao);
-    glDrawElements(GL_TRIANGLES, buffer.size, GL_UNSIGNED_INT, nullptr);
+    auto& range = buffer.lods[std::min<size_t>(lod, buffer.lods.size() - 1)];
+    StateCache::bindVertexArray(buffer.vao);
+    glDrawElements(GL_TRIANGLES, range.count, buffer.indexType, indexOffset(buffer.indexType, range));
+  }
+}
+
+unsigned int ppgso::Mesh_Tiny::selectLod(float screenSize) const {
+  return ppgso::selectLod(options, screenSize);
+}
+
+const ppgso::Mesh_Tiny::Data *ppgso::Mesh_Tiny::getData() const {
+  return cpuData.get();
+}
+
+ppgso::ResidentBytes ppgso::Mesh_Tiny::getResidentBytes() const {
+  ResidentBytes bytes;
+  bytes.gpu = gpuBytes;
+  if(cpuData) {
+    for(auto& part : cpuData->parts)
+      bytes.cpu += (part.positionCount + part.texcoordCount + part.normalCount) * sizeof(float) +
+                   part.indexCount * sizeof(unsigned int);
+  }
+  return bytes;
+}
+
+float ppgso::Mesh_Tiny::getRadius() const {
+  return radius;
+}
+
+const ppgso::BoundingBox &ppgso::Mesh_Tiny::getBounds() const {
+  return bounds;
+}
+
+const ppgso::BoundingSphere &ppgso::Mesh_Tiny::getBoundingSphere() const {
+  return sphere;
+}
+
+void ppgso::Mesh_Tiny::expandBounds(const float *positions, size_t vertex_count) {
+  for(size_t i = 0; i < vertex_count; i++) {
+    glm::vec3 position{positions[i * 3], positions[i * 3 + 1], positions[i * 3 + 2]};
+    bounds.expand(position);
+    radius = std::max(radius, glm::length(position));
+  }
+  if(bounds.empty())
+    return;
+
+  // Centered on the box, use whichever of the half diagonal or the origin sphere is tighter
+  sphere.center = bounds.center();
+  sphere.radius = std::min(glm::length(bounds.max - sphere.center), radius + glm::length(sphere.center));
+}
+
+void ppgso::Mesh_Tiny::setInstanceMatrices(GLuint buffer, GLuint location, size_t first) {
+  for(auto& gl_buffer : buffers) {
+    StateCache::bindVertexArray(gl_buffer.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+
+    // A mat4 attribute takes up four vec4 locations, one per column
+    for(GLuint column = 0; column < 4; column++) {
+      glEnableVertexAttribArray(location + column);
+      glVertexAttribPointer(location + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                            reinterpret_cast<void *>(first * sizeof(glm::mat4) + column * sizeof(glm::vec4)));
+      glVertexAttribDivisor(location + column, 1);
+    }
+  }
+}
+
+void ppgso::Mesh_Tiny::setInstanceAttribute(GLuint buffer, GLuint location, GLint size, size_t first) {
+  for(auto& gl_buffer : buffers) {
+    StateCache::bindVertexArray(gl_buffer.vao);
+
+    // Without a buffer the shader reads the default attribute value instead
+    if(!buffer) {
+      glDisableVertexAttribArray(location);
+      continue;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glEnableVertexAttribArray(location);
+    glVertexAttribPointer(location, size, GL_FLOAT, GL_FALSE, size * sizeof(float),
+                          reinterpret_cast<void *>(first * size * sizeof(float)));
+    glVertexAttribDivisor(location, 1);
+  }
+}
+
+void ppgso::Mesh_Tiny::renderInstanced(GLsizei instances, unsigned int lod) {
+  for(auto& buffer : buffers) {
+    // Draw all instances at once
+    auto& range = buffer.lods[std::min<size_t>(lod, buffer.lods.size() - 1)];
+    StateCache::bindVertexArray(buffer.vao);
+    glDrawElementsInstanced(GL_TRIANGLES, range.count, buffer.indexType, indexOffset(buffer.indexType, range),
+                            instances);
   }
 }
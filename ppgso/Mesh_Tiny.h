@@ -9,24 +9,77 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "bounds.h"
+#include "mesh_cache.h"
 #include "shader.h"
 #include "texture.h"
 #include "tiny_obj_loader.h"
+#include "vertex_layout.h"
 
 namespace ppgso {
 
   class Mesh_Tiny {
     struct gl_buffer {
     public:
-      GLuint vao, vbo, tbo, nbo, ibo = 0;
-      GLsizei size = 0;
+      GLuint vao = 0, vbo = 0, tbo = 0, nbo = 0, ibo = 0;
+      GLenum indexType = GL_UNSIGNED_INT;
+      std::vector<IndexRange> lods;  // Full detail first
     };
-    std::vector<tinyobj::shape_t> shapes;
-    std::vector<tinyobj::material_t> materials;
     std::vector<gl_buffer> buffers;
+    MeshOptions options;
+    float radius = 0.0f;
+    BoundingBox bounds;
+    BoundingSphere sphere;
+
+    // Grow the bounds by the positions of one part, 3 floats per vertex
+    void expandBounds(const float *positions, size_t vertex_count);
+
+    // Reorder the triangles and vertices of a parsed shape for the vertex cache and report the ACMR change
+    static void optimizeShape(tinyobj::shape_t &shape, const std::string &obj_file);
+
+    // Delete all GL objects of the mesh
+    void release();
 
   public:
 
+    /*!
+     * Geometry of a mesh prepared on the CPU and ready to be uploaded, see load.
+     */
+    struct Data {
+      // One part per shape, the attribute arrays point into the parsed shapes or the mapped cache
+      struct Part {
+        const float *positions = nullptr;
+        const float *texcoords = nullptr;
+        const float *normals = nullptr;
+        size_t positionCount = 0;  // Number of floats
+        size_t texcoordCount = 0;  // Number of floats
+        size_t normalCount = 0;    // Number of floats
+        const unsigned int *indices = nullptr;  // Indices of all levels of detail
+        size_t indexCount = 0;
+        std::vector<IndexRange> lods;           // Full detail first
+        std::vector<unsigned int> lodIndices;   // Storage of indices, only used when levels are generated
+      };
+
+      MeshOptions options;
+      std::vector<Part> parts;
+      std::vector<tinyobj::shape_t> shapes;
+      std::unique_ptr<MeshCache> cache;
+    };
+
+    /*!
+     * Parse, optimize and simplify a Wavefront .obj file without touching OpenGL, so it can run on any thread.
+     *
+     * @param obj - File path to the obj file to load.
+     * @param options - GPU storage formats of the geometry, see MeshOptions.
+     * @return - Geometry to pass to upload.
+     */
+    static Data load(const std::string &obj, const MeshOptions &options = {});
+
+    /*!
+     * Create an empty mesh that draws nothing until geometry is uploaded.
+     */
+    Mesh_Tiny() = default;
+
     /*!
      * Load 3D geometry from a na Wavefront .obj file.
      *
@@ -35,16 +88,108 @@ namespace ppgso {
      * vec2 TexCoord - Texture coordinate, position 1
      * vec3 Normal - Normal vector, position 2
      *
+     * The parsed geometry is stored in a MeshCache next to the file and later loads
+     * upload directly from the memory mapped cache while the .obj contents are unchanged.
+     * With MeshOptions::optimize the cached geometry is stored already optimized.
+     *
      * @param obj - File path to the obj file to load.
+     * @param options - GPU storage formats of the geometry, see MeshOptions.
      */
-    Mesh_Tiny(const std::string &obj);
+    Mesh_Tiny(const std::string &obj, const MeshOptions &options = {});
 
     ~Mesh_Tiny();
 
+    /*!
+     * Create the OpenGL buffers from prepared geometry, replacing the previous geometry.
+     *
+     * @param data - Geometry returned by load.
+     */
+    void upload(Data &&data);
+
+    /*!
+     * Get the geometry kept on the CPU, see MeshOptions::residency.
+     *
+     * @return - Geometry of the last upload, nullptr for Residency::GpuOnly meshes.
+     */
+    const Data *getData() const;
+
+    /*!
+     * Get the memory held by the mesh.
+     *
+     * @return - Bytes of the geometry kept on the CPU and of the OpenGL buffers.
+     */
+    ResidentBytes getResidentBytes() const;
+
     /*!
      * Render the geometry associated with the mesh using glDrawElements.
+     *
+     * @param lod - Level of detail to draw, clamped to the available levels.
      */
-    void render();
+    void render(unsigned int lod = 0);
+
+    /*!
+     * Select a level of detail for an object drawn with this mesh, see MeshOptions::lodRatios.
+     *
+     * @param screenSize - Projected diameter of the object as a fraction of the viewport height.
+     * @return - Level of detail to pass to render.
+     */
+    unsigned int selectLod(float screenSize) const;
+
+    /*!
+     * Get the distance of the farthest vertex from the mesh origin.
+     *
+     * @return - Radius of the bounding sphere centered at the origin.
+     */
+    float getRadius() const;
+
+    /*!
+     * Get the axis aligned bounds of all vertices in object space.
+     *
+     * @return - Bounding box of the mesh.
+     */
+    const BoundingBox &getBounds() const;
+
+    /*!
+     * Get a sphere enclosing all vertices in object space.
+     *
+     * @return - Bounding sphere of the mesh.
+     */
+    const BoundingSphere &getBoundingSphere() const;
+
+    /*!
+     * Attach a buffer of per-instance model matrices to the mesh.
+     *
+     * The matrices are bound as a mat4 attribute occupying four consecutive
+     * locations starting at "location", advanced once per instance.
+     *
+     * @param buffer - OpenGL buffer holding tightly packed glm::mat4 values.
+     * @param location - First attribute location of the mat4 shader input.
+     * @param first - Index of the matrix read by the first instance.
+     */
+    void setInstanceMatrices(GLuint buffer, GLuint location = 3, size_t first = 0);
+
+    /*!
+     * Attach a buffer of per-instance vectors to the mesh.
+     *
+     * @param buffer - OpenGL buffer holding tightly packed float vectors, 0 disables the attribute.
+     * @param location - Attribute location of the shader input.
+     * @param size - Number of float components per instance (1-4).
+     * @param first - Index of the vector read by the first instance.
+     */
+    void setInstanceAttribute(GLuint buffer, GLuint location, GLint size, size_t first = 0);
+
+    /*!
+     * Render multiple instances of the geometry using glDrawElementsInstanced.
+     *
+     * @param instances - Number of instances to draw.
+     * @param lod - Level of detail to draw, clamped to the available levels.
+     */
+    void renderInstanced(GLsizei instances, unsigned int lod = 0);
+
+  private:
+    // Geometry kept after the upload unless the mesh is GPU only
+    std::unique_ptr<Data> cpuData;
+    size_t gpuBytes = 0;
   };
 }
 
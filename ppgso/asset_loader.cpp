@@ -0,0 +1,109 @@
+#include <chrono>
+
+#include "asset_loader.h"
+#include "resource_cache.h"
+
+ppgso::AssetLoader::AssetLoader() {
+  // Start the pool first so a static loader is destroyed before it
+  JobSystem::shared();
+}
+
+ppgso::AssetLoader::~AssetLoader() {
+  JobSystem::shared().wait(loading);
+}
+
+ppgso::AssetLoader &ppgso::AssetLoader::shared() {
+  static AssetLoader loader;
+  return loader;
+}
+
+std::shared_ptr<ppgso::AssetLoader::Mesh> ppgso::AssetLoader::loadMesh(const std::string &obj, const MeshOptions &options) {
+  // Files already loaded or loading are shared through the resource cache
+  return ResourceCache::getMesh(obj, options, [&] {
+    auto mesh = std::make_shared<Mesh>();
+    std::weak_ptr<Mesh> target = mesh;
+
+    start([obj, options, target]() -> Upload {
+      // std::function needs a copyable closure, the data itself is only moved once
+      auto data = std::make_shared<Mesh::Data>(Mesh::load(obj, options));
+      return [target, data] {
+        if (auto mesh = target.lock())
+          mesh->upload(std::move(*data));
+      };
+    });
+    return mesh;
+  });
+}
+
+std::shared_ptr<ppgso::Texture> ppgso::AssetLoader::loadTexture(const std::string &bmp, const TextureOptions &options) {
+  return ResourceCache::getTexture(bmp, options, [&] {
+    auto texture = std::make_shared<Texture>();
+    std::weak_ptr<Texture> target = texture;
+
+    start([bmp, options, target]() -> Upload {
+      auto data = std::make_shared<Texture::Data>(Texture::load(bmp, options));
+      return [target, data] {
+        if (auto texture = target.lock())
+          texture->upload(std::move(*data));
+      };
+    });
+    return texture;
+  });
+}
+
+void ppgso::AssetLoader::start(std::function<Upload()> load) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    pending++;
+  }
+
+  // Loads can take long, as background jobs they never hold up a wait of the frame
+  JobSystem::shared().runBackground([this, load] {
+    Upload upload;
+    try {
+      upload = load();
+    } catch (...) {
+      // Report the failure where the asset would have been uploaded
+      auto error = std::current_exception();
+      upload = [error] { std::rethrow_exception(error); };
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    uploads.push_back(std::move(upload));
+  }, &loading);
+}
+
+bool ppgso::AssetLoader::update(double budget) {
+  using Clock = std::chrono::steady_clock;
+  auto start = Clock::now();
+  bool uploaded = false;
+
+  while (true) {
+    Upload upload;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (uploads.empty())
+        break;
+      upload = std::move(uploads.front());
+      uploads.erase(uploads.begin());
+      pending--;
+    }
+
+    upload();
+    uploaded = true;
+
+    if (std::chrono::duration<double>(Clock::now() - start).count() >= budget)
+      break;
+  }
+  return uploaded;
+}
+
+void ppgso::AssetLoader::finish() {
+  JobSystem::shared().wait(loading);
+  while (update(1e9)) {}
+}
+
+size_t ppgso::AssetLoader::getPending() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return pending;
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "job_system.h"
+#include "texture.h"
+#include "vertex_layout.h"
+
+#ifdef USE_ASSIMP
+  #include "Mesh_Assimp.h"
+#else
+  #include "Mesh_Tiny.h"
+#endif
+
+namespace ppgso {
+
+  /*!
+   * Loads meshes and textures on the shared job system while the main thread keeps rendering.
+   *
+   * Requests return an empty placeholder right away. Parsing, optimization, LOD simplification,
+   * image decoding and mip generation run as background jobs on worker threads, the finished data waits in a queue and update
+   * creates the OpenGL objects on the main thread within a time budget per frame. Placeholders
+   * draw nothing until their data is uploaded. Requests go through the ResourceCache, so a file
+   * still alive or loading is shared instead of loaded again. All methods must be called from
+   * the thread owning the OpenGL context.
+   */
+  class AssetLoader {
+  public:
+#ifdef USE_ASSIMP
+    using Mesh = Mesh_Assimp;
+#else
+    using Mesh = Mesh_Tiny;
+#endif
+
+    /*!
+     * Create a loader running its jobs on the background queue of JobSystem::shared.
+     */
+    AssetLoader();
+
+    /*!
+     * Wait for all pending loads, the jobs reference the loader.
+     */
+    ~AssetLoader();
+
+    AssetLoader(const AssetLoader &) = delete;
+    AssetLoader &operator=(const AssetLoader &) = delete;
+
+    /*!
+     * Get the loader shared by the whole application.
+     *
+     * @return - Shared asset loader.
+     */
+    static AssetLoader &shared();
+
+    /*!
+     * Start loading a Wavefront .obj file unless the ResourceCache already holds it.
+     *
+     * @param obj - File path to the obj file to load.
+     * @param options - GPU storage formats of the geometry, see MeshOptions.
+     * @return - Shared mesh, empty until filled in by a later update.
+     */
+    std::shared_ptr<Mesh> loadMesh(const std::string &obj, const MeshOptions &options = {});
+
+    /*!
+     * Start loading a BMP image into a texture unless the ResourceCache already holds it.
+     *
+     * @param bmp - File path to a BMP image.
+     * @param options - Storage format, see TextureOptions.
+     * @return - Shared texture, without storage until filled in by a later update.
+     */
+    std::shared_ptr<Texture> loadTexture(const std::string &bmp, const TextureOptions &options = {});
+
+    /*!
+     * Upload finished assets until the budget is spent, at least one per call. Errors of the
+     * loading jobs are rethrown here.
+     *
+     * @param budget - Time in seconds the uploads may take.
+     * @return - True when any asset was uploaded.
+     */
+    bool update(double budget);
+
+    /*!
+     * Wait for all pending loads and upload them.
+     */
+    void finish();
+
+    /*!
+     * Get the number of assets not uploaded yet.
+     *
+     * @return - Number of requests still loading or waiting for upload.
+     */
+    size_t getPending() const;
+
+  private:
+    using Upload = std::function<void()>;
+
+    JobSystem::Counter loading;
+    mutable std::mutex mutex;
+    std::vector<Upload> uploads;
+    size_t pending = 0;
+
+    // Queue a load job, its result is an upload run on the main thread
+    void start(std::function<Upload()> load);
+  };
+}
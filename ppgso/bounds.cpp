@@ -0,0 +1,91 @@
+#include "bounds.h"
+
+void ppgso::BoundingBox::expand(const glm::vec3 &point) {
+  min = glm::min(min, point);
+  max = glm::max(max, point);
+}
+
+void ppgso::BoundingBox::expand(const BoundingBox &box) {
+  if (box.empty())
+    return;
+  expand(box.min);
+  expand(box.max);
+}
+
+bool ppgso::BoundingBox::empty() const {
+  return min.x > max.x;
+}
+
+glm::vec3 ppgso::BoundingBox::center() const {
+  return (min + max) * 0.5f;
+}
+
+ppgso::BoundingBox ppgso::BoundingBox::transform(const glm::mat4 &matrix) const {
+  if (empty())
+    return *this;
+
+  // Arvo's method, each matrix element contributes its smaller/larger product to the new bounds
+  BoundingBox result;
+  result.min = result.max = glm::vec3{matrix[3]};
+  for (int column = 0; column < 3; column++) {
+    for (int row = 0; row < 3; row++) {
+      auto a = matrix[column][row] * min[column];
+      auto b = matrix[column][row] * max[column];
+      result.min[row] += glm::min(a, b);
+      result.max[row] += glm::max(a, b);
+    }
+  }
+  return result;
+}
+
+ppgso::BoundingSphere ppgso::BoundingSphere::transform(const glm::mat4 &matrix) const {
+  auto scale = glm::max(glm::length(glm::vec3{matrix[0]}),
+                        glm::max(glm::length(glm::vec3{matrix[1]}), glm::length(glm::vec3{matrix[2]})));
+  return {glm::vec3{matrix * glm::vec4{center, 1.0f}}, radius * scale};
+}
+
+ppgso::Frustum::Frustum(const glm::mat4 &viewProjection) {
+  // Rows of the matrix, GLM stores columns
+  auto transposed = glm::transpose(viewProjection);
+  planes[0] = transposed[3] + transposed[0];  // Left
+  planes[1] = transposed[3] - transposed[0];  // Right
+  planes[2] = transposed[3] + transposed[1];  // Bottom
+  planes[3] = transposed[3] - transposed[1];  // Top
+  planes[4] = transposed[3] + transposed[2];  // Near
+  planes[5] = transposed[3] - transposed[2];  // Far
+
+  // Normalize so plane distances are in world units for sphere tests
+  for (auto &plane : planes)
+    plane /= glm::length(glm::vec3{plane});
+}
+
+bool ppgso::Frustum::intersects(const BoundingSphere &sphere) const {
+  for (auto &plane : planes)
+    if (glm::dot(glm::vec3{plane}, sphere.center) + plane.w < -sphere.radius)
+      return false;
+  return true;
+}
+
+bool ppgso::Frustum::intersects(const BoundingBox &box) const {
+  for (auto &plane : planes) {
+    // Test the corner farthest along the plane normal
+    glm::vec3 corner{plane.x >= 0.0f ? box.max.x : box.min.x,
+                     plane.y >= 0.0f ? box.max.y : box.min.y,
+                     plane.z >= 0.0f ? box.max.z : box.min.z};
+    if (glm::dot(glm::vec3{plane}, corner) + plane.w < 0.0f)
+      return false;
+  }
+  return true;
+}
+
+bool ppgso::Frustum::contains(const BoundingBox &box) const {
+  for (auto &plane : planes) {
+    // Test the corner farthest against the plane normal
+    glm::vec3 corner{plane.x >= 0.0f ? box.min.x : box.max.x,
+                     plane.y >= 0.0f ? box.min.y : box.max.y,
+                     plane.z >= 0.0f ? box.min.z : box.max.z};
+    if (glm::dot(glm::vec3{plane}, corner) + plane.w < 0.0f)
+      return false;
+  }
+  return true;
+}
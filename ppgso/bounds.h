@@ -0,0 +1,108 @@
+#pragma once
+#include <limits>
+
+#include <glm/glm.hpp>
+
+namespace ppgso {
+
+  /*!
+   * Axis aligned bounding box, empty until the first point is added.
+   */
+  struct BoundingBox {
+    glm::vec3 min{std::numeric_limits<float>::max()};
+    glm::vec3 max{std::numeric_limits<float>::lowest()};
+
+    /*!
+     * Grow the box to contain a point.
+     *
+     * @param point - Point to include.
+     */
+    void expand(const glm::vec3 &point);
+
+    /*!
+     * Grow the box to contain another box.
+     *
+     * @param box - Box to include, ignored when empty.
+     */
+    void expand(const BoundingBox &box);
+
+    /*!
+     * Check if nothing was added to the box.
+     *
+     * @return - True for an empty box.
+     */
+    bool empty() const;
+
+    // Center point of the box
+    glm::vec3 center() const;
+
+    /*!
+     * Get the box enclosing this box after a transformation.
+     *
+     * @param matrix - Affine transformation, typically a model matrix.
+     * @return - Axis aligned box in the transformed space.
+     */
+    BoundingBox transform(const glm::mat4 &matrix) const;
+  };
+
+  /*!
+   * Bounding sphere.
+   */
+  struct BoundingSphere {
+    glm::vec3 center{0.0f};
+    float radius = 0.0f;
+
+    /*!
+     * Get a sphere enclosing this sphere after a transformation.
+     *
+     * @param matrix - Affine transformation, the radius is scaled by its largest axis.
+     * @return - Sphere in the transformed space.
+     */
+    BoundingSphere transform(const glm::mat4 &matrix) const;
+  };
+
+  /*!
+   * View frustum as six inward facing planes, used to skip objects outside of the view.
+   */
+  class Frustum {
+  public:
+    Frustum() = default;
+
+    /*!
+     * Extract the frustum planes from a combined matrix (Gribb-Hartmann).
+     *
+     * @param viewProjection - Projection matrix multiplied by the view matrix, planes are in world space.
+     *                         With projection only the planes are in view space.
+     */
+    explicit Frustum(const glm::mat4 &viewProjection);
+
+    /*!
+     * Check if a sphere is at least partially inside the frustum.
+     *
+     * @param sphere - Sphere in the space of the frustum.
+     * @return - False only if the sphere is completely outside.
+     */
+    bool intersects(const BoundingSphere &sphere) const;
+
+    /*!
+     * Check if a box is at least partially inside the frustum.
+     * Boxes near frustum corners may be reported visible although they are outside.
+     *
+     * @param box - Box in the space of the frustum.
+     * @return - False only if the box is completely outside.
+     */
+    bool intersects(const BoundingBox &box) const;
+
+    /*!
+     * Check if a box is completely inside the frustum.
+     *
+     * @param box - Box in the space of the frustum.
+     * @return - True if every corner of the box is inside.
+     */
+    bool contains(const BoundingBox &box) const;
+
+  private:
+    // Plane equations, dot(plane, vec4(point, 1)) >= 0 inside, everything passes by default
+    glm::vec4 planes[6]{};
+  };
+}
@@ -0,0 +1,236 @@
+#include <algorithm>
+
+#include "bvh.h"
+
+// Number of candidate split positions per node
+static const int BinCount = 12;
+// Nodes with this many items or less are never split
+static const uint32_t LeafSize = 2;
+// Traversal stack size, the build stops splitting at a depth where the stack could overflow
+static const int StackSize = 64;
+static const uint32_t MaxDepth = StackSize - 2;
+
+static float surfaceArea(const ppgso::BoundingBox &box) {
+  if (box.empty())
+    return 0.0f;
+  auto size = box.max - box.min;
+  return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+void ppgso::Bvh::build(const std::vector<BoundingBox> &bounds) {
+  nodes.clear();
+  items.resize(bounds.size());
+  for (size_t i = 0; i < items.size(); i++)
+    items[i] = (unsigned int) i;
+  if (bounds.empty())
+    return;
+
+  std::vector<glm::vec3> centroids(bounds.size());
+  for (size_t i = 0; i < bounds.size(); i++)
+    centroids[i] = bounds[i].center();
+
+  nodes.reserve(bounds.size() * 2);
+  buildNode(bounds, centroids, 0, (uint32_t) bounds.size(), 0);
+
+  // Copy of the boxes in tree order for the leaf tests
+  itemBounds.resize(items.size());
+  for (size_t i = 0; i < items.size(); i++)
+    itemBounds[i] = bounds[items[i]];
+}
+
+uint32_t ppgso::Bvh::buildNode(const std::vector<BoundingBox> &bounds, const std::vector<glm::vec3> &centroids,
+                               uint32_t first, uint32_t count, uint32_t depth) {
+  auto index = (uint32_t) nodes.size();
+  nodes.emplace_back();
+
+  BoundingBox node_bounds, centroid_bounds;
+  for (auto i = first; i < first + count; i++) {
+    node_bounds.expand(bounds[items[i]]);
+    centroid_bounds.expand(centroids[items[i]]);
+  }
+  nodes[index].bounds = node_bounds;
+  nodes[index].first = first;
+  nodes[index].count = count;
+  if (count <= LeafSize || depth >= MaxDepth)
+    return index;
+
+  // Split along the longest axis of the centroids
+  auto extent = centroid_bounds.max - centroid_bounds.min;
+  int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+  if (extent[axis] <= 0.0f)
+    return index;
+
+  // Bin the centroids and evaluate the surface area heuristic at every bin boundary
+  BoundingBox bin_bounds[BinCount];
+  uint32_t bin_counts[BinCount] = {};
+  auto scale = BinCount / extent[axis];
+  auto binOf = [&](unsigned int item) {
+    return std::min(BinCount - 1, (int) ((centroids[item][axis] - centroid_bounds.min[axis]) * scale));
+  };
+  for (auto i = first; i < first + count; i++) {
+    auto bin = binOf(items[i]);
+    bin_bounds[bin].expand(bounds[items[i]]);
+    bin_counts[bin]++;
+  }
+
+  float left_area[BinCount - 1];
+  uint32_t left_count[BinCount - 1];
+  BoundingBox left;
+  uint32_t left_sum = 0;
+  for (int i = 0; i < BinCount - 1; i++) {
+    left.expand(bin_bounds[i]);
+    left_sum += bin_counts[i];
+    left_area[i] = surfaceArea(left);
+    left_count[i] = left_sum;
+  }
+
+  int best_split = -1;
+  float best_cost = (float) count * surfaceArea(node_bounds);
+  BoundingBox right;
+  uint32_t right_sum = 0;
+  for (int i = BinCount - 1; i > 0; i--) {
+    right.expand(bin_bounds[i]);
+    right_sum += bin_counts[i];
+    if (left_count[i - 1] == 0 || right_sum == 0)
+      continue;
+    auto cost = left_area[i - 1] * left_count[i - 1] + surfaceArea(right) * right_sum;
+    if (cost < best_cost) {
+      best_cost = cost;
+      best_split = i;
+    }
+  }
+
+  // Keeping the items together is cheaper than any split
+  if (best_split < 0)
+    return index;
+
+  auto middle = std::partition(items.begin() + first, items.begin() + first + count,
+                               [&](unsigned int item) { return binOf(item) < best_split; });
+  auto left_items = (uint32_t) (middle - (items.begin() + first));
+
+  buildNode(bounds, centroids, first, left_items, depth + 1);
+  auto right_index = buildNode(bounds, centroids, first + left_items, count - left_items, depth + 1);
+  nodes[index].right = right_index;
+  return index;
+}
+
+void ppgso::Bvh::refit(const std::vector<BoundingBox> &bounds) {
+  // Children are stored after their parent, so a reverse pass sees them first
+  for (auto i = nodes.size(); i-- > 0;) {
+    auto &node = nodes[i];
+    node.bounds = BoundingBox{};
+    if (node.right) {
+      node.bounds.expand(nodes[i + 1].bounds);
+      node.bounds.expand(nodes[node.right].bounds);
+    } else {
+      for (auto j = node.first; j < node.first + node.count; j++) {
+        itemBounds[j] = bounds[items[j]];
+        node.bounds.expand(itemBounds[j]);
+      }
+    }
+  }
+}
+
+void ppgso::Bvh::collect(const Node &node, std::vector<unsigned int> &results) const {
+  results.insert(results.end(), items.begin() + node.first, items.begin() + node.first + node.count);
+}
+
+void ppgso::Bvh::query(const Frustum &frustum, std::vector<unsigned int> &results) const {
+  if (nodes.empty())
+    return;
+
+  uint32_t stack[StackSize];
+  int top = 0;
+  stack[top++] = 0;
+  while (top > 0) {
+    auto &node = nodes[stack[--top]];
+    if (!frustum.intersects(node.bounds))
+      continue;
+
+    // Whole subtree visible, no need to test the children
+    if (frustum.contains(node.bounds)) {
+      collect(node, results);
+      continue;
+    }
+
+    if (!node.right) {
+      for (auto i = node.first; i < node.first + node.count; i++)
+        if (frustum.intersects(itemBounds[i]))
+          results.push_back(items[i]);
+      continue;
+    }
+    auto index = (uint32_t) (&node - nodes.data());
+    stack[top++] = node.right;
+    stack[top++] = index + 1;
+  }
+}
+
+void ppgso::Bvh::query(const BoundingSphere &sphere, std::vector<unsigned int> &results) const {
+  if (nodes.empty())
+    return;
+
+  auto overlaps = [&sphere](const BoundingBox &box) {
+    auto closest = glm::clamp(sphere.center, box.min, box.max);
+    auto offset = closest - sphere.center;
+    return glm::dot(offset, offset) <= sphere.radius * sphere.radius;
+  };
+
+  uint32_t stack[StackSize];
+  int top = 0;
+  stack[top++] = 0;
+  while (top > 0) {
+    auto &node = nodes[stack[--top]];
+    if (!overlaps(node.bounds))
+      continue;
+
+    if (!node.right) {
+      for (auto i = node.first; i < node.first + node.count; i++)
+        if (overlaps(itemBounds[i]))
+          results.push_back(items[i]);
+      continue;
+    }
+    auto index = (uint32_t) (&node - nodes.data());
+    stack[top++] = node.right;
+    stack[top++] = index + 1;
+  }
+}
+
+void ppgso::Bvh::query(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance,
+                       std::vector<unsigned int> &results) const {
+  if (nodes.empty())
+    return;
+
+  // Slab test, axis parallel rays get infinite inverse components
+  auto inverse = 1.0f / direction;
+  auto hits = [&](const BoundingBox &box) {
+    auto t0 = (box.min - origin) * inverse;
+    auto t1 = (box.max - origin) * inverse;
+    auto t_min = glm::min(t0, t1), t_max = glm::max(t0, t1);
+    auto enter = glm::max(glm::max(t_min.x, t_min.y), glm::max(t_min.z, 0.0f));
+    auto exit = glm::min(glm::min(t_max.x, t_max.y), glm::min(t_max.z, maxDistance));
+    return enter <= exit;
+  };
+
+  uint32_t stack[StackSize];
+  int top = 0;
+  stack[top++] = 0;
+  while (top > 0) {
+    auto &node = nodes[stack[--top]];
+    if (!hits(node.bounds))
+      continue;
+
+    if (!node.right) {
+      for (auto i = node.first; i < node.first + node.count; i++)
+        if (hits(itemBounds[i]))
+          results.push_back(items[i]);
+      continue;
+    }
+    auto index = (uint32_t) (&node - nodes.data());
+    stack[top++] = node.right;
+    stack[top++] = index + 1;
+  }
+}
+
+size_t ppgso::Bvh::size() const {
+  return items.size();
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "bounds.h"
+
+namespace ppgso {
+
+  /*!
+   * Bounding volume hierarchy over a set of boxes, answering visibility and proximity queries
+   * without testing every box.
+   *
+   * The tree is built top down with binned surface area heuristic splits and stored as a flat
+   * array in depth first order, so the left child always directly follows its parent.
+   * Queries return indices into the array of boxes the tree was built from.
+   */
+  class Bvh {
+  public:
+    /*!
+     * Build the tree, replacing the previous one.
+     *
+     * @param bounds - Box of every item.
+     */
+    void build(const std::vector<BoundingBox> &bounds);
+
+    /*!
+     * Update the node bounds after items moved without changing the tree structure.
+     * Much cheaper than a rebuild, but the tree quality degrades as items move far.
+     *
+     * @param bounds - New box of every item, same count and order as in build.
+     */
+    void refit(const std::vector<BoundingBox> &bounds);
+
+    /*!
+     * Find items whose box is at least partially inside a frustum.
+     *
+     * @param frustum - Frustum in the space of the boxes.
+     * @param results - Indices of the found items are appended.
+     */
+    void query(const Frustum &frustum, std::vector<unsigned int> &results) const;
+
+    /*!
+     * Find items whose box overlaps a sphere.
+     *
+     * @param sphere - Sphere in the space of the boxes.
+     * @param results - Indices of the found items are appended.
+     */
+    void query(const BoundingSphere &sphere, std::vector<unsigned int> &results) const;
+
+    /*!
+     * Find items whose box is hit by a ray segment.
+     *
+     * @param origin - Start of the ray.
+     * @param direction - Direction of the ray, does not need to be normalized.
+     * @param maxDistance - Length of the segment in units of direction.
+     * @param results - Indices of the found items are appended.
+     */
+    void query(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance,
+               std::vector<unsigned int> &results) const;
+
+    /*!
+     * Get the number of items in the tree.
+     *
+     * @return - Number of boxes the tree was built from.
+     */
+    size_t size() const;
+
+  private:
+    // Inner nodes have a right child, the items of any subtree are contiguous in "items"
+    struct Node {
+      BoundingBox bounds;
+      uint32_t first = 0;
+      uint32_t count = 0;
+      uint32_t right = 0;  // 0 for leaves, the root is never a right child
+    };
+
+    std::vector<Node> nodes;
+    std::vector<unsigned int> items;
+    std::vector<BoundingBox> itemBounds;  // Box of every entry in "items"
+
+    uint32_t buildNode(const std::vector<BoundingBox> &bounds, const std::vector<glm::vec3> &centroids,
+                       uint32_t first, uint32_t count, uint32_t depth);
+    void collect(const Node &node, std::vector<unsigned int> &results) const;
+  };
+}
@@ -0,0 +1,120 @@
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/euler_angles.hpp>
+
+#include "entity_storage.h"
+
+ppgso::Entity ppgso::EntityStorage::create() {
+  Entity entity;
+  if (freeIndices.empty()) {
+    entity.index = (uint32_t) generations.size();
+    generations.push_back(0);
+    denseIndex.push_back(0);
+  } else {
+    entity.index = freeIndices.back();
+    freeIndices.pop_back();
+  }
+  entity.generation = generations[entity.index];
+  denseIndex[entity.index] = (uint32_t) entities.size();
+  entities.push_back(entity);
+
+  position.emplace_back(0.0f);
+  rotation.emplace_back(0.0f);
+  scale.emplace_back(1.0f);
+  velocity.emplace_back(0.0f);
+  phase.push_back(0.0f);
+  phaseRate.push_back(0.0f);
+  age.push_back(0.0f);
+  lifetime.push_back(0.0f);
+  modelMatrix.emplace_back(1.0f);
+  return entity;
+}
+
+void ppgso::EntityStorage::destroy(Entity entity) {
+  if (alive(entity))
+    destroyAt(indexOf(entity));
+}
+
+template<typename T>
+static void swapRemove(std::vector<T> &component, size_t index) {
+  component[index] = component.back();
+  component.pop_back();
+}
+
+void ppgso::EntityStorage::destroyAt(size_t index) {
+  auto removed = entities[index];
+  generations[removed.index]++;
+  freeIndices.push_back(removed.index);
+
+  auto moved = entities.back();
+  denseIndex[moved.index] = (uint32_t) index;
+  swapRemove(entities, index);
+
+  swapRemove(position, index);
+  swapRemove(rotation, index);
+  swapRemove(scale, index);
+  swapRemove(velocity, index);
+  swapRemove(phase, index);
+  swapRemove(phaseRate, index);
+  swapRemove(age, index);
+  swapRemove(lifetime, index);
+  swapRemove(modelMatrix, index);
+}
+
+void ppgso::EntityStorage::clear() {
+  for (auto &entity : entities) {
+    generations[entity.index]++;
+    freeIndices.push_back(entity.index);
+  }
+  entities.clear();
+  position.clear();
+  rotation.clear();
+  scale.clear();
+  velocity.clear();
+  phase.clear();
+  phaseRate.clear();
+  age.clear();
+  lifetime.clear();
+  modelMatrix.clear();
+}
+
+void ppgso::EntityStorage::reserve(size_t count) {
+  entities.reserve(count);
+  position.reserve(count);
+  rotation.reserve(count);
+  scale.reserve(count);
+  velocity.reserve(count);
+  phase.reserve(count);
+  phaseRate.reserve(count);
+  age.reserve(count);
+  lifetime.reserve(count);
+  modelMatrix.reserve(count);
+}
+
+bool ppgso::EntityStorage::alive(Entity entity) const {
+  return entity.index < generations.size() && generations[entity.index] == entity.generation;
+}
+
+size_t ppgso::EntityStorage::indexOf(Entity entity) const {
+  return denseIndex[entity.index];
+}
+
+ppgso::Entity ppgso::EntityStorage::entityAt(size_t index) const {
+  return entities[index];
+}
+
+size_t ppgso::EntityStorage::size() const {
+  return entities.size();
+}
+
+void ppgso::EntityStorage::updateModelMatrices(size_t first, size_t last) {
+  for (auto i = first; i < last; i++) {
+    // Same composition as the object classes use: translate, orientate, scale
+    auto &m = modelMatrix[i];
+    m = glm::orientate4(rotation[i]);
+    m[0] *= scale[i].x;
+    m[1] *= scale[i].y;
+    m[2] *= scale[i].z;
+    m[3] = glm::vec4(position[i], 1.0f);
+  }
+}
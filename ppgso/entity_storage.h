@@ -0,0 +1,120 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace ppgso {
+
+  /*!
+   * Handle of an entity. The generation detects handles of destroyed entities whose slot was reused.
+   */
+  struct Entity {
+    uint32_t index = 0;
+    uint32_t generation = 0;
+  };
+
+  /*!
+   * Structure of arrays storage for many small entities sharing the same components.
+   *
+   * Every component is a dense array and element i of each array belongs to the same entity,
+   * so systems process ranges of entities with linear memory access and no virtual calls.
+   * Destroying an entity moves the last one into its place, dense indices are therefore not
+   * stable; use Entity handles to refer to an entity across frames.
+   *
+   * The component arrays may be read and written freely but must not be resized directly.
+   */
+  class EntityStorage {
+  public:
+    // Components, indexed by dense index
+    std::vector<glm::vec3> position;
+    std::vector<glm::vec3> rotation;
+    std::vector<glm::vec3> scale;
+    std::vector<glm::vec3> velocity;
+    std::vector<float> phase;         // Animation phase
+    std::vector<float> phaseRate;     // Phase change per second
+    std::vector<float> age;
+    std::vector<float> lifetime;
+    std::vector<glm::mat4> modelMatrix;
+
+    /*!
+     * Create an entity with identity transform and zero velocity, phase and age.
+     *
+     * @return - Handle of the new entity, its dense index is size() - 1.
+     */
+    Entity create();
+
+    /*!
+     * Destroy an entity, does nothing for stale handles.
+     *
+     * @param entity - Entity to destroy.
+     */
+    void destroy(Entity entity);
+
+    /*!
+     * Destroy the entity at a dense index, moving the last entity into its place.
+     * Systems iterating backwards can remove entities while iterating.
+     *
+     * @param index - Dense index of the entity.
+     */
+    void destroyAt(size_t index);
+
+    /*!
+     * Remove all entities, keeping the allocated storage. Existing handles become stale.
+     */
+    void clear();
+
+    /*!
+     * Reserve storage for a number of entities.
+     *
+     * @param count - Expected number of entities.
+     */
+    void reserve(size_t count);
+
+    /*!
+     * Check if a handle refers to an existing entity.
+     *
+     * @param entity - Handle to check.
+     * @return - True if the entity was not destroyed.
+     */
+    bool alive(Entity entity) const;
+
+    /*!
+     * Get the current dense index of an entity.
+     *
+     * @param entity - Handle of an existing entity.
+     * @return - Index into the component arrays.
+     */
+    size_t indexOf(Entity entity) const;
+
+    /*!
+     * Get the handle of the entity at a dense index.
+     *
+     * @param index - Dense index of the entity.
+     * @return - Handle of the entity.
+     */
+    Entity entityAt(size_t index) const;
+
+    /*!
+     * Get the number of entities.
+     *
+     * @return - Number of entities, the size of every component array.
+     */
+    size_t size() const;
+
+    /*!
+     * Rebuild the model matrices of a range of entities from position, rotation and scale.
+     *
+     * @param first - Dense index of the first entity.
+     * @param last - Dense index one past the last entity.
+     */
+    void updateModelMatrices(size_t first, size_t last);
+
+  private:
+    // Dense index to handle, and handle index to dense index
+    std::vector<Entity> entities;
+    std::vector<uint32_t> denseIndex;
+    std::vector<uint32_t> generations;
+    std::vector<uint32_t> freeIndices;
+  };
+}
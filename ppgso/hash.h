@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+namespace ppgso {
+
+  /*!
+   * 32-bit FNV-1a hash of a null terminated string, usable in constant expressions.
+   *
+   * @param text - String to hash.
+   * @return - Hash value.
+   */
+  constexpr uint32_t hashString(const char *text) {
+    uint32_t hash = 2166136261u;
+    while (*text) {
+      hash ^= static_cast<uint8_t>(*text++);
+      hash *= 16777619u;
+    }
+    return hash;
+  }
+
+  /*!
+   * 64-bit FNV-1a hash of a block of memory.
+   *
+   * @param data - Pointer to the data to hash.
+   * @param size - Size of the data in bytes.
+   * @param seed - Previous hash value when hashing data in several parts.
+   * @return - Hash value.
+   */
+  inline uint64_t hashData(const void *data, size_t size, uint64_t seed = 14695981039346656037ull) {
+    auto bytes = static_cast<const uint8_t *>(data);
+    uint64_t hash = seed;
+    for (size_t i = 0; i < size; i++) {
+      hash ^= bytes[i];
+      hash *= 1099511628211ull;
+    }
+    return hash;
+  }
+
+  /*!
+   * 64-bit FNV-1a hash of a string.
+   *
+   * @param text - String to hash.
+   * @param seed - Previous hash value when hashing data in several parts.
+   * @return - Hash value.
+   */
+  inline uint64_t hashData(const std::string &text, uint64_t seed = 14695981039346656037ull) {
+    return hashData(text.data(), text.size(), seed);
+  }
+}
@@ -0,0 +1,120 @@
+#include <algorithm>
+
+#include "image_bc1.h"
+#include "job_system.h"
+
+namespace ppgso {
+  namespace image {
+
+    // Block rows are split into jobs of about this many blocks
+    static const size_t BlocksPerJob = 1 << 12;
+
+    static uint16_t packRGB565(const int color[3]) {
+      return (uint16_t) (((color[0] >> 3) << 11) | ((color[1] >> 2) << 5) | (color[2] >> 3));
+    }
+
+    static void unpackRGB565(uint16_t packed, int color[3]) {
+      // Replicate the high bits into the low ones like the hardware does
+      auto r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+      color[0] = (r << 3) | (r >> 2);
+      color[1] = (g << 2) | (g >> 4);
+      color[2] = (b << 3) | (b >> 2);
+    }
+
+    static void compressBlock(const Image::Pixel block[16], uint8_t *output) {
+      // Bounding box of the block colors
+      int min[3] = {255, 255, 255}, max[3] = {0, 0, 0}, mean[3] = {0, 0, 0};
+      for (int i = 0; i < 16; i++) {
+        const uint8_t channels[3] = {block[i].r, block[i].g, block[i].b};
+        for (int c = 0; c < 3; c++) {
+          min[c] = std::min(min[c], (int) channels[c]);
+          max[c] = std::max(max[c], (int) channels[c]);
+          mean[c] += channels[c];
+        }
+      }
+
+      // Pick the box diagonal following the colors, red and blue are flipped when they fall while green rises
+      int covariance[2] = {0, 0};
+      for (int i = 0; i < 16; i++) {
+        auto g = block[i].g * 16 - mean[1];
+        covariance[0] += (block[i].r * 16 - mean[0]) * g;
+        covariance[1] += (block[i].b * 16 - mean[2]) * g;
+      }
+      if (covariance[0] < 0) std::swap(min[0], max[0]);
+      if (covariance[1] < 0) std::swap(min[2], max[2]);
+
+      // Inset the endpoints by 1/16 of the range, the extremes are rarely worth an exact endpoint
+      int endpoints[2][3];
+      for (int c = 0; c < 3; c++) {
+        auto inset = (max[c] - min[c]) / 16;
+        endpoints[0][c] = max[c] - inset;
+        endpoints[1][c] = min[c] + inset;
+      }
+
+      auto color0 = packRGB565(endpoints[0]), color1 = packRGB565(endpoints[1]);
+      uint32_t indices = 0;
+      if (color0 != color1) {
+        // Four color mode needs color0 > color1
+        if (color0 < color1) std::swap(color0, color1);
+
+        // Palette as decoded: color0, color1, 2/3 color0 + 1/3 color1, 1/3 color0 + 2/3 color1
+        int palette[4][3];
+        unpackRGB565(color0, palette[0]);
+        unpackRGB565(color1, palette[1]);
+        for (int c = 0; c < 3; c++) {
+          palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+          palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+
+        for (int i = 0; i < 16; i++) {
+          const int channels[3] = {block[i].r, block[i].g, block[i].b};
+          int best = 0, best_distance = 0x7fffffff;
+          for (int p = 0; p < 4; p++) {
+            int distance = 0;
+            for (int c = 0; c < 3; c++)
+              distance += (channels[c] - palette[p][c]) * (channels[c] - palette[p][c]);
+            if (distance < best_distance) {
+              best = p;
+              best_distance = distance;
+            }
+          }
+          indices |= (uint32_t) best << (i * 2);
+        }
+      }
+
+      // Little endian: two endpoints, then 2 bits per pixel starting at the top left
+      output[0] = (uint8_t) color0;
+      output[1] = (uint8_t) (color0 >> 8);
+      output[2] = (uint8_t) color1;
+      output[3] = (uint8_t) (color1 >> 8);
+      for (int i = 0; i < 4; i++)
+        output[4 + i] = (uint8_t) (indices >> (i * 8));
+    }
+
+    size_t bc1Size(int width, int height) {
+      return (size_t) ((width + 3) / 4) * ((height + 3) / 4) * 8;
+    }
+
+    std::vector<uint8_t> compressBC1(Image &image) {
+      auto blocks_x = (image.width + 3) / 4, blocks_y = (image.height + 3) / 4;
+      std::vector<uint8_t> result(bc1Size(image.width, image.height));
+      auto &framebuffer = image.getFramebuffer();
+
+      auto grain = std::max<size_t>(1, BlocksPerJob / (size_t) blocks_x);
+      JobSystem::shared().parallelFor((size_t) blocks_y, grain, [&](size_t first, size_t last) {
+        Image::Pixel block[16];
+        for (auto by = first; by < last; by++) {
+          for (int bx = 0; bx < blocks_x; bx++) {
+            for (int i = 0; i < 16; i++) {
+              auto x = std::min(bx * 4 + i % 4, image.width - 1);
+              auto y = std::min((int) by * 4 + i / 4, image.height - 1);
+              block[i] = framebuffer[(size_t) y * image.width + x];
+            }
+            compressBlock(block, &result[(by * blocks_x + bx) * 8]);
+          }
+        }
+      });
+      return result;
+    }
+  }
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "image.h"
+
+namespace ppgso {
+  namespace image {
+/*!
+ * Get the size of an image compressed to BC1 (DXT1), 8 bytes per 4x4 block.
+ *
+ * @param width - Width in pixels.
+ * @param height - Height in pixels.
+ * @return - Size in bytes.
+ */
+  size_t bc1Size(int width, int height);
+
+/*!
+ * Compress an image to opaque BC1 (DXT1) blocks as expected by GL_COMPRESSED_RGB_S3TC_DXT1_EXT.
+ * Endpoints are the inset corners of the block's bounding box along its dominant diagonal,
+ * blocks on the edges repeat the last row and column. Block rows are compressed on the shared JobSystem.
+ *
+ * @param image - Image to compress.
+ * @return - Blocks in row major order, see bc1Size.
+ */
+  std::vector<uint8_t> compressBC1(ppgso::Image &image);
+ }
+}
@@ -1,7 +1,16 @@
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <sstream>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PPGSO_BMP_SSSE3
+#include <tmmintrin.h>
+#endif
+
 #include "image_bmp.h"
+#include "job_system.h"
+#include "mapped_file.h"
 
 namespace ppgso {
   namespace image {
@@ -33,21 +42,73 @@ namespace ppgso {
     } BITMAPINFOHEADER;
 #pragma pack()
 
+    // Rows are split into jobs of about this many pixels, smaller images are converted on the calling thread
+    static const size_t PixelsPerJob = 1 << 16;
+
+    // Copy pixels swapping the first and third byte, BMP stores BGR and the framebuffer RGB
+    static void swizzleScalar(const uint8_t *source, uint8_t *destination, size_t count) {
+      for (size_t i = 0; i < count; i++, source += 3, destination += 3) {
+        destination[0] = source[2];
+        destination[1] = source[1];
+        destination[2] = source[0];
+      }
+    }
+
+#ifdef PPGSO_BMP_SSSE3
+    // Five pixels per shuffle, each store writes one byte past them which the next iteration overwrites
+    __attribute__((target("ssse3")))
+    static void swizzleSsse3(const uint8_t *source, uint8_t *destination, size_t count) {
+      const auto mask = _mm_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, 15);
+      size_t i = 0;
+      for (; i + 6 <= count; i += 5) {
+        auto pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i * 3));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(destination + i * 3), _mm_shuffle_epi8(pixels, mask));
+      }
+      swizzleScalar(source + i * 3, destination + i * 3, count - i);
+    }
+#endif
+
+    // Pick the fastest conversion supported by the CPU once
+    static void swizzle(const uint8_t *source, uint8_t *destination, size_t count) {
+#ifdef PPGSO_BMP_SSSE3
+      static const auto function = __builtin_cpu_supports("ssse3") ? swizzleSsse3 : swizzleScalar;
+      function(source, destination, count);
+#else
+      swizzleScalar(source, destination, count);
+#endif
+    }
+
+    // Call fn(row) for all rows, on several threads for large images
+    template<typename Fn>
+    static void forEachRow(int width, int height, Fn &&fn) {
+      auto grain = std::max<size_t>(1, PixelsPerJob / (size_t) width);
+      JobSystem::shared().parallelFor((size_t) height, grain, [&fn](size_t first, size_t last) {
+        for (auto row = first; row < last; row++)
+          fn((int) row);
+      });
+    }
+
     Image loadBMP(const std::string &bmp) {
       BITMAPFILEHEADER bmpFileHeader = {};
       BITMAPINFOHEADER bmpInfoHeader = {};
 
-      std::ifstream input_file(bmp, std::ios::binary);
+      // Map the whole file, the pixels are converted straight from the mapping
+      MappedFile input_file{bmp};
 
       // Check headers
-      if (!input_file.is_open()) {
+      if (!input_file.valid()) {
         std::stringstream msg;
         msg << "Could not open BMP file. " << bmp;
         throw std::runtime_error(msg.str());
       }
 
-      input_file.read((char *) &bmpFileHeader, sizeof(BITMAPFILEHEADER));
-      input_file.read((char *) &bmpInfoHeader, sizeof(BITMAPINFOHEADER));
+      if (input_file.size() < sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER)) {
+        std::stringstream msg;
+        msg << "BMP file does not contain supported BMP format. " << bmp;
+        throw std::runtime_error(msg.str());
+      }
+      std::copy_n(input_file.data(), sizeof(BITMAPFILEHEADER), (uint8_t *) &bmpFileHeader);
+      std::copy_n(input_file.data() + sizeof(BITMAPFILEHEADER), sizeof(BITMAPINFOHEADER), (uint8_t *) &bmpInfoHeader);
 
       if (bmpFileHeader.bfType != 19778) {
         std::stringstream msg;
@@ -71,35 +132,32 @@ namespace ppgso {
       int height = abs(bmpInfoHeader.biHeight);
       bool flipped = bmpInfoHeader.biHeight < 0;
 
-      if (width == 0 || height == 0) {
+      if (width <= 0 || height == 0) {
         std::stringstream msg;
         msg << "BMP file does not contain any data. " << bmp;
         throw std::runtime_error(msg.str());
       }
 
-      Image image{width, height};
-      auto &framebuffer = image.getFramebuffer();
-
-      // Load data
-      input_file.seekg(bmpFileHeader.bfOffBits, input_file.beg);
-
       // BMP uses padding for rows
-      unsigned int row_padded = (width * sizeof(Image::Pixel) + 3) & (~3);
+      size_t row_padded = ((size_t) width * sizeof(Image::Pixel) + 3) & (~(size_t) 3);
 
-      for (int j = 0; j < height; j++) {
-        auto row_data = std::vector<Image::Pixel>(row_padded);
-        input_file.read((char *) row_data.data(), row_padded);
-        for (int i = 0; i < width; i++) {
-          auto pixel = row_data[i];
-          std::swap(pixel.r, pixel.b);
-          if (flipped) {
-            framebuffer[i + j * width] = pixel;
-          } else {
-            framebuffer[i + (height - 1 - j) * width] = pixel;
-          }
-        }
+      if (bmpFileHeader.bfOffBits > input_file.size() ||
+          (input_file.size() - bmpFileHeader.bfOffBits) / row_padded < (size_t) height) {
+        std::stringstream msg;
+        msg << "BMP file is truncated. " << bmp;
+        throw std::runtime_error(msg.str());
       }
-      input_file.close();
+
+      Image image{width, height};
+      auto framebuffer = (uint8_t *) image.getFramebuffer().data();
+      auto pixels = input_file.data() + bmpFileHeader.bfOffBits;
+      auto row_size = (size_t) width * sizeof(Image::Pixel);
+
+      // Bottom up rows unless the height is negative
+      forEachRow(width, height, [&](int j) {
+        auto row = flipped ? j : height - 1 - j;
+        swizzle(pixels + j * row_padded, framebuffer + row * row_size, (size_t) width);
+      });
 
       return image;
     }
@@ -107,7 +165,7 @@ namespace ppgso {
     void saveBMP(ppgso::Image &image, const std::string &bmp) {
       auto width = image.width;
       auto height = image.height;
-      auto &framebuffer = image.getFramebuffer();
+      auto framebuffer = (const uint8_t *) image.getFramebuffer().data();
 
       unsigned int row_padded = (width * sizeof(Image::Pixel) + 3) & (~3);
 
@@ -142,18 +200,15 @@ namespace ppgso {
       output_file.write((char *) &bmpFileHeader, sizeof(BITMAPFILEHEADER));
       output_file.write((char *) &bmpInfoHeader, sizeof(BITMAPINFOHEADER));
 
-      // Prepare BRG output data by swapping RGB to BRG and mirroring along height
+      // Prepare BRG output data by swapping RGB to BRG and mirroring along height, padding stays zero
       output_file.seekp(bmpFileHeader.bfOffBits, output_file.beg);
 
-      for (int j = 0; j < height; j++) {
-        auto output_row = std::vector<Image::Pixel>(row_padded);
-        for (int i = 0; i < width; i++) {
-          auto pixel = framebuffer[i + (height - 1 - j) * width];
-          std::swap(pixel.r, pixel.b);
-          output_row[i] = pixel;
-        }
-        output_file.write((char *) output_row.data(), row_padded);
-      }
+      std::vector<uint8_t> output_data((size_t) row_padded * height);
+      auto row_size = (size_t) width * sizeof(Image::Pixel);
+      forEachRow(width, height, [&](int j) {
+        swizzle(framebuffer + (height - 1 - j) * row_size, output_data.data() + j * row_padded, (size_t) width);
+      });
+      output_file.write((char *) output_data.data(), output_data.size());
 
       output_file.close();
     }
@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <cmath>
+
+#include "image_mipmap.h"
+#include "job_system.h"
+
+namespace ppgso {
+  namespace image {
+
+    // Rows are split into jobs of about this many pixels
+    static const size_t PixelsPerJob = 1 << 16;
+
+    // Resolution of the linear to sRGB table, fine enough to round trip all 8-bit values
+    static const int LinearSteps = 4096;
+
+    // Source pixels covered by one destination pixel along an axis, at most 3 while halving
+    struct Taps {
+      int first = 0;
+      int count = 0;
+      float weights[3] = {};
+    };
+
+    static const float *srgbToLinear() {
+      static const auto table = [] {
+        std::vector<float> result(256);
+        for (int i = 0; i < 256; i++) {
+          auto c = i / 255.0f;
+          result[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+        return result;
+      }();
+      return table.data();
+    }
+
+    static const uint8_t *linearToSrgb() {
+      static const auto table = [] {
+        std::vector<uint8_t> result(LinearSteps + 1);
+        for (int i = 0; i <= LinearSteps; i++) {
+          auto c = (float) i / LinearSteps;
+          auto s = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+          result[i] = (uint8_t) std::lround(std::min(std::max(s, 0.0f), 1.0f) * 255.0f);
+        }
+        return result;
+      }();
+      return table.data();
+    }
+
+    // Area weights of a box filter shrinking source pixels to destination pixels
+    static std::vector<Taps> boxTaps(int source, int destination) {
+      std::vector<Taps> result(destination);
+      auto scale = (float) source / destination;
+      for (int d = 0; d < destination; d++) {
+        auto begin = d * scale, end = (d + 1) * scale;
+        auto &taps = result[d];
+        taps.first = (int) begin;
+        for (int s = taps.first; s < end && s < source && taps.count < 3; s++)
+          taps.weights[taps.count++] = (std::min(end, s + 1.0f) - std::max(begin, (float) s)) / scale;
+      }
+      return result;
+    }
+
+    static Image downsample(Image &source) {
+      Image result{std::max(1, source.width / 2), std::max(1, source.height / 2)};
+      auto columns = boxTaps(source.width, result.width);
+      auto rows = boxTaps(source.height, result.height);
+      auto to_linear = srgbToLinear();
+      auto to_srgb = linearToSrgb();
+      auto &input = source.getFramebuffer();
+      auto &output = result.getFramebuffer();
+
+      auto grain = std::max<size_t>(1, PixelsPerJob / (size_t) result.width);
+      JobSystem::shared().parallelFor((size_t) result.height, grain, [&](size_t first, size_t last) {
+        for (auto y = first; y < last; y++) {
+          auto &row = rows[y];
+          for (int x = 0; x < result.width; x++) {
+            auto &column = columns[x];
+            float r = 0, g = 0, b = 0;
+            for (int j = 0; j < row.count; j++) {
+              auto line = &input[(size_t) (row.first + j) * source.width];
+              for (int i = 0; i < column.count; i++) {
+                auto weight = row.weights[j] * column.weights[i];
+                auto &pixel = line[column.first + i];
+                r += to_linear[pixel.r] * weight;
+                g += to_linear[pixel.g] * weight;
+                b += to_linear[pixel.b] * weight;
+              }
+            }
+            auto &pixel = output[y * result.width + x];
+            pixel.r = to_srgb[std::min(LinearSteps, (int) (r * LinearSteps + 0.5f))];
+            pixel.g = to_srgb[std::min(LinearSteps, (int) (g * LinearSteps + 0.5f))];
+            pixel.b = to_srgb[std::min(LinearSteps, (int) (b * LinearSteps + 0.5f))];
+          }
+        }
+      });
+      return result;
+    }
+
+    int mipLevelCount(int width, int height) {
+      int levels = 1;
+      for (auto size = std::max(width, height); size > 1; size /= 2)
+        levels++;
+      return levels;
+    }
+
+    std::vector<Image> buildMipChain(Image &&image) {
+      std::vector<Image> levels;
+      levels.reserve(mipLevelCount(image.width, image.height));
+      levels.push_back(std::move(image));
+      while (levels.back().width > 1 || levels.back().height > 1)
+        levels.push_back(downsample(levels.back()));
+      return levels;
+    }
+  }
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <vector>
+
+#include "image.h"
+
+namespace ppgso {
+  namespace image {
+/*!
+ * Get the number of levels of a full mip chain, down to 1x1 pixels.
+ *
+ * @param width - Width of the largest level in pixels.
+ * @param height - Height of the largest level in pixels.
+ * @return - Number of mip levels.
+ */
+  int mipLevelCount(int width, int height);
+
+/*!
+ * Build all mip levels of an image with a gamma correct box filter. The pixels are treated as
+ * sRGB, averaged in linear space and encoded back, so downsampled levels keep the brightness of
+ * the original. Odd sizes are filtered with fractional weights. Large levels are split into row
+ * ranges on the shared JobSystem.
+ *
+ * @param image - Largest level, moved into the result.
+ * @return - All levels, the image itself first and 1x1 pixels last.
+ */
+  std::vector<ppgso::Image> buildMipChain(ppgso::Image &&image);
+ }
+}
@@ -0,0 +1,225 @@
+#include <algorithm>
+#include <iostream>
+
+#include "job_system.h"
+
+// Queue index of the current thread, workers set it when they start
+static thread_local unsigned currentThread = 0;
+
+// Set while the current thread runs a background job, jobs it queues are background jobs too
+static thread_local bool inBackground = false;
+
+bool ppgso::JobSystem::Counter::done() const {
+  // Taking the lock makes sure the finishing job no longer touches the counter
+  std::lock_guard<std::mutex> lock(mutex);
+  return pending == 0;
+}
+
+ppgso::JobSystem::JobSystem(unsigned workers) {
+  if (workers == 0) {
+    auto cores = std::thread::hardware_concurrency();
+    workers = cores > 1 ? cores - 1 : 1;
+  }
+
+  for (unsigned i = 0; i <= workers; i++)
+    queues.emplace_back(new Queue);
+  for (unsigned i = 1; i <= workers; i++)
+    this->workers.emplace_back(&JobSystem::workerLoop, this, i);
+}
+
+ppgso::JobSystem::~JobSystem() {
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex);
+    stopping = true;
+  }
+  wake.notify_all();
+  for (auto &worker : workers)
+    worker.join();
+}
+
+ppgso::JobSystem &ppgso::JobSystem::shared() {
+  static JobSystem system;
+  return system;
+}
+
+void ppgso::JobSystem::run(Job job, Counter *counter) {
+  if (counter)
+    counter->pending++;
+  enqueue(std::move(job), counter);
+}
+
+void ppgso::JobSystem::runBackground(Job job, Counter *counter) {
+  if (counter)
+    counter->pending++;
+  {
+    std::lock_guard<std::mutex> lock(background.mutex);
+    background.jobs.emplace_back(std::move(job), counter);
+  }
+  notify();
+}
+
+bool ppgso::JobSystem::isBackground() {
+  return inBackground;
+}
+
+void ppgso::JobSystem::runAfter(Counter &dependency, Job job, Counter *counter) {
+  if (counter)
+    counter->pending++;
+  {
+    std::lock_guard<std::mutex> lock(dependency.mutex);
+    if (dependency.pending > 0) {
+      dependency.continuations.emplace_back(std::move(job), counter);
+      return;
+    }
+  }
+  enqueue(std::move(job), counter);
+}
+
+void ppgso::JobSystem::wait(const Counter &counter) {
+  auto index = std::min<unsigned>(threadIndex(), (unsigned) queues.size() - 1);
+  // A background job waits for its own nested jobs, which are background jobs as well
+  while (!counter.done()) {
+    if (!runOne(index, inBackground))
+      std::this_thread::yield();
+  }
+
+  std::exception_ptr error;
+  {
+    std::lock_guard<std::mutex> lock(counter.mutex);
+    std::swap(error, counter.error);
+  }
+  if (error)
+    std::rethrow_exception(error);
+}
+
+unsigned ppgso::JobSystem::getThreadCount() const {
+  return (unsigned) queues.size();
+}
+
+unsigned ppgso::JobSystem::threadIndex() {
+  return currentThread;
+}
+
+void ppgso::JobSystem::enqueue(Job job, Counter *counter) {
+  if (inBackground) {
+    // Front of the background deque, so work of loads already running goes before new loads
+    {
+      std::lock_guard<std::mutex> lock(background.mutex);
+      background.jobs.emplace_front(std::move(job), counter);
+    }
+    notify();
+    return;
+  }
+
+  auto &queue = *queues[std::min<unsigned>(threadIndex(), (unsigned) queues.size() - 1)];
+  {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.jobs.emplace_back(std::move(job), counter);
+  }
+  notify();
+}
+
+void ppgso::JobSystem::notify() {
+  {
+    // Incremented under the sleep lock so a worker about to sleep cannot miss it
+    std::lock_guard<std::mutex> lock(sleepMutex);
+    queued++;
+  }
+  wake.notify_one();
+}
+
+bool ppgso::JobSystem::runOne(unsigned index, bool runBackground) {
+  std::pair<Job, Counter *> job;
+  bool found = false;
+  bool backgroundJob = false;
+
+  // Newest own job first, it is the most likely to still be in cache
+  {
+    auto &queue = *queues[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (!queue.jobs.empty()) {
+      job = std::move(queue.jobs.back());
+      queue.jobs.pop_back();
+      found = true;
+    }
+  }
+
+  // Otherwise steal the oldest job of another thread
+  for (size_t i = 1; !found && i < queues.size(); i++) {
+    auto &queue = *queues[(index + i) % queues.size()];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (!queue.jobs.empty()) {
+      job = std::move(queue.jobs.front());
+      queue.jobs.pop_front();
+      found = true;
+    }
+  }
+
+  // Background jobs last, and only on workers with nothing else to do
+  if (!found && runBackground) {
+    std::lock_guard<std::mutex> lock(background.mutex);
+    if (!background.jobs.empty()) {
+      job = std::move(background.jobs.front());
+      background.jobs.pop_front();
+      found = true;
+      backgroundJob = true;
+    }
+  }
+
+  if (!found)
+    return false;
+  queued--;
+
+  // Restored afterwards, a background job may run other jobs while it waits
+  auto outer = inBackground;
+  inBackground = backgroundJob;
+  std::exception_ptr error;
+  try {
+    job.first();
+  } catch (...) {
+    error = std::current_exception();
+  }
+  inBackground = outer;
+  finish(job.second, error);
+  return true;
+}
+
+void ppgso::JobSystem::finish(Counter *counter, std::exception_ptr error) {
+  if (!counter) {
+    // Nobody waits for the job, report the error and drop it
+    if (error) {
+      try {
+        std::rethrow_exception(error);
+      } catch (std::exception &e) {
+        std::cerr << "Job without a counter failed: " << e.what() << std::endl;
+      } catch (...) {
+        std::cerr << "Job without a counter failed with an unknown exception" << std::endl;
+      }
+    }
+    return;
+  }
+
+  std::vector<std::pair<Job, Counter *>> released;
+  {
+    std::lock_guard<std::mutex> lock(counter->mutex);
+    if (error && !counter->error)
+      counter->error = error;
+    if (--counter->pending == 0)
+      released.swap(counter->continuations);
+  }
+  for (auto &continuation : released)
+    enqueue(std::move(continuation.first), continuation.second);
+}
+
+void ppgso::JobSystem::workerLoop(unsigned index) {
+  currentThread = index;
+  for (;;) {
+    if (runOne(index, true))
+      continue;
+
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    wake.wait(lock, [this] { return stopping || queued > 0; });
+    if (stopping && queued == 0)
+      return;
+  }
+}
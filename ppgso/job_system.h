@@ -0,0 +1,184 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ppgso {
+
+  /*!
+   * Fixed pool of worker threads running small jobs.
+   *
+   * Every thread has its own deque: jobs run by a thread are pushed to its back and the owner
+   * takes from the back, idle workers steal from the front of other deques. Threads outside the
+   * pool share one deque. Completion is tracked with counters, a job can be held back until a
+   * counter reaches zero, and waiting on a counter runs pending jobs instead of blocking, so the
+   * main thread helps while it waits and jobs may wait on other jobs. Long running jobs go to a
+   * separate background deque that only idle workers take from, waiting never runs them. Jobs
+   * queued by a background job, including the ranges of parallelFor, are background jobs too.
+   */
+  class JobSystem {
+  public:
+    using Job = std::function<void()>;
+
+    /*!
+     * Number of unfinished jobs associated with it. Must outlive all its jobs and waits.
+     * The first exception thrown by one of its jobs is kept and rethrown by wait. Jobs queued
+     * without a counter have nobody to report to, their exceptions are written to std::cerr and dropped.
+     */
+    class Counter {
+    public:
+      Counter() = default;
+      Counter(const Counter &) = delete;
+      Counter &operator=(const Counter &) = delete;
+
+      /*!
+       * Check if all jobs associated with the counter have finished.
+       *
+       * @return - True when no jobs are pending.
+       */
+      bool done() const;
+
+    private:
+      friend class JobSystem;
+      std::atomic<unsigned> pending{0};
+      mutable std::exception_ptr error;
+
+      // Jobs started once the counter drops to zero, with the counters they report to
+      mutable std::mutex mutex;
+      std::vector<std::pair<Job, Counter *>> continuations;
+    };
+
+    /*!
+     * Start the worker threads.
+     *
+     * @param workers - Number of worker threads, 0 uses one less than the number of cores.
+     */
+    explicit JobSystem(unsigned workers = 0);
+
+    /*!
+     * Finish all queued jobs and stop the workers.
+     */
+    ~JobSystem();
+
+    JobSystem(const JobSystem &) = delete;
+    JobSystem &operator=(const JobSystem &) = delete;
+
+    /*!
+     * Get the process-wide pool shared by all subsystems, started on first use.
+     *
+     * @return - Shared job system.
+     */
+    static JobSystem &shared();
+
+    /*!
+     * Queue a job.
+     *
+     * @param job - Function to run on any thread of the pool.
+     * @param counter - Counter incremented now and decremented when the job finishes, may be nullptr.
+     */
+    void run(Job job, Counter *counter = nullptr);
+
+    /*!
+     * Queue a long running job, such as loading a file, that must not delay waits of the frame.
+     * It only runs on a worker that has nothing else to do and is only run by waits of other
+     * background jobs.
+     *
+     * @param job - Function to run on a worker thread.
+     * @param counter - Counter incremented now and decremented when the job finishes, may be nullptr.
+     */
+    void runBackground(Job job, Counter *counter = nullptr);
+
+    /*!
+     * Queue a job once all jobs of another counter have finished.
+     *
+     * @param dependency - Counter the job waits for.
+     * @param job - Function to run.
+     * @param counter - Counter incremented now and decremented when the job finishes, may be nullptr.
+     */
+    void runAfter(Counter &dependency, Job job, Counter *counter = nullptr);
+
+    /*!
+     * Check if the calling thread is running a background job.
+     *
+     * @return - True inside a job queued with runBackground or queued by such a job.
+     */
+    static bool isBackground();
+
+    /*!
+     * Wait until a counter reaches zero, running queued jobs other than background jobs in the
+     * meantime, background jobs only when called from one. Throws the first exception of the counter's jobs once all of them have finished.
+     *
+     * @param counter - Counter to wait for.
+     */
+    void wait(const Counter &counter);
+
+    /*!
+     * Call fn(first, last) on ranges covering [0, count) in parallel and wait for all of them.
+     *
+     * @param count - Number of items.
+     * @param grain - Maximal number of items in one range, ranges are never split further.
+     * @param fn - Function processing the items from first up to but excluding last. An exception
+     *             thrown by it is rethrown after all ranges have finished.
+     */
+    template<typename Fn>
+    void parallelFor(size_t count, size_t grain, Fn &&fn) {
+      if (grain == 0) grain = 1;
+      if (count <= grain) {
+        if (count) fn((size_t) 0, count);
+        return;
+      }
+
+      Counter counter;
+      for (size_t first = 0; first < count; first += grain) {
+        auto last = std::min(count, first + grain);
+        run([&fn, first, last] { fn(first, last); }, &counter);
+      }
+      wait(counter);
+    }
+
+    /*!
+     * Get the number of threads that can run jobs, the workers and the threads outside the pool.
+     *
+     * @return - Number of workers plus one.
+     */
+    unsigned getThreadCount() const;
+
+    /*!
+     * Get the index of the calling thread, for per-thread storage sized by getThreadCount.
+     * Threads outside the pool share index 0.
+     *
+     * @return - Index in [0, getThreadCount()).
+     */
+    static unsigned threadIndex();
+
+  private:
+    // Deque of one thread, locked for every access
+    struct Queue {
+      std::mutex mutex;
+      std::deque<std::pair<Job, Counter *>> jobs;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    Queue background;
+    std::vector<std::thread> workers;
+
+    // Idle workers sleep until jobs are queued
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::atomic<size_t> queued{0};
+    bool stopping = false;
+
+    void enqueue(Job job, Counter *counter);
+    void notify();
+    bool runOne(unsigned index, bool runBackground);
+    void finish(Counter *counter, std::exception_ptr error);
+    void workerLoop(unsigned index);
+  };
+}
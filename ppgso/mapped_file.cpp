@@ -0,0 +1,108 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+ppgso::MappedFile::MappedFile(const std::string &path) {
+  // Sharing delete access lets a writer replace the file where the system allows it while it is mapped
+  auto handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (handle == INVALID_HANDLE_VALUE)
+    return;
+  file = handle;
+
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(handle, &file_size) || file_size.QuadPart == 0)
+    return;
+
+  mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!mapping)
+    return;
+
+  address = static_cast<const uint8_t *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+  if (address)
+    length = (size_t) file_size.QuadPart;
+}
+
+ppgso::MappedFile::~MappedFile() {
+  if (address) UnmapViewOfFile(address);
+  if (mapping) CloseHandle(mapping);
+  if (file) CloseHandle(file);
+}
+
+// Paths are narrow strings in the ANSI code page everywhere else, CreateFileA included
+static std::wstring widen(const std::string &path) {
+  auto length = MultiByteToWideChar(CP_ACP, 0, path.c_str(), -1, nullptr, 0);
+  if (length <= 0)
+    return {};
+  std::wstring result((size_t) length, L'\0');
+  MultiByteToWideChar(CP_ACP, 0, path.c_str(), -1, &result[0], length);
+  result.resize((size_t) length - 1);
+  return result;
+}
+
+bool ppgso::replaceFile(const std::string &source, const std::string &destination) {
+  auto wide_source = widen(source);
+  // Replacing fails while another load still has the destination mapped, the old file stays valid then
+  if (MoveFileExW(wide_source.c_str(), widen(destination).c_str(), MOVEFILE_REPLACE_EXISTING))
+    return true;
+  DeleteFileW(wide_source.c_str());
+  return false;
+}
+
+#else
+
+ppgso::MappedFile::MappedFile(const std::string &path) {
+  auto fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return;
+
+  struct stat info;
+  if (fstat(fd, &info) == 0 && info.st_size > 0) {
+    auto map = mmap(nullptr, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map != MAP_FAILED) {
+      address = static_cast<const uint8_t *>(map);
+      length = (size_t) info.st_size;
+    }
+  }
+
+  // The mapping stays valid after the descriptor is closed
+  close(fd);
+}
+
+ppgso::MappedFile::~MappedFile() {
+  if (address) munmap(const_cast<uint8_t *>(address), length);
+}
+
+bool ppgso::replaceFile(const std::string &source, const std::string &destination) {
+  // rename replaces the destination atomically, existing mappings keep the old contents
+  if (std::rename(source.c_str(), destination.c_str()) == 0)
+    return true;
+  std::remove(source.c_str());
+  return false;
+}
+
+#endif
+
+bool ppgso::MappedFile::valid() const {
+  return address != nullptr;
+}
+
+const uint8_t *ppgso::MappedFile::data() const {
+  return address;
+}
+
+size_t ppgso::MappedFile::size() const {
+  return length;
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace ppgso {
+
+  /*!
+   * Read only memory mapping of a whole file.
+   *
+   * Pages are loaded by the operating system on first access, so data can be handed
+   * directly to OpenGL without reading it into intermediate buffers first.
+   */
+  class MappedFile {
+  public:
+    /*!
+     * Map a file into memory, check valid() to see if it succeeded.
+     *
+     * @param path - Path of the file to map.
+     */
+    MappedFile(const std::string &path);
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile &operator=(const MappedFile&) = delete;
+
+    /*!
+     * Check if the file exists, is not empty and was mapped successfully.
+     *
+     * @return - True if data() can be used.
+     */
+    bool valid() const;
+
+    /*!
+     * Get pointer to the mapped file contents.
+     *
+     * @return - Pointer to the first byte of the file, nullptr if not valid.
+     */
+    const uint8_t *data() const;
+
+    /*!
+     * Get the size of the mapped file.
+     *
+     * @return - Size of the file in bytes.
+     */
+    size_t size() const;
+
+  private:
+    const uint8_t *address = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    void *file = nullptr;
+    void *mapping = nullptr;
+#endif
+  };
+
+  /*!
+   * Move a file over another one, replacing it if it exists. On failure the source file is
+   * deleted, so a temporary file is never left behind.
+   *
+   * @param source - Path of the file to move, usually a temporary file.
+   * @param destination - Path the file is moved to.
+   * @return - True if the destination now holds the source contents.
+   */
+  bool replaceFile(const std::string &source, const std::string &destination);
+}
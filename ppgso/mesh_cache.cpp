@@ -0,0 +1,126 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <string>
+#include <thread>
+
+#include "mesh_cache.h"
+
+constexpr uint32_t ppgso::MeshCache::Version;
+constexpr uint32_t ppgso::MeshCache::OptimizedFlag;
+
+ppgso::MeshCache::MeshCache(const std::string &path, uint64_t sourceHash) : file{path} {
+  if (!file.valid() || file.size() < sizeof(Header))
+    return;
+
+  Header header;
+  memcpy(&header, file.data(), sizeof(header));
+  if (memcmp(header.magic, "PPGM", 4) != 0 || header.version != Version || header.sourceHash != sourceHash)
+    return;
+
+  // Walk the shape blocks, any truncation invalidates the whole cache
+  std::vector<Shape> result;
+  size_t offset = sizeof(Header);
+  for (uint32_t i = 0; i < header.shapeCount; i++) {
+    ShapeHeader shape_header;
+    if (offset + sizeof(shape_header) > file.size())
+      return;
+    memcpy(&shape_header, file.data() + offset, sizeof(shape_header));
+    offset += sizeof(shape_header);
+
+    size_t floats = (size_t) shape_header.positionCount + shape_header.texcoordCount + shape_header.normalCount;
+    if (offset + floats * sizeof(float) + shape_header.indexCount * sizeof(uint32_t) > file.size())
+      return;
+
+    Shape shape;
+    shape.positionCount = shape_header.positionCount;
+    shape.texcoordCount = shape_header.texcoordCount;
+    shape.normalCount = shape_header.normalCount;
+    shape.indexCount = shape_header.indexCount;
+    shape.positions = reinterpret_cast<const float *>(file.data() + offset);
+    offset += shape.positionCount * sizeof(float);
+    shape.texcoords = reinterpret_cast<const float *>(file.data() + offset);
+    offset += shape.texcoordCount * sizeof(float);
+    shape.normals = reinterpret_cast<const float *>(file.data() + offset);
+    offset += shape.normalCount * sizeof(float);
+    shape.indices = reinterpret_cast<const uint32_t *>(file.data() + offset);
+    offset += shape.indexCount * sizeof(uint32_t);
+    result.push_back(shape);
+  }
+
+  boundsMin = {header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]};
+  boundsMax = {header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]};
+  optimized = (header.flags & OptimizedFlag) != 0;
+  shapes = std::move(result);
+}
+
+bool ppgso::MeshCache::valid() const {
+  return !shapes.empty();
+}
+
+const std::vector<ppgso::MeshCache::Shape> &ppgso::MeshCache::getShapes() const {
+  return shapes;
+}
+
+void ppgso::MeshCache::write(const std::string &path, uint64_t sourceHash, const std::vector<tinyobj::shape_t> &shapes,
+                             bool optimized) {
+  Header header;
+  memcpy(header.magic, "PPGM", 4);
+  header.version = Version;
+  header.sourceHash = sourceHash;
+  header.flags = optimized ? OptimizedFlag : 0;
+  header.shapeCount = (uint32_t) shapes.size();
+
+  glm::vec3 min{std::numeric_limits<float>::max()}, max{std::numeric_limits<float>::lowest()};
+  for (auto &shape : shapes) {
+    auto &positions = shape.mesh.positions;
+    for (size_t i = 0; i + 2 < positions.size(); i += 3) {
+      glm::vec3 position{positions[i], positions[i + 1], positions[i + 2]};
+      min = glm::min(min, position);
+      max = glm::max(max, position);
+    }
+  }
+  if (min.x > max.x)
+    min = max = glm::vec3{0.0f};
+  for (int i = 0; i < 3; i++) {
+    header.boundsMin[i] = min[i];
+    header.boundsMax[i] = max[i];
+  }
+
+  // Write to a temporary file first so a crash never leaves a truncated cache behind,
+  // named per thread as the same file may be loaded by several jobs at once
+  auto temporary = path + ".tmp" + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+  {
+    std::ofstream output{temporary, std::ios::binary};
+    if (!output)
+      return;
+    output.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    for (auto &shape : shapes) {
+      ShapeHeader shape_header{(uint32_t) shape.mesh.positions.size(), (uint32_t) shape.mesh.texcoords.size(),
+                               (uint32_t) shape.mesh.normals.size(), (uint32_t) shape.mesh.indices.size()};
+      output.write(reinterpret_cast<const char *>(&shape_header), sizeof(shape_header));
+      output.write(reinterpret_cast<const char *>(shape.mesh.positions.data()), shape.mesh.positions.size() * sizeof(float));
+      output.write(reinterpret_cast<const char *>(shape.mesh.texcoords.data()), shape.mesh.texcoords.size() * sizeof(float));
+      output.write(reinterpret_cast<const char *>(shape.mesh.normals.data()), shape.mesh.normals.size() * sizeof(float));
+      output.write(reinterpret_cast<const char *>(shape.mesh.indices.data()), shape.mesh.indices.size() * sizeof(unsigned int));
+    }
+    if (!output) {
+      output.close();
+      std::remove(temporary.c_str());
+      return;
+    }
+  }
+  replaceFile(temporary, path);
+}
+
+bool ppgso::MeshCache::enabled() {
+  auto value = getenv("PPGSO_MESH_CACHE");
+  return !value || strcmp(value, "0") != 0;
+}
+
+std::string ppgso::MeshCache::path(const std::string &obj) {
+  return obj + ".meshcache";
+}
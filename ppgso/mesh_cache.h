@@ -0,0 +1,114 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "mapped_file.h"
+#include "tiny_obj_loader.h"
+
+namespace ppgso {
+
+  /*!
+   * Compact binary copy of a parsed Wavefront .obj file stored next to the source as "<obj>.meshcache".
+   *
+   * Layout: a Header, then for each shape a ShapeHeader followed by its positions, texture
+   * coordinates, normals (floats) and indices (uint32). All blocks are 4 byte aligned, so the
+   * arrays can be used in place from the memory mapping.
+   * Set the environment variable PPGSO_MESH_CACHE=0 to disable reading and writing caches.
+   */
+  class MeshCache {
+  public:
+    /*!
+     * View of one shape stored in the cache, pointers reference the mapped file.
+     */
+    struct Shape {
+      const float *positions = nullptr;
+      const float *texcoords = nullptr;
+      const float *normals = nullptr;
+      const uint32_t *indices = nullptr;
+      uint32_t positionCount = 0;  // Number of floats
+      uint32_t texcoordCount = 0;  // Number of floats
+      uint32_t normalCount = 0;    // Number of floats
+      uint32_t indexCount = 0;
+    };
+
+    /*!
+     * Map and validate a mesh cache file.
+     *
+     * @param path - Path of the cache file.
+     * @param sourceHash - Hash of the current .obj contents, a cache built from other contents is rejected.
+     */
+    MeshCache(const std::string &path, uint64_t sourceHash);
+
+    /*!
+     * Check if the cache exists, is well formed and matches the source.
+     *
+     * @return - True if the shapes can be used.
+     */
+    bool valid() const;
+
+    /*!
+     * Get the shapes stored in the cache.
+     *
+     * @return - Shape views valid for the lifetime of this object.
+     */
+    const std::vector<Shape> &getShapes() const;
+
+    // Axis aligned bounds of all positions in the mesh
+    glm::vec3 boundsMin{0.0f}, boundsMax{0.0f};
+
+    // True if the shapes were written after vertex cache optimization
+    bool optimized = false;
+
+    /*!
+     * Write parsed shapes to a cache file, failures are silently ignored.
+     *
+     * @param path - Path of the cache file.
+     * @param sourceHash - Hash of the .obj contents the shapes were parsed from.
+     * @param shapes - Shapes returned by tinyobj::LoadObj.
+     * @param optimized - Shapes were reordered by the mesh optimizer.
+     */
+    static void write(const std::string &path, uint64_t sourceHash, const std::vector<tinyobj::shape_t> &shapes,
+                      bool optimized = false);
+
+    /*!
+     * Check if mesh caching is enabled for this process.
+     *
+     * @return - False if PPGSO_MESH_CACHE is set to 0.
+     */
+    static bool enabled();
+
+    /*!
+     * Get the cache file path used for an .obj file.
+     *
+     * @param obj - Path to the source .obj file.
+     * @return - Path to the cache file.
+     */
+    static std::string path(const std::string &obj);
+
+  private:
+    struct Header {
+      char magic[4];
+      uint32_t version;
+      uint64_t sourceHash;
+      uint32_t flags;
+      uint32_t shapeCount;
+      float boundsMin[3];
+      float boundsMax[3];
+    };
+
+    struct ShapeHeader {
+      uint32_t positionCount;
+      uint32_t texcoordCount;
+      uint32_t normalCount;
+      uint32_t indexCount;
+    };
+
+    static constexpr uint32_t Version = 2;
+    static constexpr uint32_t OptimizedFlag = 1;
+
+    MappedFile file;
+    std::vector<Shape> shapes;
+  };
+}
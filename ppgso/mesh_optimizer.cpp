@@ -0,0 +1,360 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <glm/glm.hpp>
+
+#include "mesh_optimizer.h"
+
+// Forsyth scoring parameters, see "Linear-Speed Vertex Cache Optimisation"
+static const int CacheSize = 32;
+static const float CacheDecayPower = 1.5f;
+static const float LastTriangleScore = 0.75f;
+static const float ValenceBoostScale = 2.0f;
+static const float ValenceBoostPower = 0.5f;
+
+static float vertexScore(int cache_position, unsigned int remaining) {
+  // Vertices without remaining triangles are never needed again
+  if (remaining == 0)
+    return -1.0f;
+
+  float score = 0.0f;
+  if (cache_position >= 0) {
+    if (cache_position < 3) {
+      // The vertices of the last triangle get a fixed score to avoid strips
+      score = LastTriangleScore;
+    } else {
+      float scaler = 1.0f / (CacheSize - 3);
+      score = std::pow(1.0f - (cache_position - 3) * scaler, CacheDecayPower);
+    }
+  }
+
+  // Prefer vertices with few triangles left so they are finished quickly
+  score += ValenceBoostScale * std::pow((float) remaining, -ValenceBoostPower);
+  return score;
+}
+
+void ppgso::mesh_optimizer::optimizeVertexCache(unsigned int *indices, size_t index_count, size_t vertex_count) {
+  size_t triangle_count = index_count / 3;
+  if (triangle_count == 0)
+    return;
+
+  // Triangles using each vertex as one flat adjacency array
+  std::vector<unsigned int> offsets(vertex_count + 1, 0);
+  for (size_t i = 0; i < index_count; i++)
+    offsets[indices[i] + 1]++;
+  for (size_t v = 0; v < vertex_count; v++)
+    offsets[v + 1] += offsets[v];
+  std::vector<unsigned int> adjacency(index_count);
+  std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+  for (size_t i = 0; i < index_count; i++)
+    adjacency[fill[indices[i]]++] = (unsigned int) (i / 3);
+
+  std::vector<unsigned int> remaining(vertex_count);
+  std::vector<int> cache_position(vertex_count, -1);
+  std::vector<float> vertex_scores(vertex_count);
+  for (size_t v = 0; v < vertex_count; v++) {
+    remaining[v] = offsets[v + 1] - offsets[v];
+    vertex_scores[v] = vertexScore(-1, remaining[v]);
+  }
+
+  std::vector<float> triangle_scores(triangle_count);
+  std::vector<bool> emitted(triangle_count, false);
+  for (size_t t = 0; t < triangle_count; t++)
+    triangle_scores[t] = vertex_scores[indices[t * 3]] + vertex_scores[indices[t * 3 + 1]] +
+                         vertex_scores[indices[t * 3 + 2]];
+
+  std::vector<unsigned int> output;
+  output.reserve(index_count);
+
+  // LRU cache with room for the vertices of one extra triangle
+  std::vector<unsigned int> cache, next_cache;
+  cache.reserve(CacheSize + 3);
+  next_cache.reserve(CacheSize + 3);
+
+  size_t scan = 0;
+  auto best = (size_t) (std::max_element(triangle_scores.begin(), triangle_scores.end()) - triangle_scores.begin());
+
+  while (output.size() < index_count) {
+    // Emit the best triangle and remove it from the adjacency of its vertices
+    emitted[best] = true;
+    next_cache.clear();
+    for (int k = 0; k < 3; k++) {
+      auto v = indices[best * 3 + k];
+      output.push_back(v);
+      next_cache.push_back(v);
+
+      auto begin = adjacency.begin() + offsets[v];
+      auto end = begin + remaining[v];
+      std::iter_swap(std::find(begin, end, (unsigned int) best), end - 1);
+      remaining[v]--;
+    }
+    for (auto v : cache)
+      if (v != next_cache[0] && v != next_cache[1] && v != next_cache[2])
+        next_cache.push_back(v);
+    std::swap(cache, next_cache);
+
+    // Rescore vertices in the cache, the ones pushed out lose their cache bonus
+    for (size_t i = 0; i < cache.size(); i++) {
+      auto v = cache[i];
+      cache_position[v] = i < (size_t) CacheSize ? (int) i : -1;
+      vertex_scores[v] = vertexScore(cache_position[v], remaining[v]);
+    }
+
+    // Pick the next triangle among those touching the cache
+    float best_score = -1.0f;
+    best = triangle_count;
+    for (auto v : cache) {
+      for (unsigned int a = offsets[v]; a < offsets[v] + remaining[v]; a++) {
+        auto t = adjacency[a];
+        triangle_scores[t] = vertex_scores[indices[t * 3]] + vertex_scores[indices[t * 3 + 1]] +
+                             vertex_scores[indices[t * 3 + 2]];
+        if (triangle_scores[t] > best_score) {
+          best_score = triangle_scores[t];
+          best = t;
+        }
+      }
+    }
+    if (cache.size() > (size_t) CacheSize)
+      cache.resize(CacheSize);
+
+    // Nothing in the cache is usable, continue with the first triangle not emitted yet
+    if (best == triangle_count && output.size() < index_count) {
+      while (emitted[scan])
+        scan++;
+      best = scan;
+    }
+  }
+
+  std::copy(output.begin(), output.end(), indices);
+}
+
+std::vector<unsigned int> ppgso::mesh_optimizer::optimizeVertexFetch(unsigned int *indices, size_t index_count,
+                                                                     size_t vertex_count) {
+  const auto unused = (unsigned int) -1;
+  std::vector<unsigned int> remap(vertex_count, unused);
+  unsigned int next = 0;
+  for (size_t i = 0; i < index_count; i++) {
+    auto &target = remap[indices[i]];
+    if (target == unused)
+      target = next++;
+    indices[i] = target;
+  }
+  for (auto &target : remap)
+    if (target == unused)
+      target = next++;
+  return remap;
+}
+
+// Symmetric 4x4 error quadric of a set of planes, error(p) = p'Ap + 2b'p + c
+struct Quadric {
+  double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+  double b0 = 0, b1 = 0, b2 = 0, c = 0;
+
+  void addPlane(const glm::dvec3 &n, double d, double weight) {
+    a00 += weight * n.x * n.x; a01 += weight * n.x * n.y; a02 += weight * n.x * n.z;
+    a11 += weight * n.y * n.y; a12 += weight * n.y * n.z; a22 += weight * n.z * n.z;
+    b0 += weight * n.x * d; b1 += weight * n.y * d; b2 += weight * n.z * d;
+    c += weight * d * d;
+  }
+
+  Quadric &operator+=(const Quadric &q) {
+    a00 += q.a00; a01 += q.a01; a02 += q.a02; a11 += q.a11; a12 += q.a12; a22 += q.a22;
+    b0 += q.b0; b1 += q.b1; b2 += q.b2; c += q.c;
+    return *this;
+  }
+
+  double error(const glm::dvec3 &p) const {
+    double rx = a00 * p.x + a01 * p.y + a02 * p.z;
+    double ry = a01 * p.x + a11 * p.y + a12 * p.z;
+    double rz = a02 * p.x + a12 * p.y + a22 * p.z;
+    return p.x * rx + p.y * ry + p.z * rz + 2.0 * (b0 * p.x + b1 * p.y + b2 * p.z) + c;
+  }
+};
+
+struct Collapse {
+  double cost;
+  unsigned int from, to;
+
+  bool operator<(const Collapse &other) const {
+    return cost < other.cost;
+  }
+};
+
+static glm::dvec3 loadPosition(const float *positions, unsigned int v) {
+  return {positions[v * 3], positions[v * 3 + 1], positions[v * 3 + 2]};
+}
+
+static uint64_t edgeKey(unsigned int a, unsigned int b) {
+  return ((uint64_t) a << 32) | b;
+}
+
+size_t ppgso::mesh_optimizer::simplify(unsigned int *destination, const unsigned int *indices, size_t index_count,
+                                       const float *positions, size_t vertex_count, size_t target_index_count) {
+  std::vector<unsigned int> result(indices, indices + index_count);
+
+  // Weld vertices by exact position, unlocked vertices are then the only vertex at their position
+  struct PositionHash {
+    size_t operator()(const glm::vec3 &p) const {
+      uint32_t bits[3];
+      memcpy(bits, &p, sizeof(bits));
+      return (size_t) (bits[0] * 73856093u ^ bits[1] * 19349663u ^ bits[2] * 83492791u);
+    }
+  };
+  std::unordered_map<glm::vec3, unsigned int, PositionHash> first_at_position;
+  std::vector<unsigned int> weld(vertex_count), weld_count(vertex_count, 0);
+  for (unsigned int v = 0; v < vertex_count; v++) {
+    glm::vec3 p{positions[v * 3], positions[v * 3 + 1], positions[v * 3 + 2]};
+    weld[v] = first_at_position.emplace(p, v).first->second;
+    weld_count[weld[v]]++;
+  }
+
+  std::vector<bool> locked(vertex_count, false);
+  for (unsigned int v = 0; v < vertex_count; v++)
+    locked[v] = weld_count[weld[v]] > 1;
+
+  // Edges without an opposite half edge lie on an open border
+  std::unordered_set<uint64_t> half_edges;
+  for (size_t i = 0; i < index_count; i += 3)
+    for (int k = 0; k < 3; k++)
+      half_edges.insert(edgeKey(weld[indices[i + k]], weld[indices[i + (k + 1) % 3]]));
+  for (size_t i = 0; i < index_count; i += 3) {
+    for (int k = 0; k < 3; k++) {
+      auto a = indices[i + k], b = indices[i + (k + 1) % 3];
+      if (!half_edges.count(edgeKey(weld[b], weld[a])))
+        locked[a] = locked[b] = true;
+    }
+  }
+
+  // Area weighted plane quadrics of the triangles around each vertex
+  std::vector<Quadric> quadrics(vertex_count);
+  for (size_t i = 0; i < index_count; i += 3) {
+    auto p0 = loadPosition(positions, indices[i]);
+    auto n = glm::cross(loadPosition(positions, indices[i + 1]) - p0, loadPosition(positions, indices[i + 2]) - p0);
+    auto length = glm::length(n);
+    if (length == 0.0)
+      continue;
+    n /= length;
+    for (int k = 0; k < 3; k++)
+      quadrics[indices[i + k]].addPlane(n, -glm::dot(n, p0), length * 0.5);
+  }
+
+  std::vector<unsigned int> offsets, adjacency, remap(vertex_count);
+  std::vector<bool> touched(vertex_count);
+  std::vector<Collapse> collapses;
+
+  // Each pass collapses a batch of independent cheapest edges, then rebuilds the index list
+  while (result.size() > target_index_count) {
+    offsets.assign(vertex_count + 1, 0);
+    for (auto v : result)
+      offsets[v + 1]++;
+    for (size_t v = 0; v < vertex_count; v++)
+      offsets[v + 1] += offsets[v];
+    adjacency.resize(result.size());
+    std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < result.size(); i++)
+      adjacency[fill[result[i]]++] = (unsigned int) (i / 3);
+
+    // Collapsing "from" onto "to" keeps the position of "to", costing the error of the merged quadric there
+    collapses.clear();
+    for (size_t i = 0; i < result.size(); i += 3) {
+      for (int k = 0; k < 3; k++) {
+        auto a = result[i + k], b = result[i + (k + 1) % 3];
+        Quadric q;
+        if (!locked[a]) {
+          q = quadrics[a];
+          q += quadrics[b];
+          collapses.push_back({q.error(loadPosition(positions, b)), a, b});
+        }
+        if (!locked[b]) {
+          q = quadrics[b];
+          q += quadrics[a];
+          collapses.push_back({q.error(loadPosition(positions, a)), b, a});
+        }
+      }
+    }
+    std::sort(collapses.begin(), collapses.end());
+
+    for (unsigned int v = 0; v < vertex_count; v++)
+      remap[v] = v;
+    touched.assign(vertex_count, false);
+
+    size_t needed = (result.size() - target_index_count + 2) / 3, removed = 0, applied = 0;
+    for (auto &collapse : collapses) {
+      auto a = collapse.from, b = collapse.to;
+      if (touched[a] || touched[b])
+        continue;
+
+      // Reject collapses that flip a remaining triangle around "from"
+      bool flips = false;
+      size_t degenerate = 0;
+      for (auto i = offsets[a]; i < offsets[a + 1] && !flips; i++) {
+        auto t = adjacency[i] * 3;
+        auto v0 = result[t], v1 = result[t + 1], v2 = result[t + 2];
+        if (v0 == b || v1 == b || v2 == b) {
+          degenerate++;
+          continue;
+        }
+        auto p0 = loadPosition(positions, v0), p1 = loadPosition(positions, v1), p2 = loadPosition(positions, v2);
+        auto before = glm::cross(p1 - p0, p2 - p0);
+        auto target = loadPosition(positions, b);
+        if (v0 == a) p0 = target;
+        if (v1 == a) p1 = target;
+        if (v2 == a) p2 = target;
+        flips = glm::dot(before, glm::cross(p1 - p0, p2 - p0)) <= 0.0;
+      }
+      if (flips)
+        continue;
+
+      // Neighbors keep their triangles fixed for the rest of the pass so flip checks stay exact
+      for (auto i = offsets[a]; i < offsets[a + 1]; i++) {
+        auto t = adjacency[i] * 3;
+        touched[result[t]] = touched[result[t + 1]] = touched[result[t + 2]] = true;
+      }
+      touched[b] = true;
+      remap[a] = b;
+      quadrics[b] += quadrics[a];
+      applied++;
+
+      removed += degenerate;
+      if (removed >= needed)
+        break;
+    }
+    if (applied == 0)
+      break;
+
+    size_t count = 0;
+    for (size_t i = 0; i < result.size(); i += 3) {
+      auto v0 = remap[result[i]], v1 = remap[result[i + 1]], v2 = remap[result[i + 2]];
+      if (v0 == v1 || v1 == v2 || v0 == v2)
+        continue;
+      result[count++] = v0;
+      result[count++] = v1;
+      result[count++] = v2;
+    }
+    result.resize(count);
+  }
+
+  std::copy(result.begin(), result.end(), destination);
+  return result.size();
+}
+
+float ppgso::mesh_optimizer::computeACMR(const unsigned int *indices, size_t index_count, size_t vertex_count,
+                                         size_t cache_size) {
+  if (index_count < 3)
+    return 0.0f;
+
+  // FIFO cache, a vertex is in the cache if it was inserted within the last cache_size misses
+  std::vector<size_t> inserted(vertex_count, 0);
+  size_t misses = 0;
+  for (size_t i = 0; i < index_count; i++) {
+    auto v = indices[i];
+    if (inserted[v] == 0 || misses - inserted[v] + 1 > cache_size) {
+      misses++;
+      inserted[v] = misses;
+    }
+  }
+  return (float) misses / (float) (index_count / 3);
+}
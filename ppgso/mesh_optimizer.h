@@ -0,0 +1,76 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+namespace ppgso {
+
+  /*!
+   * Load time optimizations of indexed triangle lists.
+   */
+  namespace mesh_optimizer {
+
+    /*!
+     * Reorder triangles to improve post-transform vertex cache hits (Forsyth's linear-speed algorithm).
+     *
+     * @param indices - Triangle list indices, reordered in place.
+     * @param index_count - Number of indices, a multiple of 3.
+     * @param vertex_count - Number of vertices the indices refer to.
+     */
+    void optimizeVertexCache(unsigned int *indices, size_t index_count, size_t vertex_count);
+
+    /*!
+     * Compute a vertex order following the first use of each vertex by the indices.
+     * Vertices are then fetched from memory mostly sequentially while drawing.
+     * Unreferenced vertices keep their relative order at the end.
+     *
+     * @param indices - Triangle list indices, rewritten to refer to the new vertex order.
+     * @param index_count - Number of indices.
+     * @param vertex_count - Number of vertices the indices refer to.
+     * @return - Remap table, new position of each old vertex, for use with remapVertices.
+     */
+    std::vector<unsigned int> optimizeVertexFetch(unsigned int *indices, size_t index_count, size_t vertex_count);
+
+    /*!
+     * Reorder a vertex attribute array according to a remap table.
+     *
+     * @param data - Attribute array, each vertex occupies "stride" elements.
+     * @param stride - Number of elements per vertex.
+     * @param remap - Table returned by optimizeVertexFetch.
+     */
+    template<typename T>
+    void remapVertices(T *data, size_t stride, const std::vector<unsigned int> &remap) {
+      std::vector<T> copy(data, data + remap.size() * stride);
+      for (size_t i = 0; i < remap.size(); i++)
+        for (size_t c = 0; c < stride; c++)
+          data[remap[i] * stride + c] = copy[i * stride + c];
+    }
+
+    /*!
+     * Reduce the triangle count by collapsing edges in order of quadric error (Garland-Heckbert).
+     * Vertices are never moved or created, the result indexes the same vertex data.
+     * Vertices on open borders and on attribute seams (several vertices at one position) are locked.
+     *
+     * @param destination - Output indices, must have room for index_count indices.
+     * @param indices - Triangle list indices to simplify.
+     * @param index_count - Number of indices, a multiple of 3.
+     * @param positions - Vertex positions, 3 floats per vertex.
+     * @param vertex_count - Number of vertices.
+     * @param target_index_count - Stop once the result has at most this many indices.
+     * @return - Number of indices written, larger than the target if no more edges could be collapsed.
+     */
+    size_t simplify(unsigned int *destination, const unsigned int *indices, size_t index_count,
+                    const float *positions, size_t vertex_count, size_t target_index_count);
+
+    /*!
+     * Average cache miss ratio: transformed vertices per triangle with a FIFO cache.
+     * 3.0 means no reuse, well optimized meshes approach 0.5-0.7.
+     *
+     * @param indices - Triangle list indices.
+     * @param index_count - Number of indices.
+     * @param vertex_count - Number of vertices the indices refer to.
+     * @param cache_size - Number of entries in the simulated cache.
+     * @return - Transformed vertices per triangle.
+     */
+    float computeACMR(const unsigned int *indices, size_t index_count, size_t vertex_count, size_t cache_size = 16);
+  }
+}
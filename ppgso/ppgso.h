@@ -18,11 +18,24 @@ namespace ppgso {
 #endif
 }
 
+#include "bounds.h"
+#include "bvh.h"
+#include "render_queue.h"
+#include "state_cache.h"
+#include "entity_storage.h"
+#include "job_system.h"
+#include "asset_loader.h"
+#include "residency.h"
+#include "resource_cache.h"
 #include "shader.h"
+#include "shader_registry.h"
 #include "image.h"
 #include "image_bmp.h"
 #include "image_raw.h"
+#include "image_mipmap.h"
+#include "image_bc1.h"
 #include "texture.h"
+#include "uniform_buffer.h"
 #include "window.h"
 
 namespace ppgso {
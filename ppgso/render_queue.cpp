@@ -0,0 +1,76 @@
+#include <algorithm>
+
+#include "render_queue.h"
+#include "state_cache.h"
+
+// Number of bits of each field in the sort key
+static const int PassBits = 2, LayerBits = 4, ProgramBits = 10, TextureBits = 12, MeshBits = 12, DepthBits = 24;
+
+static uint64_t field(uint64_t value, int bits) {
+  return value & ((1ull << bits) - 1);
+}
+
+uint64_t ppgso::RenderQueue::makeKey(Pass pass, uint32_t program, uint32_t texture, uint32_t mesh, float depth) {
+  depth = std::min(std::max(depth, 0.0f), 1.0f);
+  auto fine = (uint64_t) (depth * ((1 << DepthBits) - 1));
+
+  uint64_t key = field(pass, PassBits);
+  if (pass == Translucent) {
+    // Far first: invert the depth and put it right after the pass
+    key = (key << DepthBits) | (((1ull << DepthBits) - 1) - fine);
+    key = (key << LayerBits) | 0;
+    key = (key << ProgramBits) | field(program, ProgramBits);
+    key = (key << TextureBits) | field(texture, TextureBits);
+    key = (key << MeshBits) | field(mesh, MeshBits);
+    return key;
+  }
+
+  key = (key << LayerBits) | (fine >> (DepthBits - LayerBits));
+  key = (key << ProgramBits) | field(program, ProgramBits);
+  key = (key << TextureBits) | field(texture, TextureBits);
+  key = (key << MeshBits) | field(mesh, MeshBits);
+  key = (key << DepthBits) | fine;
+  return key;
+}
+
+void ppgso::RenderQueue::clear() {
+  packets.clear();
+}
+
+void ppgso::RenderQueue::submit(uint64_t key, const RenderState &state, uint32_t item) {
+  packets.push_back({key, state, item});
+}
+
+void ppgso::RenderQueue::sort() {
+  scratch.resize(packets.size());
+  for (int shift = 0; shift < 64; shift += 8) {
+    size_t counts[256] = {};
+    for (auto &packet : packets)
+      counts[(packet.key >> shift) & 0xFF]++;
+
+    // Every key has the same byte here, nothing to reorder
+    if (packets.empty() || counts[(packets[0].key >> shift) & 0xFF] == packets.size())
+      continue;
+
+    size_t offset = 0;
+    for (auto &count : counts) {
+      auto next = offset + count;
+      count = offset;
+      offset = next;
+    }
+    for (auto &packet : packets)
+      scratch[counts[(packet.key >> shift) & 0xFF]++] = packet;
+    std::swap(packets, scratch);
+  }
+}
+
+const ppgso::RenderQueue::Statistics &ppgso::RenderQueue::getStatistics() const {
+  return statistics;
+}
+
+void ppgso::RenderQueue::apply(const RenderState &state) {
+  statistics.stateChanges += StateCache::enable(GL_CULL_FACE, state.cullFace);
+  statistics.stateChanges += StateCache::enable(GL_BLEND, state.blend);
+  statistics.stateChanges += StateCache::blendFunc(state.blendSource, state.blendDestination);
+  statistics.stateChanges += StateCache::depthFunc(state.depthFunc);
+}
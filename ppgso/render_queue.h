@@ -0,0 +1,115 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace ppgso {
+
+  /*!
+   * Fixed function state a draw depends on, applied by RenderQueue before the draw.
+   */
+  struct RenderState {
+    bool cullFace = true;
+    bool blend = false;
+    GLenum blendSource = GL_SRC_ALPHA;
+    GLenum blendDestination = GL_ONE_MINUS_SRC_ALPHA;
+    GLenum depthFunc = GL_LESS;
+  };
+
+  /*!
+   * Per-frame list of draws sorted by a 64-bit key to minimize state changes.
+   *
+   * Users submit a key, the state the draw needs and an item index identifying the draw,
+   * then execute the queue with a callback drawing one item. State is applied through
+   * StateCache, so only the state that differs from the previous draw reaches the driver.
+   * Storage is kept between frames.
+   */
+  class RenderQueue {
+  public:
+    // Passes are drawn in this order
+    enum Pass : uint64_t {
+      Opaque = 0,       // Grouped by resources, roughly front to back
+      Background = 1,   // Drawn after opaque geometry so it is hidden by the depth test
+      Translucent = 2,  // Strictly back to front
+    };
+
+    /*!
+     * Counters of the last execute call
+     */
+    struct Statistics {
+      size_t packets = 0;
+      size_t stateChanges = 0;  // State calls issued, redundant ones are skipped by StateCache
+    };
+
+    /*!
+     * Build a sort key.
+     *
+     * Opaque and background keys order by a coarse depth layer, then program, texture and mesh,
+     * then fine depth, so draws sharing resources are adjacent while near layers still go first.
+     * Translucent keys order by decreasing depth only, the resources just break ties.
+     *
+     * @param pass - Pass of the draw.
+     * @param program - Shader program identifier, 10 bits are used.
+     * @param texture - Texture identifier, 12 bits are used.
+     * @param mesh - Mesh identifier, 12 bits are used.
+     * @param depth - Distance from the camera normalized to 0-1.
+     * @return - Key for submit.
+     */
+    static uint64_t makeKey(Pass pass, uint32_t program, uint32_t texture, uint32_t mesh, float depth);
+
+    /*!
+     * Remove all submitted draws, keeping the allocated storage.
+     */
+    void clear();
+
+    /*!
+     * Add a draw to the queue.
+     *
+     * @param key - Sort key from makeKey.
+     * @param state - State the draw requires.
+     * @param item - Identifier passed back to the draw callback.
+     */
+    void submit(uint64_t key, const RenderState &state, uint32_t item);
+
+    /*!
+     * Sort the submitted draws by key with a stable LSD radix sort.
+     */
+    void sort();
+
+    /*!
+     * Draw all submitted items in order. Afterwards the default RenderState is restored.
+     *
+     * @param draw - Callback taking the item index of a draw.
+     */
+    template<typename Draw>
+    void execute(Draw &&draw) {
+      statistics = Statistics{};
+      statistics.packets = packets.size();
+      for (auto &packet : packets) {
+        apply(packet.state);
+        draw(packet.item);
+      }
+      apply(RenderState{});
+    }
+
+    /*!
+     * Get counters of the last execute.
+     *
+     * @return - Statistics of the last executed frame.
+     */
+    const Statistics &getStatistics() const;
+
+  private:
+    struct Packet {
+      uint64_t key;
+      RenderState state;
+      uint32_t item;
+    };
+
+    std::vector<Packet> packets, scratch;
+    Statistics statistics;
+
+    void apply(const RenderState &state);
+  };
+}
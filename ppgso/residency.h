@@ -0,0 +1,22 @@
+#pragma once
+#include <cstddef>
+
+namespace ppgso {
+
+  /*!
+   * Where the data of a mesh or texture is kept once it is loaded.
+   */
+  enum class Residency {
+    GpuOnly,    // CPU copies are freed after the upload
+    CpuAndGpu,  // The CPU copy is kept, to be read back or modified and uploaded again
+    CpuOnly     // Nothing is uploaded, for tools running without an OpenGL context
+  };
+
+  /*!
+   * Memory held by one resource.
+   */
+  struct ResidentBytes {
+    size_t cpu = 0;
+    size_t gpu = 0;  // Size of the uploaded data, drivers may pad it
+  };
+}
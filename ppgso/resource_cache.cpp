@@ -0,0 +1,99 @@
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+
+#include "resource_cache.h"
+#include "hash.h"
+
+std::unordered_map<uint64_t, ppgso::ResourceCache::Entry<ppgso::ResourceCache::Mesh>> &ppgso::ResourceCache::meshes() {
+  // Function local so objects with static resources can use the cache during static initialization
+  static std::unordered_map<uint64_t, Entry<Mesh>> cache;
+  return cache;
+}
+
+std::unordered_map<uint64_t, ppgso::ResourceCache::Entry<ppgso::Texture>> &ppgso::ResourceCache::textures() {
+  static std::unordered_map<uint64_t, Entry<Texture>> cache;
+  return cache;
+}
+
+std::shared_ptr<ppgso::ResourceCache::Mesh> ppgso::ResourceCache::getMesh(const std::string &obj, const MeshOptions &options) {
+  return getMesh(obj, options, [&] { return std::make_shared<Mesh>(obj, options); });
+}
+
+std::shared_ptr<ppgso::ResourceCache::Mesh> ppgso::ResourceCache::getMesh(const std::string &obj, const MeshOptions &options,
+                                                                          const std::function<std::shared_ptr<Mesh>()> &create) {
+  // Hash the options field by field, the structure has padding and a vector
+  auto path = canonicalPath(obj);
+  auto key = hashData(path);
+  bool flags[] = {options.interleaved, options.halfTexCoords, options.packedNormals, options.shortIndices, options.optimize};
+  key = hashData(flags, sizeof(flags), key);
+  key = hashData(options.lodRatios.data(), options.lodRatios.size() * sizeof(float), key);
+  key = hashData(&options.lodDetail, sizeof(options.lodDetail), key);
+  key = hashData(&options.residency, sizeof(options.residency), key);
+
+  auto &entry = meshes()[key];
+  auto mesh = entry.resource.lock();
+  if (!mesh) {
+    mesh = create();
+    entry = {path, mesh};
+  }
+  return mesh;
+}
+
+std::shared_ptr<ppgso::Texture> ppgso::ResourceCache::getTexture(const std::string &bmp, const TextureOptions &options) {
+  return getTexture(bmp, options, [&] { return std::make_shared<Texture>(bmp, options); });
+}
+
+std::shared_ptr<ppgso::Texture> ppgso::ResourceCache::getTexture(const std::string &bmp, const TextureOptions &options,
+                                                                 const std::function<std::shared_ptr<Texture>()> &create) {
+  auto path = canonicalPath(bmp);
+  auto key = hashData(path);
+  key = hashData(&options.compress, sizeof(options.compress), key);
+  key = hashData(&options.residency, sizeof(options.residency), key);
+
+  auto &entry = textures()[key];
+  auto texture = entry.resource.lock();
+  if (!texture) {
+    texture = create();
+    entry = {path, texture};
+  }
+  return texture;
+}
+
+size_t ppgso::ResourceCache::size() {
+  size_t count = 0;
+  for (auto &entry : meshes())
+    if (!entry.second.resource.expired()) count++;
+  for (auto &entry : textures())
+    if (!entry.second.resource.expired()) count++;
+  return count;
+}
+
+std::vector<ppgso::ResourceCache::Usage> ppgso::ResourceCache::getUsage() {
+  std::vector<Usage> result;
+  for (auto &entry : meshes())
+    if (auto mesh = entry.second.resource.lock())
+      result.push_back({entry.second.path, mesh->getResidentBytes()});
+  for (auto &entry : textures())
+    if (auto texture = entry.second.resource.lock())
+      result.push_back({entry.second.path, texture->getResidentBytes()});
+
+  std::sort(result.begin(), result.end(), [](const Usage &a, const Usage &b) {
+    return a.bytes.cpu + a.bytes.gpu > b.bytes.cpu + b.bytes.gpu;
+  });
+  return result;
+}
+
+std::string ppgso::ResourceCache::canonicalPath(const std::string &path) {
+#ifdef _WIN32
+  char resolved[_MAX_PATH];
+  if (!_fullpath(resolved, path.c_str(), _MAX_PATH))
+    return path;
+  return resolved;
+#else
+  char resolved[PATH_MAX];
+  if (!realpath(path.c_str(), resolved))
+    return path;
+  return resolved;
+#endif
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "texture.h"
+#include "vertex_layout.h"
+
+#ifdef USE_ASSIMP
+  #include "Mesh_Assimp.h"
+#else
+  #include "Mesh_Tiny.h"
+#endif
+
+namespace ppgso {
+
+  /*!
+   * Process-wide cache of meshes and textures keyed by the canonical path of their file.
+   *
+   * Requesting a file that is already loaded returns the same object, so every file is parsed
+   * and uploaded once no matter how many classes use it. Meshes are additionally keyed by their
+   * MeshOptions and textures by their TextureOptions, as those change the GPU storage. Like the ShaderRegistry the cache only keeps
+   * weak references, a resource is deleted once its last user releases it. Only used from the
+   * thread owning the OpenGL context.
+   */
+  class ResourceCache {
+  public:
+#ifdef USE_ASSIMP
+    using Mesh = Mesh_Assimp;
+#else
+    using Mesh = Mesh_Tiny;
+#endif
+
+    /*!
+     * Get a shared mesh, loading the file on first use.
+     *
+     * @param obj - File path to the obj file.
+     * @param options - GPU storage formats of the geometry, see MeshOptions.
+     * @return - Shared mesh.
+     */
+    static std::shared_ptr<Mesh> getMesh(const std::string &obj, const MeshOptions &options = {});
+
+    /*!
+     * Get a shared mesh, calling create on first use so the caller decides how it is loaded.
+     *
+     * @param obj - File path to the obj file.
+     * @param options - GPU storage formats of the geometry, see MeshOptions.
+     * @param create - Function returning the new mesh.
+     * @return - Shared mesh.
+     */
+    static std::shared_ptr<Mesh> getMesh(const std::string &obj, const MeshOptions &options,
+                                         const std::function<std::shared_ptr<Mesh>()> &create);
+
+    /*!
+     * Get a shared texture of a BMP image, loading the file on first use.
+     *
+     * @param bmp - File path to a BMP image.
+     * @param options - Storage format, see TextureOptions.
+     * @return - Shared texture.
+     */
+    static std::shared_ptr<Texture> getTexture(const std::string &bmp, const TextureOptions &options = {});
+
+    /*!
+     * Get a shared texture, calling create on first use so the caller decides how it is loaded.
+     *
+     * @param bmp - File path to a BMP image.
+     * @param options - Storage format, see TextureOptions.
+     * @param create - Function returning the new texture.
+     * @return - Shared texture.
+     */
+    static std::shared_ptr<Texture> getTexture(const std::string &bmp, const TextureOptions &options,
+                                               const std::function<std::shared_ptr<Texture>()> &create);
+
+    /*!
+     * Get the number of meshes and textures currently alive in the cache.
+     *
+     * @return - Number of live resources.
+     */
+    static size_t size();
+
+    /*!
+     * Memory held by one live resource of the cache.
+     */
+    struct Usage {
+      std::string path;
+      ResidentBytes bytes;
+    };
+
+    /*!
+     * Get the memory held by every live mesh and texture in the cache.
+     *
+     * @return - One entry per resource, ordered by CPU plus GPU bytes, largest first.
+     */
+    static std::vector<Usage> getUsage();
+
+    /*!
+     * Get an absolute path without symbolic links, "." or ".." so different spellings of one file match.
+     *
+     * @param path - Path to a file.
+     * @return - Canonical path, or the path unchanged when the file does not exist.
+     */
+    static std::string canonicalPath(const std::string &path);
+
+  private:
+    template<typename T>
+    struct Entry {
+      std::string path;
+      std::weak_ptr<T> resource;
+    };
+
+    static std::unordered_map<uint64_t, Entry<Mesh>> &meshes();
+    static std::unordered_map<uint64_t, Entry<Texture>> &textures();
+  };
+}
@@ -1,15 +1,56 @@
 #include <iostream>
 #include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <cstring>
+#include <cstdio>
+#include <functional>
+#include <thread>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
 
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "mapped_file.h"
 #include "texture.h"
 #include "shader.h"
+#include "state_cache.h"
+
+static void makeDirectory(const std::string &directory) {
+#ifdef _WIN32
+  _mkdir(directory.c_str());
+#else
+  mkdir(directory.c_str(), 0755);
+#endif
+}
+
+std::string ppgso::Shader::binaryCacheDirectory;
+ppgso::Shader::Statistics ppgso::Shader::statistics;
 
 
 ppgso::Shader::Shader(const std::string &vertex_shader_code, const std::string &fragment_shader_code) {
+  // Program binaries are only valid for the exact driver that produced them
+  std::string cache_file;
+  if (!binaryCacheDirectory.empty() && GLEW_ARB_get_program_binary)
+    cache_file = binaryCachePath(vertex_shader_code, fragment_shader_code);
+
+  program = cache_file.empty() ? 0 : loadBinary(cache_file);
+  if (!program) {
+    program = compileProgram(vertex_shader_code, fragment_shader_code, !cache_file.empty());
+    if (!cache_file.empty())
+      saveBinary(cache_file);
+  }
+
+  reflectUniforms();
+  use();
+}
+
+GLuint ppgso::Shader::compileProgram(const std::string &vertex_shader_code, const std::string &fragment_shader_code, bool retrievable) {
   // Create shaders
   auto vertex_shader_id = glCreateShader(GL_VERTEX_SHADER);
   auto fragment_shader_id = glCreateShader(GL_FRAGMENT_SHADER);
@@ -57,6 +98,8 @@ ppgso::Shader::Shader(const std::string &vertex_shader_code, const std::string &
   glAttachShader(program_id, vertex_shader_id);
   glAttachShader(program_id, fragment_shader_id);
   glBindFragDataLocation(program_id, 0, "FragmentColor");
+  if (retrievable)
+    glProgramParameteri(program_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
   glLinkProgram(program_id);
 
   // Check program log
@@ -73,50 +116,203 @@ ppgso::Shader::Shader(const std::string &vertex_shader_code, const std::string &
   glDeleteShader(vertex_shader_id);
   glDeleteShader(fragment_shader_id);
 
-  program = program_id;
-  use();
+  return program_id;
 }
 
 ppgso::Shader::~Shader() {
+  StateCache::forgetProgram(program);
   glDeleteProgram( program );
 }
 
+void ppgso::Shader::reflectUniforms() {
+  GLint count = 0, max_length = 0;
+  glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+  glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+
+  // Keep the table at most half full so probe sequences stay short
+  size_t size = 16;
+  while (size < (size_t) count * 4)
+    size *= 2;
+  uniforms.assign(size, UniformSlot{});
+
+  std::string name((size_t) max_length, '\0');
+  for (GLint i = 0; i < count; i++) {
+    GLsizei length = 0;
+    GLint array_size = 0;
+    GLenum type = 0;
+    glGetActiveUniform(program, (GLuint) i, max_length, &length, &array_size, &type, &name[0]);
+    auto uniform_name = name.substr(0, (size_t) length);
+
+    // Uniforms inside uniform blocks have no location
+    auto location = glGetUniformLocation(program, uniform_name.c_str());
+    if (location < 0)
+      continue;
+    insertUniform(uniform_name, location);
+
+    // Arrays are reported as "name[0]" but are usually set using just "name"
+    auto bracket = uniform_name.find('[');
+    if (bracket != std::string::npos)
+      insertUniform(uniform_name.substr(0, bracket), location);
+  }
+}
+
+void ppgso::Shader::insertUniform(const std::string &name, GLint location) {
+  auto hash = hashString(name.c_str());
+  auto mask = uniforms.size() - 1;
+  for (auto i = hash & mask;; i = (i + 1) & mask) {
+    auto &slot = uniforms[i];
+    if (slot.location < 0) {
+      slot.hash = hash;
+      slot.location = location;
+      slot.name = name;
+      return;
+    }
+  }
+}
+
 void ppgso::Shader::use() const {
-  glUseProgram(program);
+  // The state cache skips the bind when the program is already in use
+  if (StateCache::useProgram(program))
+    statistics.programBinds++;
+  else
+    statistics.programBindsSkipped++;
 }
 
 GLuint ppgso::Shader::getAttribLocation(const std::string &name) const {
-  use();
   return (GLuint) glGetAttribLocation(program, name.c_str());
 }
 
-GLuint ppgso::Shader::getUniformLocation(const std::string &name) const {
-  use();
-  return (GLuint) glGetUniformLocation(program, name.c_str());
+GLint ppgso::Shader::getUniformLocation(UniformName name) const {
+  statistics.uniformLookups++;
+  auto mask = uniforms.size() - 1;
+  for (auto i = name.hash & mask;; i = (i + 1) & mask) {
+    auto &slot = uniforms[i];
+    if (slot.location < 0)
+      break;
+    if (slot.hash == name.hash && slot.name == name.name)
+      return slot.location;
+  }
+
+  // Not an active uniform, OpenGL silently ignores location -1
+  statistics.uniformMisses++;
+  return -1;
+}
+
+void ppgso::Shader::setUniformBlock(const std::string &name, GLuint binding) const {
+  auto index = glGetUniformBlockIndex(program, name.c_str());
+  if (index != GL_INVALID_INDEX)
+    glUniformBlockBinding(program, index, binding);
+}
+
+void ppgso::Shader::setBinaryCacheDirectory(const std::string &directory) {
+  binaryCacheDirectory = directory;
+  if (!directory.empty())
+    makeDirectory(directory);
+}
+
+std::string ppgso::Shader::binaryCachePath(const std::string &vertex_shader_code, const std::string &fragment_shader_code) {
+  auto key = hashData(vertex_shader_code);
+  key = hashData("\0", 1, key);
+  key = hashData(fragment_shader_code, key);
+  for (auto name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+    auto value = reinterpret_cast<const char *>(glGetString(name));
+    if (value) key = hashData(value, strlen(value), key);
+  }
+
+  std::stringstream path;
+  path << binaryCacheDirectory << "/" << std::hex << std::setw(16) << std::setfill('0') << key << ".bin";
+  return path.str();
+}
+
+GLuint ppgso::Shader::loadBinary(const std::string &path) {
+  std::ifstream file{path, std::ios::binary | std::ios::ate};
+  if (!file)
+    return 0;
+  auto size = (std::streamoff) file.tellg();
+  file.seekg(0);
+
+  BinaryHeader header;
+  if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)) || header.magic != BinaryHeader{}.magic)
+    return 0;
+
+  // The length is read from disk, a corrupted file must not make us allocate more than it holds
+  if (size < (std::streamoff) sizeof(header) || header.length > (uint64_t) (size - sizeof(header)))
+    return 0;
+  std::vector<char> binary(header.length);
+  if (!file.read(binary.data(), header.length))
+    return 0;
+
+  // Driver updates may reject the binary, the caller then compiles from source
+  auto program_id = glCreateProgram();
+  glProgramBinary(program_id, header.format, binary.data(), (GLsizei) header.length);
+  GLint result = GL_FALSE;
+  glGetProgramiv(program_id, GL_LINK_STATUS, &result);
+  if (result == GL_FALSE) {
+    glDeleteProgram(program_id);
+    return 0;
+  }
+  return program_id;
+}
+
+void ppgso::Shader::saveBinary(const std::string &path) const {
+  GLint length = 0;
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0)
+    return;
+
+  BinaryHeader header;
+  std::vector<char> binary((size_t) length);
+  glGetProgramBinary(program, length, nullptr, &header.format, binary.data());
+  header.length = (uint32_t) length;
+
+  // The cache is only an optimization, failing to write it is not an error. Write to a temporary
+  // file first so a crash never leaves a truncated binary behind, named per thread like the mesh cache
+  auto temporary = path + ".tmp" + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+  {
+    std::ofstream file{temporary, std::ios::binary};
+    if (!file)
+      return;
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(binary.data(), length);
+    if (!file) {
+      file.close();
+      std::remove(temporary.c_str());
+      return;
+    }
+  }
+  replaceFile(temporary, path);
+}
+
+const ppgso::Shader::Statistics &ppgso::Shader::getStatistics() {
+  return statistics;
+}
+
+void ppgso::Shader::resetStatistics() {
+  statistics = Statistics{};
 }
 
-void ppgso::Shader::setUniform(const std::string &name, const Texture &texture, const int id) const {
+void ppgso::Shader::setUniform(UniformName name, const Texture &texture, const int id) const {
   use();
-  auto uniform = getUniformLocation(name.c_str());
+  auto uniform = getUniformLocation(name);
   glUniform1i(uniform, id);
   texture.bind(id);
 }
 
-void ppgso::Shader::setUniform(const std::string &name, glm::mat4 matrix) const {
+void ppgso::Shader::setUniform(UniformName name, glm::mat4 matrix) const {
   use();
-  auto uniform = getUniformLocation(name.c_str());
+  auto uniform = getUniformLocation(name);
   glUniformMatrix4fv(uniform, 1, GL_FALSE, value_ptr(matrix));
 }
 
-void ppgso::Shader::setUniform(const std::string &name, glm::mat3 matrix) const {
+void ppgso::Shader::setUniform(UniformName name, glm::mat3 matrix) const {
   use();
-  auto uniform = getUniformLocation(name.c_str());
+  auto uniform = getUniformLocation(name);
   glUniformMatrix3fv(uniform, 1, GL_FALSE, value_ptr(matrix));
 }
 
-void ppgso::Shader::setUniform(const std::string &name, float value) const {
+void ppgso::Shader::setUniform(UniformName name, float value) const {
   use();
-  auto uniform = getUniformLocation(name.c_str());
+  auto uniform = getUniformLocation(name);
   glUniform1f(uniform, value);
 }
 
@@ -124,20 +320,20 @@ GLuint ppgso::Shader::getProgram() const {
   return program;
 }
 
-void ppgso::Shader::setUniform(const std::string &name, glm::vec2 vector) const {
+void ppgso::Shader::setUniform(UniformName name, glm::vec2 vector) const {
   use();
-  auto uniform = getUniformLocation(name.c_str());
+  auto uniform = getUniformLocation(name);
   glUniform2fv(uniform, 1, value_ptr(vector));
 }
 
-void ppgso::Shader::setUniform(const std::string &name, glm::vec3 vector) const {
+void ppgso::Shader::setUniform(UniformName name, glm::vec3 vector) const {
   use();
-  auto uniform = getUniformLocation(name.c_str());
+  auto uniform = getUniformLocation(name);
   glUniform3fv(uniform, 1, value_ptr(vector));
 }
 
-void ppgso::Shader::setUniform(const std::string &name, glm::vec4 vector) const {
+void ppgso::Shader::setUniform(UniformName name, glm::vec4 vector) const {
   use();
-  auto uniform = getUniformLocation(name.c_str());
+  auto uniform = getUniformLocation(name);
   glUniform4fv(uniform, 1, value_ptr(vector));
 }
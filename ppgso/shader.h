@@ -1,17 +1,44 @@
 #pragma once
 #include <string>
 #include <memory>
+#include <vector>
 
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 
 #include "texture.h"
+#include "hash.h"
 
 namespace ppgso {
 
+  /*!
+   * Name of a shader uniform together with its precomputed hash.
+   *
+   * Constructed implicitly from string literals or std::string so uniform lookups
+   * in Shader never need to allocate a temporary string.
+   */
+  class UniformName {
+  public:
+    constexpr UniformName(const char *name) : name{name}, hash{hashString(name)} {}
+    UniformName(const std::string &name) : name{name.c_str()}, hash{hashString(name.c_str())} {}
+
+    const char *name;
+    uint32_t hash;
+  };
+
   class Shader {
   public:
 
+    /*!
+     * Per frame counters of uniform lookups and program binds across all shaders.
+     */
+    struct Statistics {
+      unsigned long uniformLookups = 0;  // Cached uniform location lookups
+      unsigned long uniformMisses = 0;   // Lookups of names that are not active in the program
+      unsigned long programBinds = 0;    // Issued glUseProgram calls
+      unsigned long programBindsSkipped = 0; // use() calls with the program already bound
+    };
+
     /*!
      * Compile and manage an GLSL program and its inputs.
      *
@@ -37,11 +64,12 @@ namespace ppgso {
 
     /*!
      * Get OpenGL uniform location for for the input specified by "name"
+     * Locations of all active uniforms are cached after linking, so this does not query OpenGL.
      *
      * @param name - Name of the shader program input variable.
-     * @return - OpenGL attribute location number.
+     * @return - OpenGL uniform location number, -1 if the uniform is not active.
      */
-    GLuint getUniformLocation(const std::string &name) const;
+    GLint getUniformLocation(UniformName name) const;
 
     /*!
      * Get OpenGL program identifier number.
@@ -56,7 +84,7 @@ namespace ppgso {
      * @param name - Name of the shader program uniform input variable.
      * @param value - Value to set input to.
      */
-    void setUniform(const std::string &name, float value) const;
+    void setUniform(UniformName name, float value) const;
 
     /*!
      * Set a vector as an input for the shader program variable "name"
@@ -64,7 +92,7 @@ namespace ppgso {
      * @param name - Name of the shader program uniform input variable.
      * @param vector - Vector to set input to.
      */
-    void setUniform(const std::string &name, glm::vec2 vector) const;
+    void setUniform(UniformName name, glm::vec2 vector) const;
 
     /*!
      * Set a vector as an input for the shader program variable "name"
@@ -72,7 +100,7 @@ namespace ppgso {
      * @param name - Name of the shader program uniform input variable.
      * @param vector - Vector to set input to.
      */
-    void setUniform(const std::string &name, glm::vec3 vector) const;
+    void setUniform(UniformName name, glm::vec3 vector) const;
 
     /*!
      * Set a vector as an input for the shader program variable "name"
@@ -80,7 +108,7 @@ namespace ppgso {
      * @param name - Name of the shader program uniform input variable.
      * @param vector - Vector to set input to.
      */
-    void setUniform(const std::string &name, glm::vec4 vector) const;
+    void setUniform(UniformName name, glm::vec4 vector) const;
 
     /*!
      * Set texture as an input for the shader program variable "name"
@@ -90,7 +118,7 @@ namespace ppgso {
      * @param texture - Texture to set input to.task6_bezier_surface
      * @param id - Texture ID to use when multi-texturing (0 is default).
      */
-    void setUniform(const std::string &name, const Texture &texture, const int id = 0) const;
+    void setUniform(UniformName name, const Texture &texture, const int id = 0) const;
 
     /*!
      * Set matrix as an input for the shader program variable "name"
@@ -98,7 +126,7 @@ namespace ppgso {
      * @param name - Name of the shader program uniform input variable.
      * @param matrix - Matrix to set input to.
      */
-    void setUniform(const std::string &name, glm::mat4 matrix) const;
+    void setUniform(UniformName name, glm::mat4 matrix) const;
 
     /*!
      * Set matrix as an input for the shader program variable "name"
@@ -106,10 +134,71 @@ namespace ppgso {
      * @param name - Name of the shader program uniform input variable.
      * @param matrix - Matrix to set input to.
      */
-    void setUniform(const std::string &name, glm::mat3 matrix) const;
+    void setUniform(UniformName name, glm::mat3 matrix) const;
+
+    /*!
+     * Connect the uniform block "name" to a uniform buffer binding point.
+     * Does nothing if the program does not use the block.
+     *
+     * @param name - Name of the uniform block in the shader program.
+     * @param binding - Uniform buffer binding point, see UniformBuffer.
+     */
+    void setUniformBlock(const std::string &name, GLuint binding) const;
+
+    /*!
+     * Enable the on-disk cache of linked program binaries for shaders created afterwards.
+     * Binaries are keyed by the shader sources and the GL vendor, renderer and version, so a
+     * driver change simply falls back to compiling from source. Requires ARB_get_program_binary.
+     *
+     * @param directory - Directory to store the binaries in, created if missing. Empty disables the cache.
+     */
+    static void setBinaryCacheDirectory(const std::string &directory);
+
+    /*!
+     * Get uniform lookup and program bind counters accumulated since the last reset.
+     *
+     * @return - Statistics shared by all shader programs.
+     */
+    static const Statistics &getStatistics();
+
+    /*!
+     * Reset the counters, usually once per frame.
+     */
+    static void resetStatistics();
 
   private:
+    struct UniformSlot {
+      uint32_t hash = 0;
+      GLint location = -1;
+      std::string name;
+    };
+
+    /*!
+     * Query active uniforms of the linked program and fill the location cache.
+     */
+    void reflectUniforms();
+
+    void insertUniform(const std::string &name, GLint location);
+
     GLuint program;
+
+    // Open addressing hash table of active uniform locations, size is a power of two
+    std::vector<UniformSlot> uniforms;
+
+    static std::string binaryCacheDirectory;
+
+    // File layout of a cached program binary, followed by "length" bytes of binary data
+    struct BinaryHeader {
+      uint32_t magic = 0x42475050;  // "PPGB"
+      GLenum format = 0;
+      uint32_t length = 0;
+    };
+
+    static GLuint compileProgram(const std::string &vertex_shader_code, const std::string &fragment_shader_code, bool retrievable);
+    static std::string binaryCachePath(const std::string &vertex_shader_code, const std::string &fragment_shader_code);
+    static GLuint loadBinary(const std::string &path);
+    void saveBinary(const std::string &path) const;
+    static Statistics statistics;
   };
 
 }
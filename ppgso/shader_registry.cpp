@@ -0,0 +1,30 @@
+#include "shader_registry.h"
+#include "hash.h"
+
+std::unordered_map<uint64_t, std::weak_ptr<ppgso::Shader>> &ppgso::ShaderRegistry::programs() {
+  // Function local so objects with static shaders can use the registry during static initialization
+  static std::unordered_map<uint64_t, std::weak_ptr<Shader>> registry;
+  return registry;
+}
+
+std::shared_ptr<ppgso::Shader> ppgso::ShaderRegistry::get(const std::string &vertex_shader_code, const std::string &fragment_shader_code) {
+  // Separate the two sources so moving text between stages changes the key
+  auto key = hashData(vertex_shader_code);
+  key = hashData("\0", 1, key);
+  key = hashData(fragment_shader_code, key);
+
+  auto &registry = programs();
+  auto shader = registry[key].lock();
+  if (!shader) {
+    shader = std::make_shared<Shader>(vertex_shader_code, fragment_shader_code);
+    registry[key] = shader;
+  }
+  return shader;
+}
+
+size_t ppgso::ShaderRegistry::size() {
+  size_t count = 0;
+  for (auto &entry : programs())
+    if (!entry.second.expired()) count++;
+  return count;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "shader.h"
+
+namespace ppgso {
+
+  /*!
+   * Process-wide registry of shader programs keyed by the hash of their sources.
+   *
+   * Requesting the same vertex and fragment source twice returns the same Shader, so every
+   * distinct program is compiled and linked once and objects can be grouped by program.
+   * The registry only keeps weak references; a program is deleted once its last user releases it.
+   */
+  class ShaderRegistry {
+  public:
+    /*!
+     * Get a shared shader program for the given sources, compiling it on first use.
+     *
+     * @param vertex_shader_code - Vertex shader source code.
+     * @param fragment_shader_code - Fragment shader source code.
+     * @return - Shared shader program.
+     */
+    static std::shared_ptr<Shader> get(const std::string &vertex_shader_code, const std::string &fragment_shader_code);
+
+    /*!
+     * Get the number of programs currently alive in the registry.
+     *
+     * @return - Number of live programs.
+     */
+    static size_t size();
+
+  private:
+    static std::unordered_map<uint64_t, std::weak_ptr<Shader>> &programs();
+  };
+}
@@ -0,0 +1,144 @@
+#include "state_cache.h"
+
+ppgso::StateCache::State ppgso::StateCache::state;
+ppgso::StateCache::Statistics ppgso::StateCache::statistics;
+
+bool ppgso::StateCache::count(bool issue) {
+  if (issue)
+    statistics.issued++;
+  else
+    statistics.avoided++;
+  return issue;
+}
+
+ppgso::StateCache::Flag *ppgso::StateCache::capabilityFlag(GLenum capability) {
+  switch (capability) {
+    case GL_BLEND:
+      return &state.blend;
+    case GL_CULL_FACE:
+      return &state.cullFace;
+    case GL_DEPTH_TEST:
+      return &state.depthTest;
+    default:
+      return nullptr;
+  }
+}
+
+bool ppgso::StateCache::useProgram(GLuint program) {
+  if (!count(!state.programValid || state.program != program))
+    return false;
+  glUseProgram(program);
+  state.program = program;
+  state.programValid = true;
+  return true;
+}
+
+bool ppgso::StateCache::bindVertexArray(GLuint vao) {
+  if (!count(!state.vaoValid || state.vao != vao))
+    return false;
+  glBindVertexArray(vao);
+  state.vao = vao;
+  state.vaoValid = true;
+  return true;
+}
+
+bool ppgso::StateCache::bindTexture(GLuint unit, GLenum target, GLuint texture) {
+  if (unit >= MaxTextureUnits) {
+    count(true);
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(target, texture);
+    state.activeUnit = unit;
+    state.activeUnitValid = true;
+    return true;
+  }
+
+  // The unit is selected even when the texture is already bound, callers modify the texture
+  // through the active unit right after binding it
+  if (!state.activeUnitValid || state.activeUnit != unit) {
+    glActiveTexture(GL_TEXTURE0 + unit);
+    state.activeUnit = unit;
+    state.activeUnitValid = true;
+    statistics.issued++;
+  }
+
+  auto &slot = state.units[unit];
+  if (!count(!slot.valid || slot.target != target || slot.texture != texture))
+    return false;
+
+  glBindTexture(target, texture);
+  slot.target = target;
+  slot.texture = texture;
+  slot.valid = true;
+  return true;
+}
+
+bool ppgso::StateCache::enable(GLenum capability, bool enabled) {
+  auto flag = capabilityFlag(capability);
+  auto wanted = enabled ? On : Off;
+  if (!count(!flag || *flag != wanted))
+    return false;
+  if (enabled)
+    glEnable(capability);
+  else
+    glDisable(capability);
+  if (flag)
+    *flag = wanted;
+  return true;
+}
+
+bool ppgso::StateCache::blendFunc(GLenum source, GLenum destination) {
+  if (!count(!state.blendFuncValid || state.blendSource != source || state.blendDestination != destination))
+    return false;
+  glBlendFunc(source, destination);
+  state.blendSource = source;
+  state.blendDestination = destination;
+  state.blendFuncValid = true;
+  return true;
+}
+
+bool ppgso::StateCache::depthFunc(GLenum func) {
+  if (!count(!state.depthFuncValid || state.depthFunc != func))
+    return false;
+  glDepthFunc(func);
+  state.depthFunc = func;
+  state.depthFuncValid = true;
+  return true;
+}
+
+bool ppgso::StateCache::depthMask(bool enabled) {
+  auto wanted = enabled ? On : Off;
+  if (!count(state.depthMask != wanted))
+    return false;
+  glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+  state.depthMask = wanted;
+  return true;
+}
+
+void ppgso::StateCache::forgetProgram(GLuint program) {
+  // glDeleteProgram keeps a bound program alive until it is unbound, so the binding is unknown
+  if (state.program == program)
+    state.programValid = false;
+}
+
+void ppgso::StateCache::forgetVertexArray(GLuint vao) {
+  if (state.vao == vao && state.vaoValid)
+    state.vao = 0;
+}
+
+void ppgso::StateCache::forgetTexture(GLuint texture) {
+  for (auto &unit : state.units)
+    if (unit.valid && unit.texture == texture)
+      unit.texture = 0;
+}
+
+void ppgso::StateCache::invalidate() {
+  state = State{};
+}
+
+const ppgso::StateCache::Statistics &ppgso::StateCache::getStatistics() {
+  return statistics;
+}
+
+void ppgso::StateCache::resetStatistics() {
+  statistics = Statistics{};
+}
@@ -0,0 +1,161 @@
+#pragma once
+#include <GL/glew.h>
+
+namespace ppgso {
+
+  /*!
+   * Shadow copy of the OpenGL state that changes between draws.
+   *
+   * Binds and toggles routed through the cache are only sent to the driver when they differ from
+   * the value last set. State that was never set through the cache, or was invalidated, is
+   * unknown and always issued. Code changing the same state with raw GL calls must call
+   * invalidate() afterwards.
+   */
+  class StateCache {
+  public:
+    // Texture units shadowed by the cache, binds on higher units are always issued
+    static const int MaxTextureUnits = 16;
+
+    /*!
+     * Per frame counters of state calls sent to the driver and skipped as redundant.
+     */
+    struct Statistics {
+      unsigned long issued = 0;
+      unsigned long avoided = 0;
+    };
+
+    /*!
+     * Bind a shader program.
+     *
+     * @param program - Program name, 0 to unbind.
+     * @return - True if the call was issued.
+     */
+    static bool useProgram(GLuint program);
+
+    /*!
+     * Bind a vertex array object.
+     *
+     * @param vao - Vertex array name, 0 to unbind.
+     * @return - True if the call was issued.
+     */
+    static bool bindVertexArray(GLuint vao);
+
+    /*!
+     * Bind a texture to a texture unit, selecting the unit only when it needs to change.
+     * The unit is left active afterwards, also when the bind itself was redundant.
+     *
+     * @param unit - Texture unit index, 0 for GL_TEXTURE0.
+     * @param target - Texture target such as GL_TEXTURE_2D.
+     * @param texture - Texture name, 0 to unbind.
+     * @return - True if the bind was issued.
+     */
+    static bool bindTexture(GLuint unit, GLenum target, GLuint texture);
+
+    /*!
+     * Enable or disable a capability. GL_BLEND, GL_CULL_FACE and GL_DEPTH_TEST are shadowed,
+     * other capabilities are passed through.
+     *
+     * @param capability - Capability to change.
+     * @param enabled - New state.
+     * @return - True if the call was issued.
+     */
+    static bool enable(GLenum capability, bool enabled);
+
+    /*!
+     * Set the blend function.
+     *
+     * @param source - Source factor.
+     * @param destination - Destination factor.
+     * @return - True if the call was issued.
+     */
+    static bool blendFunc(GLenum source, GLenum destination);
+
+    /*!
+     * Set the depth comparison function.
+     *
+     * @param func - Comparison function.
+     * @return - True if the call was issued.
+     */
+    static bool depthFunc(GLenum func);
+
+    /*!
+     * Enable or disable depth writes.
+     *
+     * @param enabled - New state.
+     * @return - True if the call was issued.
+     */
+    static bool depthMask(bool enabled);
+
+    /*!
+     * Drop a deleted object from the cache. GL unbinds deleted objects, so a new object reusing
+     * the name must not be mistaken for bound.
+     *
+     * @param program - Deleted program name.
+     */
+    static void forgetProgram(GLuint program);
+
+    /*!
+     * Drop a deleted vertex array from the cache.
+     *
+     * @param vao - Deleted vertex array name.
+     */
+    static void forgetVertexArray(GLuint vao);
+
+    /*!
+     * Drop a deleted texture from all texture units.
+     *
+     * @param texture - Deleted texture name.
+     */
+    static void forgetTexture(GLuint texture);
+
+    /*!
+     * Mark all shadowed state as unknown, for example after a context change or raw GL calls.
+     */
+    static void invalidate();
+
+    /*!
+     * Get counters since the last reset.
+     *
+     * @return - Issued and avoided calls.
+     */
+    static const Statistics &getStatistics();
+
+    /*!
+     * Reset counters, called once per frame.
+     */
+    static void resetStatistics();
+
+  private:
+    // Tri-state flag so state never set through the cache is treated as unknown
+    enum Flag : signed char {
+      Unknown = -1,
+      Off = 0,
+      On = 1,
+    };
+
+    struct TextureUnit {
+      GLenum target = 0;
+      GLuint texture = 0;
+      bool valid = false;
+    };
+
+    struct State {
+      GLuint program = 0, vao = 0;
+      bool programValid = false, vaoValid = false;
+
+      TextureUnit units[MaxTextureUnits];
+      GLuint activeUnit = 0;
+      bool activeUnitValid = false;
+
+      Flag blend = Unknown, cullFace = Unknown, depthTest = Unknown, depthMask = Unknown;
+      GLenum blendSource = 0, blendDestination = 0, depthFunc = 0;
+      bool blendFuncValid = false, depthFuncValid = false;
+    };
+
+    static State state;
+    static Statistics statistics;
+
+    static bool count(bool issue);
+    static Flag *capabilityFlag(GLenum capability);
+  };
+}
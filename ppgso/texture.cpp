@@ -1,53 +1,308 @@
+#include <algorithm>
 #include <iostream>
 
 #include "texture.h"
+#include "hash.h"
+#include "image_bc1.h"
+#include "image_bmp.h"
+#include "image_mipmap.h"
+#include "state_cache.h"
+
+ppgso::Texture::Texture() : image{0, 0} {
+  // Only reserve the name, storage is created once an image is set
+  glGenTextures(1, &texture);
+}
 
 ppgso::Texture::Texture(int width, int height) : image{width, height} {
+  glGenTextures(1, &texture);
   initGL();
-  update();
 }
 
 ppgso::Texture::Texture(Image&& image) : image{std::move(image)} {
+  glGenTextures(1, &texture);
   initGL();
-  update();
+}
+
+ppgso::Texture::Texture(const std::string &bmp, const TextureOptions &options) : image{0, 0}, texture{0} {
+  if (options.residency != Residency::CpuOnly)
+    glGenTextures(1, &texture);
+  upload(load(bmp, options));
 }
 
 ppgso::Texture::~Texture() {
+  setStreaming(0);
+  if (!texture)
+    return;
+  StateCache::forgetTexture(texture);
   glDeleteTextures(1, &texture);
 }
 
+ppgso::Texture::Data ppgso::Texture::load(const std::string &bmp, const TextureOptions &options) {
+  Data data;
+  data.residency = options.residency;
+  if (options.residency == Residency::CpuOnly) {
+    data.image = image::loadBMP(bmp);
+    return data;
+  }
+  data.format = options.compress && GLEW_EXT_texture_compression_s3tc ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_RGB8;
+
+  // The cache is only valid for the exact contents of the image
+  uint64_t source_hash = 0;
+  auto use_cache = TextureCache::enabled();
+  if (use_cache) {
+    MappedFile source{bmp};
+    use_cache = source.valid();
+    if (use_cache)
+      source_hash = hashData(source.data(), source.size());
+  }
+
+  // Upload straight from the mapped cache file
+  if (use_cache) {
+    std::unique_ptr<TextureCache> cache{new TextureCache{TextureCache::path(bmp), source_hash, data.format}};
+    if (cache->valid()) {
+      data.levels = cache->getLevels();
+      data.cache = std::move(cache);
+      if (options.residency != Residency::GpuOnly)
+        data.image = image::loadBMP(bmp);
+      return data;
+    }
+  }
+
+  // Build all levels, then place their payloads one after another
+  auto levels = image::buildMipChain(image::loadBMP(bmp));
+  if (options.residency != Residency::GpuOnly)
+    data.image = levels.front();
+  std::vector<std::vector<uint8_t>> blocks;
+  size_t total = 0;
+  for (auto &level : levels) {
+    if (data.format == GL_RGB8) {
+      total += level.getFramebuffer().size() * sizeof(Image::Pixel);
+    } else {
+      blocks.push_back(image::compressBC1(level));
+      total += blocks.back().size();
+    }
+  }
+
+  data.storage.resize(total);
+  size_t offset = 0;
+  for (size_t i = 0; i < levels.size(); i++) {
+    auto payload = data.format == GL_RGB8 ? (const uint8_t *) levels[i].getFramebuffer().data() : blocks[i].data();
+    auto size = data.format == GL_RGB8 ? levels[i].getFramebuffer().size() * sizeof(Image::Pixel) : blocks[i].size();
+    std::copy(payload, payload + size, data.storage.begin() + offset);
+
+    TextureCache::Level level;
+    level.width = (uint32_t) levels[i].width;
+    level.height = (uint32_t) levels[i].height;
+    level.data = data.storage.data() + offset;
+    level.size = (uint32_t) size;
+    data.levels.push_back(level);
+    offset += size;
+  }
+
+  if (use_cache)
+    TextureCache::write(TextureCache::path(bmp), source_hash, data.format, data.levels);
+  return data;
+}
+
 void ppgso::Texture::initGL() {
-  // Create new texture object
-  glGenTextures(1, &texture);
-  glBindTexture(GL_TEXTURE_2D, texture);
+  StateCache::bindTexture(0, GL_TEXTURE_2D, texture);
+
+  // Reserve texture storage for the whole mip chain
+  auto levels = image::mipLevelCount(image.width, image.height);
+  allocateStorage(levels, GL_RGB8, image.width, image.height);
+  setSamplerParameters();
+  allocated = true;
+  format = GL_RGB8;
+
+  gpuBytes = 0;
+  for (int level = 0; level < levels; level++)
+    gpuBytes += (size_t) std::max(1, image.width >> level) * std::max(1, image.height >> level) * sizeof(Image::Pixel);
+
+  // Update texture with data from image framebuffer
+  update();
+}
 
-  // Reserve texture storage
-  glTexStorage2D(GL_TEXTURE_2D, 3, GL_RGB8, image.width, image.height);
+void ppgso::Texture::allocateStorage(GLsizei levels, GLenum format, int width, int height) {
+  if (GLEW_VERSION_4_2 || GLEW_ARB_texture_storage) {
+    glTexStorage2D(GL_TEXTURE_2D, levels, format, width, height);
+    return;
+  }
 
+  // Without immutable storage every level is specified on its own, limited to the levels that exist
+  for (GLint level = 0; level < levels; level++) {
+    auto level_width = std::max(1, width >> level);
+    auto level_height = std::max(1, height >> level);
+    if (format == GL_RGB8)
+      glTexImage2D(GL_TEXTURE_2D, level, GL_RGB8, level_width, level_height, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+    else
+      glCompressedTexImage2D(GL_TEXTURE_2D, level, format, level_width, level_height, 0,
+                             (GLsizei) image::bc1Size(level_width, level_height), nullptr);
+  }
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+}
+
+void ppgso::Texture::setSamplerParameters() {
   // Set up mipmapping
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+}
 
-  // Update texture with data from image framebuffer
-  update();
+void ppgso::Texture::recreate() {
+  // Immutable storage cannot be resized or change its format, a new texture object replaces it
+  StateCache::forgetTexture(texture);
+  glDeleteTextures(1, &texture);
+  glGenTextures(1, &texture);
+  allocated = false;
+}
+
+void ppgso::Texture::setImage(Image&& new_image) {
+  if (allocated && (new_image.width != image.width || new_image.height != image.height))
+    recreate();
+
+  image = std::move(new_image);
+  if (allocated)
+    update();
+  else
+    initGL();
+}
+
+void ppgso::Texture::upload(Data &&data) {
+  image = std::move(data.image);
+  if (data.residency == Residency::CpuOnly)
+    return;
+  if (allocated)
+    recreate();
+
+  auto &largest = data.levels.front();
+  StateCache::bindTexture(0, GL_TEXTURE_2D, texture);
+  allocateStorage((GLsizei) data.levels.size(), data.format, (int) largest.width, (int) largest.height);
+
+  // Levels are tightly packed, RGB rows are not padded to 4 bytes
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  gpuBytes = 0;
+  for (size_t i = 0; i < data.levels.size(); i++) {
+    auto &level = data.levels[i];
+    gpuBytes += level.size;
+    if (data.format == GL_RGB8)
+      glTexSubImage2D(GL_TEXTURE_2D, (GLint) i, 0, 0, level.width, level.height, GL_RGB, GL_UNSIGNED_BYTE, level.data);
+    else
+      glCompressedTexSubImage2D(GL_TEXTURE_2D, (GLint) i, 0, 0, level.width, level.height, data.format, level.size, level.data);
+  }
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+  setSamplerParameters();
+  allocated = true;
+  format = data.format;
 }
 
 void ppgso::Texture::update() {
+  update(0, 0, image.width, image.height);
+}
+
+void ppgso::Texture::update(int x, int y, int width, int height, bool mipmaps) {
+  x = std::max(x, 0);
+  y = std::max(y, 0);
+  width = std::min(width, image.width - x);
+  height = std::min(height, image.height - y);
+  if (width <= 0 || height <= 0)
+    return;
+
+  // Compressed blocks cannot be updated from RGB pixels, the edited image replaces them as RGB8 storage
+  if (format != GL_RGB8) {
+    recreate();
+    initGL();
+    return;
+  }
+
   bind();
-  // Upload texture to GPU
-  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, image.width, image.height, GL_RGB, GL_UNSIGNED_BYTE, image.getFramebuffer().data());
+  auto framebuffer = (const uint8_t *) image.getFramebuffer().data();
+  auto row_size = (size_t) width * sizeof(Image::Pixel);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+  // Copy the rows of the rectangle into the next pixel buffer of the ring
+  uint8_t *mapped = nullptr;
+  if (!streamBuffers.empty()) {
+    auto &stream = streamBuffers[nextStreamBuffer];
+    nextStreamBuffer = (nextStreamBuffer + 1) % streamBuffers.size();
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, stream.buffer);
+
+    // A buffer the GPU still reads from gets new memory, so mapping it never waits
+    auto bytes = row_size * height;
+    bool busy = stream.fence && glClientWaitSync(stream.fence, 0, 0) == GL_TIMEOUT_EXPIRED;
+    if (stream.fence) {
+      glDeleteSync(stream.fence);
+      stream.fence = nullptr;
+    }
+    if (busy || stream.size < bytes) {
+      stream.size = std::max(stream.size, bytes);
+      glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr) stream.size, nullptr, GL_STREAM_DRAW);
+    }
+
+    mapped = (uint8_t *) glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr) bytes,
+                                          GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (mapped) {
+      for (int row = 0; row < height; row++)
+        std::copy_n(framebuffer + ((size_t) (y + row) * image.width + x) * sizeof(Image::Pixel), row_size,
+                    mapped + row * row_size);
+      glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+      // Transfer from offset 0 of the bound buffer
+      glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+      stream.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  }
+
+  // Upload texture to GPU straight from the image, rows of the rectangle are image.width apart
+  if (!mapped) {
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, image.width);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RGB, GL_UNSIGNED_BYTE,
+                    framebuffer + ((size_t) y * image.width + x) * sizeof(Image::Pixel));
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+  }
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 
   // Re-generate mipmaps
+  mipmapsDirty = true;
+  if (mipmaps)
+    updateMipmaps();
+}
+
+void ppgso::Texture::updateMipmaps() {
+  if (!mipmapsDirty)
+    return;
+  bind();
   glGenerateMipmap(GL_TEXTURE_2D);
+  mipmapsDirty = false;
+}
+
+void ppgso::Texture::setStreaming(unsigned buffers) {
+  for (auto &stream : streamBuffers) {
+    if (stream.fence) glDeleteSync(stream.fence);
+    glDeleteBuffers(1, &stream.buffer);
+  }
+  streamBuffers.assign(buffers, {});
+  nextStreamBuffer = 0;
+
+  // Storage is created on the first update, sized by the updated rectangle
+  for (auto &stream : streamBuffers)
+    glGenBuffers(1, &stream.buffer);
 }
 
 void ppgso::Texture::bind(int id) const {
-  glActiveTexture((GLenum) (GL_TEXTURE0 + id));
-  glBindTexture(GL_TEXTURE_2D, texture);
+  StateCache::bindTexture((GLuint) id, GL_TEXTURE_2D, texture);
 }
 
 GLuint ppgso::Texture::getTexture() {
   return texture;
 }
+
+ppgso::ResidentBytes ppgso::Texture::getResidentBytes() const {
+  ResidentBytes bytes;
+  bytes.cpu = (size_t) image.width * image.height * sizeof(Image::Pixel);
+  bytes.gpu = gpuBytes;
+  return bytes;
+}
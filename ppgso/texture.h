@@ -7,12 +7,64 @@
 #include <GL/glew.h>
 
 #include "image.h"
+#include "residency.h"
+#include "texture_cache.h"
 
 namespace ppgso {
 
+  /*!
+   * Storage format of textures loaded from image files.
+   */
+  struct TextureOptions {
+    bool compress = false;  // BC1 (DXT1) blocks, 4 bits per pixel, ignored without EXT_texture_compression_s3tc
+
+    // Whether the decoded image stays in Texture::image after the upload
+    Residency residency = Residency::GpuOnly;
+
+    /*!
+     * Get options using block compression.
+     *
+     * @return - Options with compression enabled.
+     */
+    static TextureOptions compressed() {
+      TextureOptions options;
+      options.compress = true;
+      return options;
+    }
+  };
+
   class Texture {
   public:
 
+    /*!
+     * Mip levels of a texture prepared on the CPU and ready to be uploaded, see load.
+     */
+    struct Data {
+      GLenum format = GL_RGB8;
+      std::vector<TextureCache::Level> levels;  // Largest first, the data points into storage or the mapped cache
+      std::vector<uint8_t> storage;
+      std::unique_ptr<TextureCache> cache;
+      Residency residency = Residency::GpuOnly;
+      Image image{0, 0};  // Largest level as RGB pixels unless GPU only
+    };
+
+    /*!
+     * Decode a BMP image and build its full mip chain without touching OpenGL, so it can run on any thread.
+     *
+     * The levels are stored in a TextureCache next to the file and later loads use the
+     * mapped cache while the image contents are unchanged.
+     *
+     * @param bmp - File path to a BMP image.
+     * @param options - Storage format, see TextureOptions.
+     * @return - Levels to pass to upload.
+     */
+    static Data load(const std::string &bmp, const TextureOptions &options = {});
+
+    /*!
+     * Create a texture object without storage, it is sampled as black until setImage is called.
+     */
+    Texture();
+
     /*!
      * Create new empty texture and bind it to OpenGL.
      *
@@ -28,13 +80,66 @@ namespace ppgso {
      */
     Texture(Image&& image);
 
+    /*!
+     * Load a BMP image with all mip levels built on the CPU. A Residency::CpuOnly texture
+     * only decodes the image and never touches OpenGL.
+     *
+     * @param bmp - File path to a BMP image.
+     * @param options - Storage format, see TextureOptions.
+     */
+    Texture(const std::string &bmp, const TextureOptions &options = {});
+
     ~Texture();
 
     /*!
-     * Update the OpenGL texture in memory.
+     * Update the OpenGL texture in memory from the image and regenerate its mip levels.
      */
     void update();
 
+    /*!
+     * Upload a changed rectangle of the image. Only valid for textures created from an Image or
+     * loaded with Residency::CpuAndGpu. The first update of a compressed texture uploads the whole
+     * image into new GL_RGB8 storage, so getTexture changes.
+     *
+     * @param x - Left column of the rectangle.
+     * @param y - First row of the rectangle.
+     * @param width - Width of the rectangle in pixels, clipped to the image.
+     * @param height - Height of the rectangle in pixels, clipped to the image.
+     * @param mipmaps - Regenerate the mip levels now, otherwise they are left for updateMipmaps.
+     */
+    void update(int x, int y, int width, int height, bool mipmaps = true);
+
+    /*!
+     * Regenerate the mip levels if an update deferred it.
+     */
+    void updateMipmaps();
+
+    /*!
+     * Stream updates through a ring of pixel buffer objects. The image rows are copied into the
+     * next buffer and the transfer to the texture runs asynchronously while rendering continues.
+     * A buffer still in use by the GPU is orphaned instead of waited for.
+     *
+     * @param buffers - Number of buffers in the ring, 0 uploads directly from the image.
+     */
+    void setStreaming(unsigned buffers);
+
+    /*!
+     * Create storage for prepared levels and upload them, replacing the previous texture object.
+     * The storage is immutable with OpenGL 4.2 or ARB_texture_storage.
+     * The image is replaced by the pixels kept in the data, empty for Residency::GpuOnly.
+     *
+     * @param data - Levels returned by load.
+     */
+    void upload(Data &&data);
+
+    /*!
+     * Replace the image and upload it. A different size than the current storage creates
+     * a new OpenGL texture object, so getTexture changes.
+     *
+     * @param image - Image to use
+     */
+    void setImage(Image&& image);
+
     /*!
      * Get OpenGL texture identifier number.
      *
@@ -42,6 +147,13 @@ namespace ppgso {
      */
     GLuint getTexture();
 
+    /*!
+     * Get the memory held by the texture. Textures created from an Image keep it on the CPU.
+     *
+     * @return - Bytes of the image and of the OpenGL storage.
+     */
+    ResidentBytes getResidentBytes() const;
+
     /*!
      * Bind the OpenGL texture for use.
      *
@@ -52,7 +164,24 @@ namespace ppgso {
     Image image;
   private:
     void initGL();
+    // Storage for a full mip chain, immutable with OpenGL 4.2 or ARB_texture_storage
+    void allocateStorage(GLsizei levels, GLenum format, int width, int height);
+    void setSamplerParameters();
+    void recreate();
     GLuint texture;
+    bool allocated = false;
+    bool mipmapsDirty = false;
+    GLenum format = GL_RGB8;  // Internal format of the storage
+    size_t gpuBytes = 0;
+
+    // Pixel buffer ring of streamed updates, a fence marks the last transfer from each buffer
+    struct StreamBuffer {
+      GLuint buffer = 0;
+      GLsync fence = nullptr;
+      size_t size = 0;
+    };
+    std::vector<StreamBuffer> streamBuffers;
+    size_t nextStreamBuffer = 0;
   };
 }
 
@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <thread>
+
+#include <GL/glew.h>
+
+#include "texture_cache.h"
+#include "image_bc1.h"
+#include "image_mipmap.h"
+
+constexpr uint32_t ppgso::TextureCache::Version;
+
+// Larger than any OpenGL texture, also keeps the size computations below in range
+static const uint32_t MaxDimension = 65536;
+
+// Bytes a level of the given format and dimensions must hold, 0 for unknown formats
+static size_t levelSize(uint32_t format, uint32_t width, uint32_t height) {
+  if (format == GL_RGB8)
+    return (size_t) width * height * 3;
+  if (format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT)
+    return ppgso::image::bc1Size((int) width, (int) height);
+  return 0;
+}
+
+ppgso::TextureCache::TextureCache(const std::string &path, uint64_t sourceHash, uint32_t format) : file{path} {
+  if (!file.valid() || file.size() < sizeof(Header))
+    return;
+
+  Header header;
+  memcpy(&header, file.data(), sizeof(header));
+  if (memcmp(header.magic, "PPGT", 4) != 0 || header.version != Version || header.sourceHash != sourceHash ||
+      header.format != format || header.levelCount > 32)
+    return;
+
+  // Walk the level blocks, any truncation or a level that is not the next step of the mip chain
+  // invalidates the whole cache, the payloads are handed to OpenGL with the sizes implied by their dimensions
+  std::vector<Level> result;
+  size_t offset = sizeof(Header);
+  for (uint32_t i = 0; i < header.levelCount; i++) {
+    LevelHeader level_header;
+    if (offset + sizeof(level_header) > file.size())
+      return;
+    memcpy(&level_header, file.data() + offset, sizeof(level_header));
+    offset += sizeof(level_header);
+
+    if (offset + level_header.size > file.size())
+      return;
+
+    if (i == 0) {
+      if (level_header.width == 0 || level_header.height == 0 || level_header.width > MaxDimension ||
+          level_header.height > MaxDimension)
+        return;
+    } else if (level_header.width != std::max(1u, result.front().width >> i) ||
+               level_header.height != std::max(1u, result.front().height >> i)) {
+      return;
+    }
+    if (level_header.size != levelSize(format, level_header.width, level_header.height))
+      return;
+
+    Level level;
+    level.width = level_header.width;
+    level.height = level_header.height;
+    level.size = level_header.size;
+    level.data = file.data() + offset;
+    offset += level.size;
+    result.push_back(level);
+  }
+
+  if (result.empty() ||
+      result.size() != (size_t) image::mipLevelCount((int) result.front().width, (int) result.front().height))
+    return;
+  levels = std::move(result);
+}
+
+bool ppgso::TextureCache::valid() const {
+  return !levels.empty();
+}
+
+const std::vector<ppgso::TextureCache::Level> &ppgso::TextureCache::getLevels() const {
+  return levels;
+}
+
+void ppgso::TextureCache::write(const std::string &path, uint64_t sourceHash, uint32_t format,
+                                const std::vector<Level> &levels) {
+  Header header;
+  memcpy(header.magic, "PPGT", 4);
+  header.version = Version;
+  header.sourceHash = sourceHash;
+  header.format = format;
+  header.levelCount = (uint32_t) levels.size();
+
+  // Write to a temporary file first so a crash never leaves a truncated cache behind,
+  // named per thread as the same file may be loaded by several jobs at once
+  auto temporary = path + ".tmp" + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+  {
+    std::ofstream output{temporary, std::ios::binary};
+    if (!output)
+      return;
+    output.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    for (auto &level : levels) {
+      LevelHeader level_header{level.width, level.height, level.size};
+      output.write(reinterpret_cast<const char *>(&level_header), sizeof(level_header));
+      output.write(reinterpret_cast<const char *>(level.data), level.size);
+    }
+    if (!output) {
+      output.close();
+      std::remove(temporary.c_str());
+      return;
+    }
+  }
+  replaceFile(temporary, path);
+}
+
+bool ppgso::TextureCache::enabled() {
+  auto value = getenv("PPGSO_TEXTURE_CACHE");
+  return !value || strcmp(value, "0") != 0;
+}
+
+std::string ppgso::TextureCache::path(const std::string &image) {
+  return image + ".texcache";
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "mapped_file.h"
+
+namespace ppgso {
+
+  /*!
+   * Prebaked texture stored next to the source image as "<image>.texcache".
+   *
+   * Layout: a Header, then for each mip level from the largest down to 1x1 a LevelHeader
+   * followed by the payload of the level, either tightly packed RGB8 rows or compressed blocks.
+   * The payloads are uploaded directly from the memory mapping.
+   * Set the environment variable PPGSO_TEXTURE_CACHE=0 to disable reading and writing caches.
+   */
+  class TextureCache {
+  public:
+    /*!
+     * View of one mip level, the pointer references the mapped file or the memory passed to write.
+     */
+    struct Level {
+      uint32_t width = 0;
+      uint32_t height = 0;
+      const uint8_t *data = nullptr;
+      uint32_t size = 0;  // Number of bytes
+    };
+
+    /*!
+     * Map and validate a texture cache file.
+     *
+     * @param path - Path of the cache file.
+     * @param sourceHash - Hash of the current image contents, a cache built from other contents is rejected.
+     * @param format - OpenGL internal format the levels must be stored in.
+     */
+    TextureCache(const std::string &path, uint64_t sourceHash, uint32_t format);
+
+    /*!
+     * Check if the cache exists, is well formed and matches the source and format.
+     *
+     * @return - True if the levels can be used.
+     */
+    bool valid() const;
+
+    /*!
+     * Get the mip levels stored in the cache.
+     *
+     * @return - Level views valid for the lifetime of this object.
+     */
+    const std::vector<Level> &getLevels() const;
+
+    /*!
+     * Write mip levels to a cache file, failures are silently ignored.
+     *
+     * @param path - Path of the cache file.
+     * @param sourceHash - Hash of the image contents the levels were built from.
+     * @param format - OpenGL internal format of the payloads.
+     * @param levels - Mip levels, the largest first.
+     */
+    static void write(const std::string &path, uint64_t sourceHash, uint32_t format, const std::vector<Level> &levels);
+
+    /*!
+     * Check if texture caching is enabled for this process.
+     *
+     * @return - False if PPGSO_TEXTURE_CACHE is set to 0.
+     */
+    static bool enabled();
+
+    /*!
+     * Get the cache file path used for an image file.
+     *
+     * @param image - Path to the source image.
+     * @return - Path to the cache file.
+     */
+    static std::string path(const std::string &image);
+
+  private:
+    struct Header {
+      char magic[4];
+      uint32_t version;
+      uint64_t sourceHash;
+      uint32_t format;
+      uint32_t levelCount;
+    };
+
+    struct LevelHeader {
+      uint32_t width;
+      uint32_t height;
+      uint32_t size;
+    };
+
+    static constexpr uint32_t Version = 1;
+
+    MappedFile file;
+    std::vector<Level> levels;
+  };
+}
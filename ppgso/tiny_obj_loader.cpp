@@ -5,6 +5,8 @@
 //
 
 //
+// ppgso: Parse from a single buffer and deduplicate vertices with a hash table
+// ppgso: Parse large files in parallel chunks, export groups in parallel
 // version 0.9.14: Support specular highlight, bump, displacement and alpha
 // map(#53)
 // version 0.9.13: Report "Material file not found message" in `err`(#46)
@@ -34,14 +36,20 @@
 #include <cmath>
 #include <cstddef>
 #include <cctype>
+#include <climits>
 
 #include <string>
+#include <algorithm>
+#include <atomic>
+#include <thread>
 #include <vector>
 #include <map>
 #include <fstream>
 #include <sstream>
+#include <iterator>
 
 #include "tiny_obj_loader.h"
+#include "job_system.h"
 
 namespace tinyobj {
 
@@ -54,16 +62,8 @@ struct vertex_index {
   vertex_index(int vidx, int vtidx, int vnidx)
       : v_idx(vidx), vt_idx(vtidx), vn_idx(vnidx){};
 };
-// for std::map
-static inline bool operator<(const vertex_index &a, const vertex_index &b) {
-  if (a.v_idx != b.v_idx)
-    return (a.v_idx < b.v_idx);
-  if (a.vn_idx != b.vn_idx)
-    return (a.vn_idx < b.vn_idx);
-  if (a.vt_idx != b.vt_idx)
-    return (a.vt_idx < b.vt_idx);
-
-  return false;
+static inline bool operator==(const vertex_index &a, const vertex_index &b) {
+  return a.v_idx == b.v_idx && a.vt_idx == b.vt_idx && a.vn_idx == b.vn_idx;
 }
 
 struct obj_shape {
@@ -130,6 +130,20 @@ static inline int parseInt(const char *&token) {
 //  - s >= s_end.
 //  - parse failure.
 //
+static inline bool isDigit(const char c) { return (c >= '0') && (c <= '9'); }
+
+// pow(10.0, -n) with the values for short decimal fractions computed once.
+static inline double negativePow10(int n) {
+  static const struct table {
+    double values[24];
+    table() {
+      for (int i = 0; i < 24; i++)
+        values[i] = pow(10.0, -i);
+    }
+  } powers;
+  return n < 24 ? powers.values[n] : pow(10.0, -n);
+}
+
 static bool tryParseDouble(const char *s, const char *s_end, double *result) {
   if (s >= s_end) {
     return false;
@@ -164,13 +178,13 @@ static bool tryParseDouble(const char *s, const char *s_end, double *result) {
   if (*curr == '+' || *curr == '-') {
     sign = *curr;
     curr++;
-  } else if (isdigit(*curr)) { /* Pass through. */
+  } else if (isDigit(*curr)) { /* Pass through. */
   } else {
     goto fail;
   }
 
   // Read the integer part.
-  while ((end_not_reached = (curr != s_end)) && isdigit(*curr)) {
+  while ((end_not_reached = (curr != s_end)) && isDigit(*curr)) {
     mantissa *= 10;
     mantissa += *curr - 0x30;
     curr++;
@@ -188,9 +202,9 @@ static bool tryParseDouble(const char *s, const char *s_end, double *result) {
   if (*curr == '.') {
     curr++;
     read = 1;
-    while ((end_not_reached = (curr != s_end)) && isdigit(*curr)) {
+    while ((end_not_reached = (curr != s_end)) && isDigit(*curr)) {
       // NOTE: Don't use powf here, it will absolutely murder precision.
-      mantissa += (*curr - 0x30) * pow(10.0, -read);
+      mantissa += (*curr - 0x30) * negativePow10(read);
       read++;
       curr++;
     }
@@ -209,14 +223,14 @@ static bool tryParseDouble(const char *s, const char *s_end, double *result) {
     if ((end_not_reached = (curr != s_end)) && (*curr == '+' || *curr == '-')) {
       exp_sign = *curr;
       curr++;
-    } else if (isdigit(*curr)) { /* Pass through. */
+    } else if (isDigit(*curr)) { /* Pass through. */
     } else {
       // Empty E is not allowed.
       goto fail;
     }
 
     read = 0;
-    while ((end_not_reached = (curr != s_end)) && isdigit(*curr)) {
+    while ((end_not_reached = (curr != s_end)) && isDigit(*curr)) {
       exponent *= 10;
       exponent += *curr - 0x30;
       curr++;
@@ -228,19 +242,37 @@ static bool tryParseDouble(const char *s, const char *s_end, double *result) {
   }
 
 assemble:
-  *result =
-      (sign == '+' ? 1 : -1) * ldexp(mantissa * pow(5.0, exponent), exponent);
+  // pow(5, 0) and ldexp(x, 0) are exact, skip them for the common case
+  if (exponent == 0)
+    *result = (sign == '+' ? 1 : -1) * mantissa;
+  else
+    *result =
+        (sign == '+' ? 1 : -1) * ldexp(mantissa * pow(5.0, exponent), exponent);
   return true;
 fail:
   return false;
 }
+// Inline equivalents of strspn(token, " \t") and strcspn(token, " \t\r"),
+// the hot loops call them once per number.
+static inline const char *skipSpace(const char *token) {
+  while (isSpace(*token))
+    token++;
+  return token;
+}
+
+static inline const char *skipToken(const char *token) {
+  while (*token && !isSpace(*token) && *token != '\r')
+    token++;
+  return token;
+}
+
 static inline float parseFloat(const char *&token) {
-  token += strspn(token, " \t");
+  token = skipSpace(token);
 #ifdef TINY_OBJ_LOADER_OLD_FLOAT_PARSER
   float f = (float)atof(token);
-  token += strcspn(token, " \t\r");
+  token = skipToken(token);
 #else
-  const char *end = token + strcspn(token, " \t\r");
+  const char *end = skipToken(token);
   double val = 0.0;
   tryParseDouble(token, end, &val);
   float f = static_cast<float>(val);
@@ -261,13 +293,40 @@ static inline void parseFloat3(float &x, float &y, float &z,
   z = parseFloat(token);
 }
 
+// Same result as atoi() for indices that fit in an int, token is left after the digits
+static inline int parseIndex(const char *&token) {
+  while (isSpace(*token) || *token == '\n' || *token == '\r' || *token == '\v' || *token == '\f')
+    token++;
+  bool negative = *token == '-';
+  if (*token == '-' || *token == '+')
+    token++;
+  int value = 0;
+  while (isDigit(*token))
+    value = value * 10 + (*token++ - '0');
+  return negative ? -value : value;
+}
+
+// Equivalent of strcspn(token, "/ \t\r")
+static inline const char *skipIndex(const char *token) {
+  while (*token && *token != '/' && !isSpace(*token) && *token != '\r')
+    token++;
+  return token;
+}
+
+// Marks a texture coordinate or normal index missing from a face corner
+static const int INDEX_NONE = INT_MIN;
+
+// Face corner as written in the file, before resolving relative indices
+struct raw_index {
+  int v_idx, vt_idx, vn_idx;
+};
+
 // Parse triples: i, i/j/k, i//k, i/j
-static vertex_index parseTriple(const char *&token, int vsize, int vnsize,
-                                int vtsize) {
-  vertex_index vi(-1);
+static raw_index parseTriple(const char *&token) {
+  raw_index vi = {INDEX_NONE, INDEX_NONE, INDEX_NONE};
 
-  vi.v_idx = fixIndex(atoi(token), vsize);
-  token += strcspn(token, "/ \t\r");
+  vi.v_idx = parseIndex(token);
+  token = skipIndex(token);
   if (token[0] != '/') {
     return vi;
   }
@@ -276,61 +335,85 @@ static vertex_index parseTriple(const char *&token, int vsize, int vnsize,
   // i//k
   if (token[0] == '/') {
     token++;
-    vi.vn_idx = fixIndex(atoi(token), vnsize);
-    token += strcspn(token, "/ \t\r");
+    vi.vn_idx = parseIndex(token);
+    token = skipIndex(token);
     return vi;
   }
 
   // i/j/k or i/j
-  vi.vt_idx = fixIndex(atoi(token), vtsize);
-  token += strcspn(token, "/ \t\r");
+  vi.vt_idx = parseIndex(token);
+  token = skipIndex(token);
   if (token[0] != '/') {
     return vi;
   }
 
   // i/j/k
   token++; // skip '/'
-  vi.vn_idx = fixIndex(atoi(token), vnsize);
-  token += strcspn(token, "/ \t\r");
+  vi.vn_idx = parseIndex(token);
+  token = skipIndex(token);
   return vi;
 }
 
-static unsigned int
-updateVertex(std::map<vertex_index, unsigned int> &vertexCache,
-             std::vector<float> &positions, std::vector<float> &normals,
-             std::vector<float> &texcoords,
-             const std::vector<float> &in_positions,
-             const std::vector<float> &in_normals,
-             const std::vector<float> &in_texcoords, const vertex_index &i) {
-  const std::map<vertex_index, unsigned int>::iterator it = vertexCache.find(i);
-
-  if (it != vertexCache.end()) {
-    // found cache
-    return it->second;
+static const unsigned int CACHE_EMPTY = 0xffffffffu;
+
+// Open addressing table mapping vertex_index triples to output vertex numbers.
+// Vertices are numbered in order of first use, matching the order of the
+// original std::map based cache.
+class VertexCache {
+public:
+  // Forget all entries and prepare for up to "count" distinct vertices
+  void reset(size_t count) {
+    size_t size = 16;
+    while (size < count * 2)
+      size *= 2;
+    slots.assign(size, CACHE_EMPTY);
+    vertices.clear();
+    vertices.reserve(count);
   }
 
-  assert(in_positions.size() > (unsigned int)(3 * i.v_idx + 2));
-
-  positions.push_back(in_positions[3 * i.v_idx + 0]);
-  positions.push_back(in_positions[3 * i.v_idx + 1]);
-  positions.push_back(in_positions[3 * i.v_idx + 2]);
-
-  if (i.vn_idx >= 0) {
-    normals.push_back(in_normals[3 * i.vn_idx + 0]);
-    normals.push_back(in_normals[3 * i.vn_idx + 1]);
-    normals.push_back(in_normals[3 * i.vn_idx + 2]);
+  // Get the vertex number of "vi", adding it as a new vertex when not seen yet
+  unsigned int find(const vertex_index &vi) {
+    size_t mask = slots.size() - 1;
+    size_t slot = hash(vi) & mask;
+    while (slots[slot] != CACHE_EMPTY) {
+      if (vertices[slots[slot]] == vi)
+        return slots[slot];
+      slot = (slot + 1) & mask;
+    }
+    auto idx = static_cast<unsigned int>(vertices.size());
+    slots[slot] = idx;
+    vertices.push_back(vi);
+    return idx;
   }
 
-  if (i.vt_idx >= 0) {
-    texcoords.push_back(in_texcoords[2 * i.vt_idx + 0]);
-    texcoords.push_back(in_texcoords[2 * i.vt_idx + 1]);
+  // Distinct vertices in order of their vertex number
+  std::vector<vertex_index> vertices;
+
+private:
+  static inline size_t hash(const vertex_index &vi) {
+    unsigned int h = static_cast<unsigned int>(vi.v_idx);
+    h = h * 0x9e3779b1u + static_cast<unsigned int>(vi.vt_idx);
+    h = h * 0x9e3779b1u + static_cast<unsigned int>(vi.vn_idx);
+    h ^= h >> 15;
+    h *= 0x2c1b3c6du;
+    h ^= h >> 12;
+    return h;
   }
 
-  unsigned int idx = static_cast<unsigned int>(positions.size() / 3 - 1);
-  vertexCache[i] = idx;
+  std::vector<unsigned int> slots;
+};
 
-  return idx;
-}
+// Faces of the current group stored as one flat array of corners
+struct face_group {
+  std::vector<vertex_index> corners;
+  std::vector<unsigned int> sizes; // number of corners of each face
+
+  bool empty() const { return sizes.empty(); }
+  void clear() {
+    corners.clear();
+    sizes.clear();
+  }
+};
 
 void InitMaterial(material_t &material) {
   material.name = "";
@@ -355,55 +438,247 @@ void InitMaterial(material_t &material) {
   material.unknown_parameter.clear();
 }
 
+// Face of a chunk with the number of vertex attributes the chunk had read
+// before it, needed to resolve relative indices
+struct raw_face {
+  unsigned int size;
+  unsigned int nv, nvn, nvt;
+};
+
+// Line with a command that affects grouping (usemtl, mtllib, g, o), applied
+// after "face" faces of its chunk
+struct obj_event {
+  size_t face;
+  const char *token;
+};
+
+// Part of the file split at line boundaries, parsed independently
+struct obj_chunk {
+  char *begin, *end;
+  std::vector<float> v, vn, vt;
+  std::vector<raw_index> corners;
+  std::vector<raw_face> faces;
+  std::vector<obj_event> events;
+};
+
+// Group of faces waiting to be exported into a shape
+struct pending_group {
+  face_group faces;
+  int material;
+  std::string name;
+};
+
+// Run fn(i, worker) for i in [0, count) as up to num_threads jobs of the shared ppgso job system,
+// worker identifies the job so callers can keep per-worker state
+template <typename Fn>
+static void parallelFor(size_t count, unsigned int num_threads, Fn fn) {
+  size_t workers = std::min<size_t>(count, num_threads);
+  if (workers <= 1) {
+    for (size_t i = 0; i < count; i++)
+      fn(i, 0);
+    return;
+  }
+
+  std::atomic<size_t> next(0);
+  ppgso::JobSystem::shared().parallelFor(workers, 1, [&](size_t first, size_t last) {
+    for (size_t worker = first; worker < last; worker++)
+      for (size_t i = next++; i < count; i = next++)
+        fn(i, worker);
+  });
+}
+
+static inline bool isCommand(const char *token, const char *command, size_t length) {
+  return 0 == strncmp(token, command, length) && isSpace(token[length]);
+}
+
+// Parse vertex attributes and faces of one chunk, remember grouping commands
+static void parseChunk(obj_chunk &chunk) {
+  // Count records up front so the arrays never reallocate, hopping from line to line
+  size_t nv = 0, nvn = 0, nvt = 0, nf = 0;
+  for (const char *c = chunk.begin; c < chunk.end;) {
+    const char *newline = static_cast<const char *>(
+        memchr(c, '\n', static_cast<size_t>(chunk.end - c)));
+    const char *line = c;
+    c = newline ? newline + 1 : chunk.end;
+    if (*line == 'v') {
+      if (isSpace(line[1]))
+        nv++;
+      else if (line[1] == 'n')
+        nvn++;
+      else if (line[1] == 't')
+        nvt++;
+    } else if (*line == 'f') {
+      nf++;
+    }
+  }
+  chunk.v.reserve(nv * 3);
+  chunk.vn.reserve(nvn * 3);
+  chunk.vt.reserve(nvt * 2);
+  chunk.faces.reserve(nf);
+  chunk.corners.reserve(nf * 4);
+
+  // Terminate every line in place so the token parsers see one line at a time
+  char *cursor = chunk.begin;
+  while (cursor < chunk.end) {
+    char *line = cursor;
+    char *newline = static_cast<char *>(
+        memchr(cursor, '\n', static_cast<size_t>(chunk.end - cursor)));
+    char *line_end = newline ? newline : chunk.end;
+    cursor = newline ? newline + 1 : chunk.end;
+
+    // Trim newline '\r\n' or '\n'
+    *line_end = '\0';
+    if (line_end > line && line_end[-1] == '\r')
+      line_end[-1] = '\0';
+
+    // Skip leading space.
+    const char *token = skipSpace(line);
+    if (token[0] == '\0')
+      continue; // empty line
+
+    if (token[0] == '#')
+      continue; // comment line
+
+    // vertex
+    if (token[0] == 'v' && isSpace((token[1]))) {
+      token += 2;
+      float x, y, z;
+      parseFloat3(x, y, z, token);
+      chunk.v.push_back(x);
+      chunk.v.push_back(y);
+      chunk.v.push_back(z);
+      continue;
+    }
+
+    // normal
+    if (token[0] == 'v' && token[1] == 'n' && isSpace((token[2]))) {
+      token += 3;
+      float x, y, z;
+      parseFloat3(x, y, z, token);
+      chunk.vn.push_back(x);
+      chunk.vn.push_back(y);
+      chunk.vn.push_back(z);
+      continue;
+    }
+
+    // texcoord
+    if (token[0] == 'v' && token[1] == 't' && isSpace((token[2]))) {
+      token += 3;
+      float x, y;
+      parseFloat2(x, y, token);
+      chunk.vt.push_back(x);
+      chunk.vt.push_back(y);
+      continue;
+    }
+
+    // face
+    if (token[0] == 'f' && isSpace((token[1]))) {
+      token = skipSpace(token + 2);
+
+      size_t first = chunk.corners.size();
+      while (!isNewLine(token[0])) {
+        chunk.corners.push_back(parseTriple(token));
+        while (isSpace(*token) || *token == '\r')
+          token++;
+      }
+
+      raw_face face;
+      face.size = static_cast<unsigned int>(chunk.corners.size() - first);
+      face.nv = static_cast<unsigned int>(chunk.v.size() / 3);
+      face.nvn = static_cast<unsigned int>(chunk.vn.size() / 3);
+      face.nvt = static_cast<unsigned int>(chunk.vt.size() / 2);
+      chunk.faces.push_back(face);
+      continue;
+    }
+
+    // Grouping depends on everything before it, resolved in file order later
+    if (isCommand(token, "usemtl", 6) || isCommand(token, "mtllib", 6) ||
+        (token[0] == 'g' && isSpace(token[1])) ||
+        (token[0] == 'o' && isSpace(token[1]))) {
+      obj_event event = {chunk.faces.size(), token};
+      chunk.events.push_back(event);
+      continue;
+    }
+
+    // Ignore unknown command.
+  }
+}
+
 static bool exportFaceGroupToShape(
-    shape_t &shape, std::map<vertex_index, unsigned int> vertexCache,
+    shape_t &shape, VertexCache &vertexCache,
     const std::vector<float> &in_positions,
     const std::vector<float> &in_normals,
-    const std::vector<float> &in_texcoords,
-    const std::vector<std::vector<vertex_index>> &faceGroup,
-    const int material_id, const std::string &name, bool clearCache) {
+    const std::vector<float> &in_texcoords, const face_group &faceGroup,
+    const int material_id, const std::string &name) {
   if (faceGroup.empty()) {
     return false;
   }
 
-  // Flatten vertices and indices
-  for (size_t i = 0; i < faceGroup.size(); i++) {
-    const std::vector<vertex_index> &face = faceGroup[i];
+  size_t ntriangles = 0, ncorners = 0;
+  for (size_t i = 0; i < faceGroup.sizes.size(); i++) {
+    if (faceGroup.sizes[i] > 2) {
+      ntriangles += faceGroup.sizes[i] - 2;
+      ncorners += faceGroup.sizes[i];
+    }
+  }
 
-    vertex_index i0 = face[0];
-    vertex_index i1(-1);
-    vertex_index i2 = face[1];
+  // Each group gets its own vertices
+  vertexCache.reset(ncorners);
+  shape.mesh.indices.resize(ntriangles * 3);
+  shape.mesh.material_ids.assign(ntriangles, material_id);
 
-    size_t npolys = face.size();
+  // Flatten indices, polygon -> face fan conversion
+  size_t corner = 0, index = 0;
+  for (size_t i = 0; i < faceGroup.sizes.size(); i++) {
+    size_t npolys = faceGroup.sizes[i];
+    const vertex_index *face = &faceGroup.corners[corner];
+    corner += npolys;
 
-    // Polygon -> face fan conversion
     for (size_t k = 2; k < npolys; k++) {
-      i1 = i2;
-      i2 = face[k];
-
-      unsigned int v0 = updateVertex(
-          vertexCache, shape.mesh.positions, shape.mesh.normals,
-          shape.mesh.texcoords, in_positions, in_normals, in_texcoords, i0);
-      unsigned int v1 = updateVertex(
-          vertexCache, shape.mesh.positions, shape.mesh.normals,
-          shape.mesh.texcoords, in_positions, in_normals, in_texcoords, i1);
-      unsigned int v2 = updateVertex(
-          vertexCache, shape.mesh.positions, shape.mesh.normals,
-          shape.mesh.texcoords, in_positions, in_normals, in_texcoords, i2);
+      shape.mesh.indices[index++] = vertexCache.find(face[0]);
+      shape.mesh.indices[index++] = vertexCache.find(face[k - 1]);
+      shape.mesh.indices[index++] = vertexCache.find(face[k]);
+    }
+  }
 
-      shape.mesh.indices.push_back(v0);
-      shape.mesh.indices.push_back(v1);
-      shape.mesh.indices.push_back(v2);
+  // Flatten vertices, all outputs are sized exactly before filling them
+  const std::vector<vertex_index> &vertices = vertexCache.vertices;
+  size_t nnormals = 0, ntexcoords = 0;
+  for (size_t i = 0; i < vertices.size(); i++) {
+    if (vertices[i].vn_idx >= 0)
+      nnormals++;
+    if (vertices[i].vt_idx >= 0)
+      ntexcoords++;
+  }
+  shape.mesh.positions.resize(vertices.size() * 3);
+  shape.mesh.normals.resize(nnormals * 3);
+  shape.mesh.texcoords.resize(ntexcoords * 2);
+
+  float *positions = shape.mesh.positions.data();
+  float *normals = shape.mesh.normals.data();
+  float *texcoords = shape.mesh.texcoords.data();
+  for (size_t i = 0; i < vertices.size(); i++) {
+    const vertex_index &vi = vertices[i];
+    assert(in_positions.size() > (unsigned int)(3 * vi.v_idx + 2));
+
+    *positions++ = in_positions[3 * vi.v_idx + 0];
+    *positions++ = in_positions[3 * vi.v_idx + 1];
+    *positions++ = in_positions[3 * vi.v_idx + 2];
+
+    if (vi.vn_idx >= 0) {
+      *normals++ = in_normals[3 * vi.vn_idx + 0];
+      *normals++ = in_normals[3 * vi.vn_idx + 1];
+      *normals++ = in_normals[3 * vi.vn_idx + 2];
+    }
 
-      shape.mesh.material_ids.push_back(material_id);
+    if (vi.vt_idx >= 0) {
+      *texcoords++ = in_texcoords[2 * vi.vt_idx + 0];
+      *texcoords++ = in_texcoords[2 * vi.vt_idx + 1];
     }
   }
 
   shape.name = name;
 
-  if (clearCache)
-    vertexCache.clear();
-
   return true;
 }
 
@@ -663,250 +938,234 @@ std::string MaterialFileReader::operator()(const std::string &matId,
 
 std::string LoadObj(std::vector<shape_t> &shapes,
                     std::vector<material_t> &materials, // [output]
-                    const char *filename, const char *mtl_basepath) {
-
-  shapes.clear();
-
-  std::stringstream err;
-
-  std::ifstream ifs(filename);
-  if (!ifs) {
-    err << "Cannot open file [" << filename << "]" << std::endl;
-    return err.str();
-  }
-
-  std::string basePath;
-  if (mtl_basepath) {
-    basePath = mtl_basepath;
+                    std::vector<char> &buffer, MaterialReader &readMatFn,
+                    unsigned int num_threads) {
+  if (num_threads == 0)
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+
+  // Split at line boundaries, small files are not worth the threads
+  const size_t min_chunk_size = 256 * 1024;
+  size_t size = buffer.size();
+  size_t num_chunks = std::max<size_t>(1, std::min<size_t>(num_threads, size / min_chunk_size));
+
+  buffer.push_back('\0');
+  std::vector<obj_chunk> chunks(num_chunks);
+  char *begin = &buffer[0];
+  char *end = begin + size;
+  for (size_t i = 0; i < num_chunks; i++) {
+    chunks[i].begin = begin;
+    char *split = begin + size * (i + 1) / num_chunks;
+    if (i + 1 == num_chunks || split >= end) {
+      split = end;
+    } else {
+      char *newline = static_cast<char *>(memchr(split, '\n', static_cast<size_t>(end - split)));
+      split = newline ? newline + 1 : end;
+    }
+    chunks[i].end = split;
+    begin = split;
   }
-  MaterialFileReader matFileReader(basePath);
-
-  return LoadObj(shapes, materials, ifs, matFileReader);
-}
 
-std::string LoadObj(std::vector<shape_t> &shapes,
-                    std::vector<material_t> &materials, // [output]
-                    std::istream &inStream, MaterialReader &readMatFn) {
-  std::stringstream err;
+  parallelFor(chunks.size(), num_threads,
+              [&](size_t i, size_t) { parseChunk(chunks[i]); });
 
+  // Merge vertex attributes, the chunk offsets are prefix sums of their counts
   std::vector<float> v;
   std::vector<float> vn;
   std::vector<float> vt;
-  std::vector<std::vector<vertex_index>> faceGroup;
+  std::vector<size_t> v_base, vn_base, vt_base;
+  for (size_t i = 0; i < chunks.size(); i++) {
+    v_base.push_back(v.size() / 3);
+    vn_base.push_back(vn.size() / 3);
+    vt_base.push_back(vt.size() / 2);
+    v.insert(v.end(), chunks[i].v.begin(), chunks[i].v.end());
+    vn.insert(vn.end(), chunks[i].vn.begin(), chunks[i].vn.end());
+    vt.insert(vt.end(), chunks[i].vt.begin(), chunks[i].vt.end());
+    std::vector<float>().swap(chunks[i].v);
+    std::vector<float>().swap(chunks[i].vn);
+    std::vector<float>().swap(chunks[i].vt);
+  }
+
+  // Replay faces and grouping commands in file order
+  std::vector<pending_group> groups;
+  face_group faceGroup;
   std::string name;
 
   // material
   std::map<std::string, int> material_map;
-  std::map<vertex_index, unsigned int> vertexCache;
   int material = -1;
 
-  shape_t shape;
-
-  int maxchars = 8192;             // Alloc enough size.
-  std::vector<char> buf((unsigned long) maxchars); // Alloc enough size.
-  while (inStream.peek() != -1) {
-    inStream.getline(&buf[0], maxchars);
-
-    std::string linebuf(&buf[0]);
-
-    // Trim newline '\r\n' or '\n'
-    if (linebuf.size() > 0) {
-      if (linebuf[linebuf.size() - 1] == '\n')
-        linebuf.erase(linebuf.size() - 1);
-    }
-    if (linebuf.size() > 0) {
-      if (linebuf[linebuf.size() - 1] == '\r')
-        linebuf.erase(linebuf.size() - 1);
-    }
-
-    // Skip if empty line.
-    if (linebuf.empty()) {
-      continue;
-    }
-
-    // Skip leading space.
-    const char *token = linebuf.c_str();
-    token += strspn(token, " \t");
-
-    assert(token);
-    if (token[0] == '\0')
-      continue; // empty line
-
-    if (token[0] == '#')
-      continue; // comment line
-
-    // vertex
-    if (token[0] == 'v' && isSpace((token[1]))) {
-      token += 2;
-      float x, y, z;
-      parseFloat3(x, y, z, token);
-      v.push_back(x);
-      v.push_back(y);
-      v.push_back(z);
-      continue;
+  // flush previous face group.
+  auto flush = [&]() {
+    if (!faceGroup.empty()) {
+      pending_group group = {std::move(faceGroup), material, name};
+      groups.push_back(std::move(group));
     }
-
-    // normal
-    if (token[0] == 'v' && token[1] == 'n' && isSpace((token[2]))) {
-      token += 3;
-      float x, y, z;
-      parseFloat3(x, y, z, token);
-      vn.push_back(x);
-      vn.push_back(y);
-      vn.push_back(z);
-      continue;
-    }
-
-    // texcoord
-    if (token[0] == 'v' && token[1] == 't' && isSpace((token[2]))) {
-      token += 3;
-      float x, y;
-      parseFloat2(x, y, token);
-      vt.push_back(x);
-      vt.push_back(y);
-      continue;
-    }
-
-    // face
-    if (token[0] == 'f' && isSpace((token[1]))) {
-      token += 2;
-      token += strspn(token, " \t");
-
-      std::vector<vertex_index> face;
-      while (!isNewLine(token[0])) {
-        vertex_index vi = parseTriple(token, static_cast<int>(v.size() / 3),
-                                      static_cast<int>(vn.size() / 3),
-                                      static_cast<int>(vt.size() / 2));
-        face.push_back(vi);
-        size_t n = strspn(token, " \t\r");
-        token += n;
-      }
-
-      faceGroup.push_back(face);
-
-      continue;
-    }
-
-    // use mtl
-    if ((0 == strncmp(token, "usemtl", 6)) && isSpace((token[6]))) {
-
-      char namebuf[TINYOBJ_SSCANF_BUFFER_SIZE];
-      token += 7;
+    faceGroup.clear();
+  };
+
+  std::string err;
+  for (size_t c = 0; c < chunks.size() && err.empty(); c++) {
+    const obj_chunk &chunk = chunks[c];
+    size_t corner = 0, event = 0;
+    faceGroup.corners.reserve(faceGroup.corners.size() + chunk.corners.size());
+    faceGroup.sizes.reserve(faceGroup.sizes.size() + chunk.faces.size());
+    for (size_t f = 0; f <= chunk.faces.size() && err.empty(); f++) {
+      for (; event < chunk.events.size() && chunk.events[event].face == f; event++) {
+        const char *token = chunk.events[event].token;
+
+        // use mtl
+        if (isCommand(token, "usemtl", 6)) {
+          char namebuf[TINYOBJ_SSCANF_BUFFER_SIZE];
+          token += 7;
 #ifdef _MSC_VER
-      sscanf_s(token, "%s", namebuf, (unsigned)_countof(namebuf));
+          sscanf_s(token, "%s", namebuf, (unsigned)_countof(namebuf));
 #else
-      sscanf(token, "%s", namebuf);
+          sscanf(token, "%s", namebuf);
 #endif
 
-      // Create face group per material.
-      bool ret = exportFaceGroupToShape(shape, vertexCache, v, vn, vt,
-                                        faceGroup, material, name, true);
-      if (ret) {
-        shapes.push_back(shape);
-      }
-      shape = shape_t();
-      faceGroup.clear();
-
-      if (material_map.find(namebuf) != material_map.end()) {
-        material = material_map[namebuf];
-      } else {
-        // { error!! material not found }
-        material = -1;
-      }
-
-      continue;
-    }
-
-    // load mtl
-    if ((0 == strncmp(token, "mtllib", 6)) && isSpace((token[6]))) {
-      char namebuf[TINYOBJ_SSCANF_BUFFER_SIZE];
-      token += 7;
+          // Create face group per material.
+          flush();
+
+          if (material_map.find(namebuf) != material_map.end()) {
+            material = material_map[namebuf];
+          } else {
+            // { error!! material not found }
+            material = -1;
+          }
+          continue;
+        }
+
+        // load mtl
+        if (isCommand(token, "mtllib", 6)) {
+          char namebuf[TINYOBJ_SSCANF_BUFFER_SIZE];
+          token += 7;
 #ifdef _MSC_VER
-      sscanf_s(token, "%s", namebuf, (unsigned)_countof(namebuf));
+          sscanf_s(token, "%s", namebuf, (unsigned)_countof(namebuf));
 #else
-      sscanf(token, "%s", namebuf);
+          sscanf(token, "%s", namebuf);
 #endif
 
-      std::string err_mtl = readMatFn(namebuf, materials, material_map);
-      if (!err_mtl.empty()) {
-        faceGroup.clear(); // for safety
-        return err_mtl;
-      }
-
-      continue;
-    }
-
-    // group name
-    if (token[0] == 'g' && isSpace((token[1]))) {
-
-      // flush previous face group.
-      bool ret = exportFaceGroupToShape(shape, vertexCache, v, vn, vt,
-                                        faceGroup, material, name, true);
-      if (ret) {
-        shapes.push_back(shape);
-      }
-
-      shape = shape_t();
-
-      // material = -1;
-      faceGroup.clear();
-
-      std::vector<std::string> names;
-      while (!isNewLine(token[0])) {
-        std::string str = parseString(token);
-        names.push_back(str);
-        token += strspn(token, " \t\r"); // skip tag
+          err = readMatFn(namebuf, materials, material_map);
+          if (!err.empty())
+            break;
+          continue;
+        }
+
+        // group name
+        if (token[0] == 'g') {
+          flush();
+
+          std::vector<std::string> names;
+          while (!isNewLine(token[0])) {
+            std::string str = parseString(token);
+            names.push_back(str);
+            token += strspn(token, " \t\r"); // skip tag
+          }
+
+          assert(names.size() > 0);
+
+          // names[0] must be 'g', so skip the 0th element.
+          if (names.size() > 1) {
+            name = names[1];
+          } else {
+            name = "";
+          }
+          continue;
+        }
+
+        // object name
+        if (token[0] == 'o') {
+          flush();
+
+          // @todo { multiple object name? }
+          char namebuf[TINYOBJ_SSCANF_BUFFER_SIZE];
+          token += 2;
+#ifdef _MSC_VER
+          sscanf_s(token, "%s", namebuf, (unsigned)_countof(namebuf));
+#else
+          sscanf(token, "%s", namebuf);
+#endif
+          name = std::string(namebuf);
+          continue;
+        }
       }
-
-      assert(names.size() > 0);
-
-      // names[0] must be 'g', so skip the 0th element.
-      if (names.size() > 1) {
-        name = names[1];
-      } else {
-        name = "";
+      if (f == chunk.faces.size() || !err.empty())
+        break;
+
+      // Make indices zero-based using the attribute counts at this face
+      const raw_face &face = chunk.faces[f];
+      int nv = static_cast<int>(v_base[c] + face.nv);
+      int nvn = static_cast<int>(vn_base[c] + face.nvn);
+      int nvt = static_cast<int>(vt_base[c] + face.nvt);
+      for (unsigned int k = 0; k < face.size; k++) {
+        const raw_index &raw = chunk.corners[corner++];
+        vertex_index vi(-1);
+        vi.v_idx = fixIndex(raw.v_idx, nv);
+        if (raw.vt_idx != INDEX_NONE)
+          vi.vt_idx = fixIndex(raw.vt_idx, nvt);
+        if (raw.vn_idx != INDEX_NONE)
+          vi.vn_idx = fixIndex(raw.vn_idx, nvn);
+        faceGroup.corners.push_back(vi);
       }
-
-      continue;
+      faceGroup.sizes.push_back(face.size);
     }
+  }
+  // A missing material file stops loading, the faces read so far stay unused
+  if (err.empty())
+    flush();
+  chunks.clear();
+
+  // Groups do not share vertices, so they are exported independently
+  std::vector<shape_t> exported(groups.size());
+  std::vector<VertexCache> caches(std::min<size_t>(groups.size(), num_threads));
+  parallelFor(groups.size(), num_threads, [&](size_t i, size_t worker) {
+    exportFaceGroupToShape(exported[i], caches[worker], v, vn, vt,
+                           groups[i].faces, groups[i].material, groups[i].name);
+  });
+
+  for (size_t i = 0; i < exported.size(); i++)
+    shapes.push_back(std::move(exported[i]));
 
-    // object name
-    if (token[0] == 'o' && isSpace((token[1]))) {
-
-      // flush previous face group.
-      bool ret = exportFaceGroupToShape(shape, vertexCache, v, vn, vt,
-                                        faceGroup, material, name, true);
-      if (ret) {
-        shapes.push_back(shape);
-      }
+  return err;
+}
 
-      // material = -1;
-      faceGroup.clear();
-      shape = shape_t();
+std::string LoadObj(std::vector<shape_t> &shapes,
+                    std::vector<material_t> &materials, // [output]
+                    const char *filename, const char *mtl_basepath,
+                    unsigned int num_threads) {
 
-      // @todo { multiple object name? }
-      char namebuf[TINYOBJ_SSCANF_BUFFER_SIZE];
-      token += 2;
-#ifdef _MSC_VER
-      sscanf_s(token, "%s", namebuf, (unsigned)_countof(namebuf));
-#else
-      sscanf(token, "%s", namebuf);
-#endif
-      name = std::string(namebuf);
+  shapes.clear();
 
-      continue;
-    }
+  std::stringstream err;
 
-    // Ignore unknown command.
+  std::ifstream ifs(filename, std::ios::binary);
+  if (!ifs) {
+    err << "Cannot open file [" << filename << "]" << std::endl;
+    return err.str();
   }
 
-  bool ret = exportFaceGroupToShape(shape, vertexCache, v, vn, vt, faceGroup,
-                                    material, name, true);
-  if (ret) {
-    shapes.push_back(shape);
+  std::string basePath;
+  if (mtl_basepath) {
+    basePath = mtl_basepath;
   }
-  faceGroup.clear(); // for safety
+  MaterialFileReader matFileReader(basePath);
 
-  return err.str();
+  // Read the whole file at once, the parser works on the buffer in place
+  ifs.seekg(0, std::ios::end);
+  std::vector<char> buffer(static_cast<size_t>(ifs.tellg()) + 1);
+  ifs.seekg(0, std::ios::beg);
+  ifs.read(&buffer[0], static_cast<std::streamsize>(buffer.size() - 1));
+  buffer.resize(static_cast<size_t>(ifs.gcount()));
+
+  return LoadObj(shapes, materials, buffer, matFileReader, num_threads);
+}
+
+std::string LoadObj(std::vector<shape_t> &shapes,
+                    std::vector<material_t> &materials, // [output]
+                    std::istream &inStream, MaterialReader &readMatFn,
+                    unsigned int num_threads) {
+  std::vector<char> buffer((std::istreambuf_iterator<char>(inStream)),
+                           std::istreambuf_iterator<char>());
+  return LoadObj(shapes, materials, buffer, readMatFn, num_threads);
 }
 }
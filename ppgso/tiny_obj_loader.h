@@ -77,16 +77,29 @@ private:
 /// The function returns error string.
 /// Returns empty string when loading .obj success.
 /// 'mtl_basepath' is optional, and used for base path for .mtl file.
+/// 'num_threads' limits the threads used for large files, 0 uses all cores.
 std::string LoadObj(std::vector<shape_t> &shapes,       // [output]
                     std::vector<material_t> &materials, // [output]
-                    const char *filename, const char *mtl_basepath = nullptr);
+                    const char *filename, const char *mtl_basepath = nullptr,
+                    unsigned int num_threads = 0);
 
 /// Loads object from a std::istream, uses GetMtlIStreamFn to retrieve
 /// std::istream for materials.
 /// Returns empty string when loading .obj success.
 std::string LoadObj(std::vector<shape_t> &shapes,       // [output]
                     std::vector<material_t> &materials, // [output]
-                    std::istream &inStream, MaterialReader &readMatFn);
+                    std::istream &inStream, MaterialReader &readMatFn,
+                    unsigned int num_threads = 0);
+
+/// Loads object from a memory buffer holding the .obj text.
+/// The buffer is modified in place while parsing. Files larger than a few
+/// hundred kilobytes are split at line boundaries and parsed on up to
+/// 'num_threads' threads (0 uses all cores), the result does not depend on it.
+/// Returns empty string when loading .obj success.
+std::string LoadObj(std::vector<shape_t> &shapes,       // [output]
+                    std::vector<material_t> &materials, // [output]
+                    std::vector<char> &buffer, MaterialReader &readMatFn,
+                    unsigned int num_threads = 0);
 
 /// Loads materials into std::map
 /// Returns an empty string if successful
@@ -0,0 +1,27 @@
+#include "uniform_buffer.h"
+
+ppgso::UniformBuffer::UniformBuffer(GLsizeiptr size, GLuint binding) : size{size}, binding{binding} {
+  glGenBuffers(1, &buffer);
+  glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+  glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_STREAM_DRAW);
+  bind();
+}
+
+ppgso::UniformBuffer::~UniformBuffer() {
+  glDeleteBuffers(1, &buffer);
+}
+
+void ppgso::UniformBuffer::update(const void *data) {
+  glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+  // Orphan the old storage, then fill the new one
+  glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_STREAM_DRAW);
+  glBufferSubData(GL_UNIFORM_BUFFER, 0, size, data);
+}
+
+void ppgso::UniformBuffer::bind() const {
+  glBindBufferBase(GL_UNIFORM_BUFFER, binding, buffer);
+}
+
+GLuint ppgso::UniformBuffer::getBuffer() const {
+  return buffer;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <GL/glew.h>
+
+namespace ppgso {
+
+  /*!
+   * Uniform buffer object holding a block of shader inputs shared by multiple programs.
+   *
+   * The layout of the data must match the std140 layout of the uniform block in GLSL.
+   * Programs are connected to the buffer using Shader::setUniformBlock with the same binding point.
+   */
+  class UniformBuffer {
+  public:
+
+    /*!
+     * Create a uniform buffer and attach it to an indexed binding point.
+     *
+     * @param size - Size of the uniform block in bytes.
+     * @param binding - Uniform buffer binding point to attach the buffer to.
+     */
+    UniformBuffer(GLsizeiptr size, GLuint binding);
+
+    ~UniformBuffer();
+
+    UniformBuffer(const UniformBuffer&) = delete;
+    UniformBuffer &operator=(const UniformBuffer&) = delete;
+
+    /*!
+     * Replace the content of the buffer.
+     * The previous storage is orphaned so the update does not wait for draws still using it.
+     *
+     * @param data - Pointer to data to upload, must be at least the size of the buffer.
+     */
+    void update(const void *data);
+
+    /*!
+     * Replace the content of the buffer with a std140 compatible structure.
+     *
+     * @param data - Structure to upload, must match the size of the buffer.
+     */
+    template<typename T>
+    void update(const T &data) {
+      static_assert(sizeof(T) % 16 == 0, "std140 uniform blocks are padded to 16 bytes");
+      update(static_cast<const void *>(&data));
+    }
+
+    /*!
+     * Attach the buffer to its binding point again.
+     */
+    void bind() const;
+
+    /*!
+     * Get OpenGL buffer identifier number.
+     *
+     * @return - OpenGL buffer identifier number.
+     */
+    GLuint getBuffer() const;
+
+  private:
+    GLuint buffer = 0;
+    GLsizeiptr size;
+    GLuint binding;
+  };
+}
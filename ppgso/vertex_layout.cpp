@@ -0,0 +1,129 @@
+#include <vector>
+
+#include <glm/packing.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include "vertex_layout.h"
+#include "mesh_optimizer.h"
+
+static void pack(glm::vec2 &out, const float *in) {
+  out = {in[0], in[1]};
+}
+
+static void pack(glm::vec3 &out, const float *in) {
+  out = {in[0], in[1], in[2]};
+}
+
+static void pack(ppgso::Half2 &out, const float *in) {
+  out.value = glm::packHalf2x16({in[0], in[1]});
+}
+
+static void pack(ppgso::Snorm10x3 &out, const float *in) {
+  out.value = glm::packSnorm3x10_1x2({in[0], in[1], in[2], 0.0f});
+}
+
+template<typename T>
+static void setAttribute(GLuint location, GLsizei stride, size_t offset) {
+  using Format = ppgso::AttributeFormat<T>;
+  glEnableVertexAttribArray(location);
+  glVertexAttribPointer(location, Format::size, Format::type, Format::normalized, stride,
+                        reinterpret_cast<void *>(offset));
+}
+
+template<typename TexCoord, typename Normal>
+static GLuint upload(const ppgso::VertexSource &source) {
+  using Vertex = ppgso::InterleavedVertex<TexCoord, Normal>;
+
+  std::vector<Vertex> vertices(source.count);
+  for (size_t i = 0; i < source.count; i++) {
+    pack(vertices[i].position, source.positions + i * 3);
+    if (source.texcoords)
+      pack(vertices[i].texcoord, source.texcoords + i * source.texcoordStride);
+    else
+      vertices[i].texcoord = {};
+    if (source.normals)
+      pack(vertices[i].normal, source.normals + i * 3);
+    else
+      vertices[i].normal = {};
+  }
+
+  GLuint vbo;
+  glGenBuffers(1, &vbo);
+  glBindBuffer(GL_ARRAY_BUFFER, vbo);
+  glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
+
+  setAttribute<glm::vec3>(0, sizeof(Vertex), offsetof(Vertex, position));
+  if (source.texcoords)
+    setAttribute<TexCoord>(1, sizeof(Vertex), offsetof(Vertex, texcoord));
+  if (source.normals)
+    setAttribute<Normal>(2, sizeof(Vertex), offsetof(Vertex, normal));
+  return vbo;
+}
+
+GLuint ppgso::uploadInterleavedVertices(const MeshOptions &options, const VertexSource &source) {
+  if (options.halfTexCoords && options.packedNormals)
+    return upload<Half2, Snorm10x3>(source);
+  if (options.halfTexCoords)
+    return upload<Half2, glm::vec3>(source);
+  if (options.packedNormals)
+    return upload<glm::vec2, Snorm10x3>(source);
+  return upload<glm::vec2, glm::vec3>(source);
+}
+
+GLuint ppgso::uploadIndices(const MeshOptions &options, size_t vertexCount, const unsigned int *indices, size_t count,
+                            GLenum &type) {
+  GLuint ibo;
+  glGenBuffers(1, &ibo);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+
+  if (options.shortIndices && vertexCount <= 0x10000) {
+    std::vector<uint16_t> short_indices(indices, indices + count);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(uint16_t), short_indices.data(), GL_STATIC_DRAW);
+    type = GL_UNSIGNED_SHORT;
+  } else {
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(unsigned int), indices, GL_STATIC_DRAW);
+    type = GL_UNSIGNED_INT;
+  }
+  return ibo;
+}
+
+void ppgso::buildLodIndices(const MeshOptions &options, const float *positions, size_t vertexCount,
+                            const unsigned int *indices, size_t count, std::vector<unsigned int> &all,
+                            std::vector<IndexRange> &lods) {
+  all.assign(indices, indices + count);
+  lods.assign(1, IndexRange{(GLsizei) count, 0});
+
+  for (auto ratio : options.lodRatios) {
+    auto &previous = lods.back();
+    auto target = (size_t) (count / 3 * ratio) * 3;
+    auto first = all.size();
+    all.resize(first + previous.count);
+    auto simplified = mesh_optimizer::simplify(all.data() + first, all.data() + previous.first, previous.count,
+                                               positions, vertexCount, target);
+    all.resize(first + simplified);
+    if (options.optimize)
+      mesh_optimizer::optimizeVertexCache(all.data() + first, simplified, vertexCount);
+    lods.push_back(IndexRange{(GLsizei) simplified, (GLsizei) first});
+  }
+}
+
+unsigned int ppgso::selectLod(const MeshOptions &options, float screenSize) {
+  auto needed = screenSize * options.lodDetail;
+  unsigned int lod = 0;
+  for (size_t i = 0; i < options.lodRatios.size(); i++)
+    if (options.lodRatios[i] >= needed)
+      lod = (unsigned int) i + 1;
+  return lod;
+}
+
+size_t ppgso::getBufferSize(GLuint buffer) {
+  if (!buffer)
+    return 0;
+
+  // The copy target is not part of any vertex array state
+  GLint size = 0;
+  glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+  glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &size);
+  glBindBuffer(GL_COPY_READ_BUFFER, 0);
+  return (size_t) size;
+}
@@ -0,0 +1,192 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "residency.h"
+
+namespace ppgso {
+
+  /*!
+   * Options controlling how mesh geometry is stored on the GPU.
+   *
+   * By default every attribute gets its own 32-bit float buffer and indices are 32-bit.
+   * The compact options interleave all attributes into a single vertex buffer, which
+   * improves vertex fetch locality and reduces memory and bandwidth.
+   */
+  struct MeshOptions {
+    bool interleaved = false;    // One vertex buffer with all attributes
+    bool halfTexCoords = false;  // 16-bit float texture coordinates, implies interleaved
+    bool packedNormals = false;  // Signed normalized 10-10-10-2 normals, implies interleaved
+    bool shortIndices = false;   // 16-bit indices when the vertex count allows it
+    bool optimize = false;       // Reorder triangles and vertices for the post-transform cache and fetch locality
+
+    // Fraction of the triangles kept by each simplified level of detail, in decreasing order
+    std::vector<float> lodRatios;
+    // Screen size multiplier, a LOD is used while its ratio covers screen size * lodDetail
+    float lodDetail = 2.0f;
+
+    // Whether the parsed geometry stays in memory after the upload, see Mesh::getData
+    Residency residency = Residency::GpuOnly;
+
+    /*!
+     * Get options using all compact formats and load time optimizations.
+     *
+     * @return - Optimized, interleaved vertices with half float UVs, packed normals and short indices.
+     */
+    static MeshOptions compact() {
+      MeshOptions options;
+      options.interleaved = options.halfTexCoords = options.packedNormals = options.shortIndices = true;
+      options.optimize = true;
+      return options;
+    }
+  };
+
+  /*!
+   * Description of how a C++ type is passed to glVertexAttribPointer.
+   * Only specialized for supported storage types, so unsupported layouts fail to compile.
+   */
+  template<typename T>
+  struct AttributeFormat;
+
+  template<>
+  struct AttributeFormat<glm::vec3> {
+    static constexpr GLint size = 3;
+    static constexpr GLenum type = GL_FLOAT;
+    static constexpr GLboolean normalized = GL_FALSE;
+  };
+
+  template<>
+  struct AttributeFormat<glm::vec2> {
+    static constexpr GLint size = 2;
+    static constexpr GLenum type = GL_FLOAT;
+    static constexpr GLboolean normalized = GL_FALSE;
+  };
+
+  // Two half floats packed with glm::packHalf2x16
+  struct Half2 {
+    uint32_t value;
+  };
+
+  template<>
+  struct AttributeFormat<Half2> {
+    static constexpr GLint size = 2;
+    static constexpr GLenum type = GL_HALF_FLOAT;
+    static constexpr GLboolean normalized = GL_FALSE;
+  };
+
+  // Vector packed with glm::packSnorm3x10_1x2, read as a normalized vec4 by the shader
+  struct Snorm10x3 {
+    uint32_t value;
+  };
+
+  template<>
+  struct AttributeFormat<Snorm10x3> {
+    static constexpr GLint size = 4;
+    static constexpr GLenum type = GL_INT_2_10_10_10_REV;
+    static constexpr GLboolean normalized = GL_TRUE;
+  };
+
+  /*!
+   * Interleaved vertex with the attribute locations used by the ppgso shaders:
+   * vec3 Position - position 0, vec2 TexCoord - position 1, vec3 Normal - position 2
+   */
+  template<typename TexCoord, typename Normal>
+  struct InterleavedVertex {
+    glm::vec3 position;
+    TexCoord texcoord;
+    Normal normal;
+
+    // Vertex attributes must start on 4 byte boundaries
+    static_assert(sizeof(TexCoord) % 4 == 0 && sizeof(Normal) % 4 == 0, "Unaligned vertex attribute");
+  };
+
+  /*!
+   * Geometry of one mesh part as separate float arrays, missing attributes are nullptr.
+   */
+  struct VertexSource {
+    size_t count = 0;
+    const float *positions = nullptr;
+    const float *texcoords = nullptr;
+    const float *normals = nullptr;
+    size_t texcoordStride = 2;  // Floats between consecutive texture coordinates
+  };
+
+  /*!
+   * Create an interleaved vertex buffer and set up attributes 0-2 of the bound vertex array.
+   *
+   * @param options - Formats to use for texture coordinates and normals.
+   * @param source - Vertex data to upload.
+   * @return - OpenGL buffer with the vertex data.
+   */
+  GLuint uploadInterleavedVertices(const MeshOptions &options, const VertexSource &source);
+
+  /*!
+   * Part of an index buffer drawn for one level of detail.
+   */
+  struct IndexRange {
+    GLsizei count = 0;
+    GLsizei first = 0;
+  };
+
+  /*!
+   * Get the glDrawElements offset of an index range.
+   *
+   * @param type - Index type of the buffer.
+   * @param range - Range to draw.
+   * @return - Byte offset into the bound index buffer.
+   */
+  inline const void *indexOffset(GLenum type, const IndexRange &range) {
+    return reinterpret_cast<const void *>(range.first * (type == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t)));
+  }
+
+  /*!
+   * Select the coarsest level of detail that still has enough triangles for an object's screen size.
+   *
+   * @param options - Options the mesh was loaded with.
+   * @param screenSize - Projected diameter of the object as a fraction of the viewport height.
+   * @return - Level of detail, 0 is the full mesh.
+   */
+  unsigned int selectLod(const MeshOptions &options, float screenSize);
+
+  /*!
+   * Create an index buffer and bind it to the bound vertex array.
+   *
+   * @param options - Whether 16-bit indices may be used.
+   * @param vertexCount - Number of vertices the indices refer to.
+   * @param indices - Index data.
+   * @param count - Number of indices.
+   * @param type - Receives GL_UNSIGNED_SHORT or GL_UNSIGNED_INT for glDrawElements.
+   * @return - OpenGL buffer with the index data.
+   */
+  GLuint uploadIndices(const MeshOptions &options, size_t vertexCount, const unsigned int *indices, size_t count,
+                       GLenum &type);
+
+  /*!
+   * Simplify the indices to every ratio in MeshOptions::lodRatios and store all levels in one index array.
+   * Each level is simplified from the previous one and indexes the same vertices.
+   * Only works on the CPU, so it can run on any thread before the array is passed to uploadIndices.
+   *
+   * @param options - Level of detail ratios and whether to optimize the levels for the vertex cache.
+   * @param positions - Vertex positions, 3 floats per vertex.
+   * @param vertexCount - Number of vertices.
+   * @param indices - Full detail index data.
+   * @param count - Number of indices.
+   * @param all - Receives the indices of all levels.
+   * @param lods - Receives the range of every level, starting with the full mesh.
+   */
+  void buildLodIndices(const MeshOptions &options, const float *positions, size_t vertexCount,
+                       const unsigned int *indices, size_t count, std::vector<unsigned int> &all,
+                       std::vector<IndexRange> &lods);
+
+  /*!
+   * Get the size of the data store of a buffer object.
+   *
+   * @param buffer - OpenGL buffer, 0 is allowed.
+   * @return - Size in bytes, 0 for no buffer.
+   */
+  size_t getBufferSize(GLuint buffer);
+}
@@ -9,33 +9,32 @@ uniform sampler2D Texture;
 uniform float Transparency;
 uniform vec2 TextureOffset;
 
-// Fog
-uniform vec3 FogColor;
-uniform float FogDensity;
-
-// Camera
-uniform vec3 CameraPosition;
-
-// ============ LIGHT 1: Directional Light (Sun) ============
-uniform vec3 LightDirection;
-
-// ============ LIGHT 2: Point Light (Bioluminescent) ============
-uniform vec3 PointLightPos;
-uniform vec3 PointLightColor;
-uniform float PointLightIntensity;
-
-// ============ LIGHT 3: Spotlight (Diver's flashlight) ============
-uniform vec3 SpotLightPos;
-uniform vec3 SpotLightDir;
-uniform vec3 SpotLightColor;
-uniform float SpotLightCutoff;
-uniform float SpotLightIntensity;
+// Per-frame scene inputs shared by all underwater objects, filled once per frame
+// Layout must match UnderwaterScene::SceneUniforms
+layout(std140) uniform SceneBlock {
+    mat4 ProjectionMatrix;
+    mat4 ViewMatrix;
+    vec3 CameraPosition;
+    float FogDensity;
+    vec3 FogColor;
+    float Time;
+    vec3 LightDirection;      // LIGHT 1: Directional light (sun)
+    float PointLightIntensity;
+    vec3 PointLightPos;       // LIGHT 2: Point light (bioluminescent)
+    float SpotLightCutoff;
+    vec3 PointLightColor;
+    float SpotLightIntensity;
+    vec3 SpotLightPos;        // LIGHT 3: Spotlight (diver's flashlight)
+    vec3 SpotLightDir;
+    vec3 SpotLightColor;
+};
 
 // Input from vertex shader
 in vec2 texCoord;
 in float fogFactor;
 in vec3 fragNormal;
 in vec3 fragPosition;
+in float fadeFactor;
 
 out vec4 FragmentColor;
 
@@ -130,5 +129,5 @@ void main() {
     float gamma = 2.2;
     vec3 gammaCorrected = pow(mapped, vec3(1.0 / gamma));
     
-    FragmentColor = vec4(gammaCorrected, Transparency);
+    FragmentColor = vec4(gammaCorrected, Transparency * (1.0 - fadeFactor));
 }
@@ -0,0 +1,92 @@
+#version 330
+// Underwater vertex shader with fog support for instanced geometry
+// Each instance supplies its own base model matrix as a per-instance attribute
+// and can optionally be swayed procedurally from the Time uniform or faded out
+
+layout(location = 0) in vec3 Position;
+layout(location = 1) in vec2 TexCoord;
+layout(location = 2) in vec3 Normal;
+layout(location = 3) in mat4 InstanceMatrix;  // Occupies locations 3-6
+layout(location = 7) in vec4 InstanceSway;    // x = phase, y = speed, z = yaw
+layout(location = 8) in float InstanceFade;   // 0 keeps the Transparency, 1 is fully transparent
+
+// Per-frame scene inputs shared by all underwater objects, filled once per frame
+// Layout must match UnderwaterScene::SceneUniforms
+layout(std140) uniform SceneBlock {
+    mat4 ProjectionMatrix;
+    mat4 ViewMatrix;
+    vec3 CameraPosition;
+    float FogDensity;
+    vec3 FogColor;
+    float Time;
+    vec3 LightDirection;      // LIGHT 1: Directional light (sun)
+    float PointLightIntensity;
+    vec3 PointLightPos;       // LIGHT 2: Point light (bioluminescent)
+    float SpotLightCutoff;
+    vec3 PointLightColor;
+    float SpotLightIntensity;
+    vec3 SpotLightPos;        // LIGHT 3: Spotlight (diver's flashlight)
+    vec3 SpotLightDir;
+    vec3 SpotLightColor;
+};
+
+// Sway animation driven by the scene Time, amplitude of 0 disables it
+uniform float SwayAmplitude;
+
+// Output to fragment shader
+out vec2 texCoord;
+out float fogFactor;
+out vec3 fragNormal;
+out vec3 fragPosition;
+out float fadeFactor;
+
+mat4 rotateX(float angle) {
+    float s = sin(angle), c = cos(angle);
+    return mat4(1.0, 0.0, 0.0, 0.0,
+                0.0,   c,   s, 0.0,
+                0.0,  -s,   c, 0.0,
+                0.0, 0.0, 0.0, 1.0);
+}
+
+mat4 rotateY(float angle) {
+    float s = sin(angle), c = cos(angle);
+    return mat4(  c, 0.0,  -s, 0.0,
+                0.0, 1.0, 0.0, 0.0,
+                  s, 0.0,   c, 0.0,
+                0.0, 0.0, 0.0, 1.0);
+}
+
+mat4 rotateZ(float angle) {
+    float s = sin(angle), c = cos(angle);
+    return mat4(  c,   s, 0.0, 0.0,
+                 -s,   c, 0.0, 0.0,
+                0.0, 0.0, 1.0, 0.0,
+                0.0, 0.0, 0.0, 1.0);
+}
+
+void main() {
+    texCoord = TexCoord;
+    fadeFactor = InstanceFade;
+    
+    // Gentle sway around the base of the plant, then the fixed per-instance yaw
+    float phase = InstanceSway.x + InstanceSway.y * Time;
+    float swayX = sin(phase) * SwayAmplitude;
+    float swayZ = sin(phase * 0.7 + 1.0) * SwayAmplitude * 0.5;
+    mat4 modelMatrix = InstanceMatrix * rotateX(swayX) * rotateZ(swayZ) * rotateY(InstanceSway.z);
+    
+    // Calculate world position
+    vec4 worldPos = modelMatrix * vec4(Position, 1.0);
+    vec4 viewPos = ViewMatrix * worldPos;
+    
+    // Pass world position to fragment shader for lighting
+    fragPosition = worldPos.xyz;
+    
+    // Exponential fog - same falloff as underwater_vert.glsl
+    float distance = length(viewPos.xyz);
+    fogFactor = clamp(exp(-FogDensity * distance), 0.0, 1.0);
+    
+    // Transform normal with the instance matrix
+    fragNormal = mat3(transpose(inverse(modelMatrix))) * Normal;
+    
+    gl_Position = ProjectionMatrix * viewPos;
+}
@@ -5,8 +5,26 @@ layout(location = 0) in vec3 Position;
 layout(location = 1) in vec2 TexCoord;
 layout(location = 2) in vec3 Normal;
 
-uniform mat4 ProjectionMatrix;
-uniform mat4 ViewMatrix;
+// Per-frame scene inputs shared by all underwater objects, filled once per frame
+// Layout must match UnderwaterScene::SceneUniforms
+layout(std140) uniform SceneBlock {
+    mat4 ProjectionMatrix;
+    mat4 ViewMatrix;
+    vec3 CameraPosition;
+    float FogDensity;
+    vec3 FogColor;
+    float Time;
+    vec3 LightDirection;      // LIGHT 1: Directional light (sun)
+    float PointLightIntensity;
+    vec3 PointLightPos;       // LIGHT 2: Point light (bioluminescent)
+    float SpotLightCutoff;
+    vec3 PointLightColor;
+    float SpotLightIntensity;
+    vec3 SpotLightPos;        // LIGHT 3: Spotlight (diver's flashlight)
+    vec3 SpotLightDir;
+    vec3 SpotLightColor;
+};
+
 uniform mat4 ModelMatrix;
 
 // Output to fragment shader
@@ -14,14 +32,11 @@ out vec2 texCoord;
 out float fogFactor;
 out vec3 fragNormal;
 out vec3 fragPosition;
-
-// Fog parameters
-uniform float FogDensity;  // How thick the fog is (0.01 - 0.05 typical)
-uniform float FogStart;    // Where fog starts
-uniform float FogEnd;      // Where fog is fully opaque
+out float fadeFactor;
 
 void main() {
     texCoord = TexCoord;
+    fadeFactor = 0.0;
     
     // Calculate world position
     vec4 worldPos = ModelMatrix * vec4(Position, 1.0);
@@ -0,0 +1,90 @@
+// Round trip test of the BMP loader and writer
+// - saveBMP followed by loadBMP must return the exact same pixels
+// - Odd widths cover row padding and the scalar tail after the SSSE3 loop
+// - Bottom up files as written by saveBMP and top down files with a negative height
+// - A large image is converted by several jobs
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <ppgso/ppgso.h>
+
+using namespace ppgso;
+
+const std::string FILE_NAME = "image_bmp_roundtrip.bmp";
+const std::streamoff PIXELS_OFFSET = 122;
+const std::streamoff HEIGHT_OFFSET = 22;
+
+// Different value in each channel of each pixel so swapped channels or rows are detected
+static Image makeImage(int width, int height) {
+  Image image{width, height};
+  for (int y = 0; y < height; y++)
+    for (int x = 0; x < width; x++)
+      image.setPixel(x, y, (x * 7 + y * 3) & 255, (x * 5 + y * 11 + 1) & 255, (x * 13 + y + 2) & 255);
+  return image;
+}
+
+// Turn the bottom up file written by saveBMP into the same image stored top down
+static void makeTopDown(const std::string &file, int width, int height) {
+  std::vector<char> data;
+  {
+    std::ifstream input{file, std::ios::binary};
+    data.assign(std::istreambuf_iterator<char>{input}, std::istreambuf_iterator<char>{});
+  }
+
+  auto row_padded = ((size_t) width * 3 + 3) & ~(size_t) 3;
+  std::vector<char> pixels(data.begin() + PIXELS_OFFSET, data.end());
+  for (int j = 0; j < height; j++)
+    std::copy_n(pixels.begin() + (height - 1 - j) * row_padded, row_padded,
+                data.begin() + PIXELS_OFFSET + j * row_padded);
+
+  int negative = -height;
+  std::copy_n((const char *) &negative, sizeof(negative), data.begin() + HEIGHT_OFFSET);
+
+  std::ofstream output{file, std::ios::binary};
+  output.write(data.data(), data.size());
+}
+
+static bool roundTrip(int width, int height, bool topDown) {
+  auto image = makeImage(width, height);
+  image::saveBMP(image, FILE_NAME);
+  if (topDown) makeTopDown(FILE_NAME, width, height);
+  auto loaded = image::loadBMP(FILE_NAME);
+
+  auto orientation = topDown ? "top down" : "bottom up";
+  if (loaded.width != width || loaded.height != height) {
+    std::cerr << "FAILED: " << width << "x" << height << " " << orientation << " loaded as "
+              << loaded.width << "x" << loaded.height << std::endl;
+    return false;
+  }
+  for (int y = 0; y < height; y++)
+    for (int x = 0; x < width; x++) {
+      auto &expected = image.getPixel(x, y);
+      auto &actual = loaded.getPixel(x, y);
+      if (expected.r != actual.r || expected.g != actual.g || expected.b != actual.b) {
+        std::cerr << "FAILED: " << width << "x" << height << " " << orientation
+                  << " differs at pixel " << x << ", " << y << std::endl;
+        return false;
+      }
+    }
+  return true;
+}
+
+int main() {
+  auto passed = true;
+  for (bool topDown : {false, true}) {
+    for (int width : {1, 2, 3, 5, 6, 7, 11, 17, 33, 101})
+      for (int height : {1, 2, 9})
+        passed = roundTrip(width, height, topDown) && passed;
+    passed = roundTrip(1001, 131, topDown) && passed;
+  }
+  std::remove(FILE_NAME.c_str());
+
+  if (!passed) return EXIT_FAILURE;
+  std::cout << "BMP round trip passed" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,171 @@
+// Stress test of ppgso::JobSystem
+// - Nested parallelFor, continuation chains and background jobs running at the same time
+// - parallelFor inside a background job stays off the waits of other threads
+// - Exceptions thrown by jobs are rethrown by wait after all jobs of the counter have finished
+// - Exceptions of jobs without a counter are reported without stopping the process
+// - Pools are created and destroyed repeatedly to catch races in start up and shut down
+// - Build with -DUSE_THREAD_SANITIZER=ON to run it under ThreadSanitizer
+
+#include <atomic>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <ppgso/ppgso.h>
+
+using namespace ppgso;
+
+const unsigned ROUNDS = 50;
+const size_t ITEMS = 10000;
+
+static unsigned failures = 0;
+
+static void check(bool condition, const char *what) {
+  if (condition) return;
+  std::cerr << "FAILED: " << what << std::endl;
+  failures++;
+}
+
+// Every item is written by exactly one range, nested loops included
+static void testParallelFor(JobSystem &jobs) {
+  std::vector<unsigned> items(ITEMS, 0);
+  jobs.parallelFor(ITEMS / 100, 1, [&](size_t first, size_t last) {
+    for (auto i = first; i < last; i++)
+      jobs.parallelFor(100, 7, [&](size_t innerFirst, size_t innerLast) {
+        for (auto j = innerFirst; j < innerLast; j++)
+          items[i * 100 + j]++;
+      });
+  });
+
+  bool once = true;
+  for (auto item : items)
+    once = once && item == 1;
+  check(once, "parallelFor visits every item once");
+}
+
+// Continuations run only after their dependency, in order along the chain
+static void testContinuations(JobSystem &jobs) {
+  const unsigned length = 64;
+  std::vector<std::unique_ptr<JobSystem::Counter>> counters;
+  for (unsigned i = 0; i < length; i++)
+    counters.emplace_back(new JobSystem::Counter);
+
+  std::atomic<unsigned> step{0};
+  bool ordered = true;
+  jobs.run([&] { step++; }, counters[0].get());
+  for (unsigned i = 1; i < length; i++)
+    jobs.runAfter(*counters[i - 1], [&, i] {
+      if (step != i) ordered = false;
+      step++;
+    }, counters[i].get());
+
+  jobs.wait(*counters.back());
+  check(ordered && step == length, "continuations run in dependency order");
+}
+
+// Waits finish while long background jobs are still running and never run them
+static void testBackground(JobSystem &jobs) {
+  JobSystem::Counter background;
+  std::atomic<bool> release{false};
+  std::atomic<unsigned> finished{0};
+  auto mainThread = std::this_thread::get_id();
+  bool ranOnMain = false;
+
+  for (unsigned i = 0; i < 4; i++)
+    jobs.runBackground([&] {
+      if (std::this_thread::get_id() == mainThread) ranOnMain = true;
+      while (!release) std::this_thread::yield();
+      finished++;
+    }, &background);
+
+  std::atomic<size_t> sum{0};
+  jobs.parallelFor(ITEMS, 64, [&](size_t first, size_t last) { sum += last - first; });
+  check(sum == ITEMS, "parallelFor completes next to background jobs");
+
+  release = true;
+  jobs.wait(background);
+  check(finished == 4 && !ranOnMain, "background jobs run on workers only");
+}
+
+// Ranges of a parallelFor started by a background job are background jobs, the main thread never runs them
+static void testNestedBackground(JobSystem &jobs) {
+  JobSystem::Counter background;
+  std::atomic<bool> ranOnMain{false};
+  std::atomic<bool> inherited{true};
+  auto mainThread = std::this_thread::get_id();
+
+  jobs.runBackground([&] {
+    jobs.parallelFor(ITEMS, 16, [&](size_t, size_t) {
+      if (std::this_thread::get_id() == mainThread) ranOnMain = true;
+      if (!JobSystem::isBackground()) inherited = false;
+      std::this_thread::yield();
+    });
+  }, &background);
+
+  // Keep the main thread waiting on frame work while the background ranges are queued
+  while (!background.done()) {
+    std::atomic<size_t> sum{0};
+    jobs.parallelFor(256, 16, [&](size_t first, size_t last) {
+      if (JobSystem::isBackground()) inherited = false;
+      sum += last - first;
+    });
+  }
+  jobs.wait(background);
+  check(!ranOnMain && inherited, "nested background ranges stay off the main thread");
+}
+
+// The first exception reaches the waiting thread, after all jobs of the counter have finished
+static void testExceptions(JobSystem &jobs) {
+  std::atomic<unsigned> ran{0};
+  bool thrown = false;
+  try {
+    jobs.parallelFor(ITEMS, 16, [&](size_t first, size_t) {
+      ran++;
+      if (first % 1600 == 0) throw std::runtime_error("job failed");
+    });
+  } catch (std::runtime_error &) {
+    thrown = true;
+  }
+  check(thrown && ran == (ITEMS + 15) / 16, "exception is rethrown after all ranges finished");
+
+  // The error is consumed by the wait, the counter can be reused
+  JobSystem::Counter counter;
+  jobs.runBackground([] { throw std::runtime_error("load failed"); }, &counter);
+  thrown = false;
+  try {
+    jobs.wait(counter);
+  } catch (std::runtime_error &) {
+    thrown = true;
+  }
+  check(thrown, "background exception is rethrown");
+  jobs.run([] {}, &counter);
+  jobs.wait(counter);
+
+  // Without a counter the error is reported and the pool keeps running
+  JobSystem::Counter after;
+  jobs.run([] { throw std::runtime_error("unobserved job failed"); });
+  jobs.run([] {}, &after);
+  jobs.wait(after);
+}
+
+int main() {
+  for (unsigned round = 0; round < ROUNDS; round++) {
+    JobSystem jobs{1 + round % 4};
+    testParallelFor(jobs);
+    testContinuations(jobs);
+    testBackground(jobs);
+    testNestedBackground(jobs);
+    testExceptions(jobs);
+  }
+
+  testParallelFor(JobSystem::shared());
+  testBackground(JobSystem::shared());
+
+  if (failures) {
+    std::cerr << failures << " checks failed" << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::cout << "All job system checks passed" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,96 @@
+// Validation test of ppgso::TextureCache
+// - A cache written from a full mip chain is accepted for its format and rejected for another
+// - Levels whose size does not match their format and dimensions are rejected
+// - Levels that are not the next step of the mip chain, or a chain cut short, are rejected
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <ppgso/ppgso.h>
+
+using namespace ppgso;
+
+const std::string FILE_NAME = "texture_cache_validation.texcache";
+const uint64_t SOURCE_HASH = 0x1234;
+
+static unsigned failures = 0;
+
+static void check(bool condition, const char *what) {
+  if (condition) return;
+  std::cerr << "FAILED: " << what << std::endl;
+  failures++;
+}
+
+// Level views of a full chain of the given format, the payloads are kept in storage
+static std::vector<TextureCache::Level> makeChain(GLenum format, uint32_t width, uint32_t height,
+                                                  std::vector<std::vector<uint8_t>> &storage) {
+  std::vector<TextureCache::Level> levels;
+  storage.clear();
+  for (int i = 0; i < image::mipLevelCount((int) width, (int) height); i++) {
+    TextureCache::Level level;
+    level.width = std::max(1u, width >> i);
+    level.height = std::max(1u, height >> i);
+    auto size = format == GL_RGB8 ? (size_t) level.width * level.height * 3
+                                  : image::bc1Size((int) level.width, (int) level.height);
+    storage.emplace_back(size, (uint8_t) i);
+    level.data = storage.back().data();
+    level.size = (uint32_t) size;
+    levels.push_back(level);
+  }
+  return levels;
+}
+
+static bool accepted(GLenum format, const std::vector<TextureCache::Level> &levels, GLenum expected) {
+  TextureCache::write(FILE_NAME, SOURCE_HASH, format, levels);
+  return TextureCache{FILE_NAME, SOURCE_HASH, expected}.valid();
+}
+
+int main() {
+  std::vector<std::vector<uint8_t>> storage;
+
+  for (GLenum format : {(GLenum) GL_RGB8, (GLenum) GL_COMPRESSED_RGB_S3TC_DXT1_EXT}) {
+    for (auto size : {std::make_pair(1u, 1u), std::make_pair(5u, 3u), std::make_pair(64u, 17u)}) {
+      auto levels = makeChain(format, size.first, size.second, storage);
+      check(accepted(format, levels, format), "full chain is accepted");
+
+      TextureCache cache{FILE_NAME, SOURCE_HASH, format};
+      check(cache.getLevels().size() == levels.size() && cache.getLevels().back().data[0] == levels.size() - 1,
+            "levels point at their payloads");
+    }
+
+    auto levels = makeChain(format, 64, 17, storage);
+    auto other = format == GL_RGB8 ? (GLenum) GL_COMPRESSED_RGB_S3TC_DXT1_EXT : (GLenum) GL_RGB8;
+    check(!accepted(format, levels, other), "other format is rejected");
+
+    // Smaller than the dimensions, uploading it would read past the payload
+    auto small = levels;
+    small[1].size -= 1;
+    check(!accepted(format, small, format), "short level is rejected");
+
+    auto large = levels;
+    large.front().width *= 2;
+    check(!accepted(format, large, format), "level larger than its payload is rejected");
+
+    auto skipped = levels;
+    skipped.erase(skipped.begin() + 1);
+    check(!accepted(format, skipped, format), "chain with a skipped level is rejected");
+
+    auto cut = levels;
+    cut.pop_back();
+    check(!accepted(format, cut, format), "chain without the 1x1 level is rejected");
+
+    auto resized = levels;
+    resized[2].width += 1;
+    check(!accepted(format, resized, format), "level with wrong dimensions is rejected");
+  }
+  std::remove(FILE_NAME.c_str());
+
+  if (failures) {
+    std::cerr << failures << " checks failed" << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::cout << "Texture cache validation passed" << std::endl;
+  return EXIT_SUCCESS;
+}
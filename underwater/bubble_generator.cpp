@@ -1,45 +1,109 @@
+#include <algorithm>
+#include <cmath>
 #include "bubble_generator.h"
-#include "bubble.h"
 #include "underwater_scene.h"
 #include "underwater_camera.h"
 
+#include <shaders/underwater_instanced_vert_glsl.h>
+#include <shaders/underwater_frag_glsl.h>
+
+// Static resources
+std::shared_ptr<ppgso::Mesh> BubbleGenerator::mesh;
+std::shared_ptr<ppgso::Texture> BubbleGenerator::texture;
+std::shared_ptr<ppgso::Shader> BubbleGenerator::shader;
+
 BubbleGenerator::BubbleGenerator() {
+    // Load shared resources - instanced underwater shader with fog, without sway
+    if (!shader) {
+        shader = ppgso::ShaderRegistry::get(underwater_instanced_vert_glsl, underwater_frag_glsl);
+        shader->setUniformBlock("SceneBlock", UnderwaterScene::SceneBlockBinding);
+    }
+    if (!mesh) mesh = ppgso::AssetLoader::shared().loadMesh("bubble/sphere.obj");
+    // Use ground texture temporarily until bubbleTexture.bmp is converted to 24-bit
+    if (!texture) texture = ppgso::AssetLoader::shared().loadTexture("ground/ground.bmp", ppgso::TextureOptions::compressed());
+
     // Generator at bottom of scene
     position = {0, -9, 0};
+    generateModelMatrix();
+
+    // Bubbles are translucent and drawn with blending
+    translucent = true;
+    renderState.blend = true;
+    setDrawResources(shader.get(), texture.get(), mesh.get());
+
+    bubbles.reserve(static_cast<size_t>(maxBubbles));
+    glGenBuffers(1, &instanceVBO);
+    glGenBuffers(1, &fadeVBO);
 }
 
-bool BubbleGenerator::update(UnderwaterScene& scene, float dt) {
-    spawnTimer += dt;
+BubbleGenerator::~BubbleGenerator() {
+    if (instanceVBO != 0) {
+        glDeleteBuffers(1, &instanceVBO);
+    }
+    if (fadeVBO != 0) {
+        glDeleteBuffers(1, &fadeVBO);
+    }
+}
+
+void BubbleGenerator::spawn() {
+    auto i = bubbles.indexOf(bubbles.create());
+    std::uniform_real_distribution<float> unit;
+    
+    // Random position within spawn radius
+    float angle = unit(random) * 6.28f;
+    float dist = unit(random) * spawnRadius;
+    bubbles.position[i] = position + glm::vec3(cos(angle) * dist, 0, sin(angle) * dist);
     
-    // Count current bubbles (rough estimate - not all objects are bubbles)
-    // In production, you'd track this more precisely
+    // Random lifetime
+    bubbles.lifetime[i] = 8.0f + unit(random) * 6.0f;
+    
+    // Random wobble and rise speed, the rise speed is kept in the vertical velocity
+    bubbles.phase[i] = unit(random) * 6.28f;
+    bubbles.phaseRate[i] = 2.0f + unit(random) * 4.0f;
+    bubbles.velocity[i].y = 1.5f + unit(random) * 2.0f;
+    bubbles.scale[i] = glm::vec3(0.1f);
+    
+    // Spawned after integrate, the matrix would otherwise stay identity until the next frame
+    bubbles.updateModelMatrices(i, i + 1);
+}
+
+void BubbleGenerator::integrate(size_t first, size_t last, float dt) {
+    for (auto i = first; i < last; i++) {
+        bubbles.age[i] += dt;
+        bubbles.phase[i] += bubbles.phaseRate[i] * dt;
+        
+        // Wobble sideways while rising
+        auto phase = bubbles.phase[i];
+        auto& velocity = bubbles.velocity[i];
+        velocity.x = std::sin(phase) * wobbleAmp;
+        velocity.z = std::cos(phase * 0.7f) * wobbleAmp * 0.5f;
+        bubbles.position[i] += velocity * dt;
+        
+        // Slowly grow as bubble rises (pressure decreases)
+        bubbles.scale[i] = glm::vec3(0.1f * (1.0f + bubbles.age[i] * 0.02f));
+    }
+    bubbles.updateModelMatrices(first, last);
+}
+
+void BubbleGenerator::expire() {
+    // Backwards so the entity moved into a removed slot was already visited
+    for (auto i = bubbles.size(); i-- > 0;) {
+        if (bubbles.age[i] > bubbles.lifetime[i] || bubbles.position[i].y > surfaceHeight) {
+            bubbles.destroyAt(i);
+        }
+    }
+}
+
+bool BubbleGenerator::update(UnderwaterScene& scene, float dt) {
+    integrate(0, bubbles.size(), dt);
+    expire();
     
     // Spawn bubbles at regular intervals
+    spawnTimer += dt;
     if (spawnTimer >= spawnRate) {
         spawnTimer = 0.0f;
-        
-        for (int i = 0; i < bubblesPerSpawn; i++) {
-            auto bubble = std::make_unique<Bubble>();
-            
-            // Random position within spawn radius
-            float angle = static_cast<float>(rand()) / RAND_MAX * 6.28f;
-            float dist = static_cast<float>(rand()) / RAND_MAX * spawnRadius;
-            
-            bubble->position = position + glm::vec3(
-                cos(angle) * dist,
-                0,
-                sin(angle) * dist
-            );
-            
-            // Random size
-            float size = 0.05f + static_cast<float>(rand()) / RAND_MAX * 0.15f;
-            bubble->setSize(size);
-            
-            // Random lifetime
-            float lifetime = 8.0f + static_cast<float>(rand()) / RAND_MAX * 6.0f;
-            bubble->setLifetime(lifetime);
-            
-            scene.objects.push_back(std::move(bubble));
+        for (int i = 0; i < bubblesPerSpawn && bubbles.size() < static_cast<size_t>(maxBubbles); i++) {
+            spawn();
         }
     }
     
@@ -47,7 +111,57 @@ bool BubbleGenerator::update(UnderwaterScene& scene, float dt) {
 }
 
 void BubbleGenerator::render(UnderwaterScene& scene) {
-    // Generator is invisible - does not render
+    // Collect the bubbles inside the view frustum with their view space depth
+    auto sphere = mesh->getBoundingSphere();
+    auto& view = scene.camera->viewMatrix;
+    glm::vec3 depthRow{view[0][2], view[1][2], view[2][2]};
+    visibleBubbles.clear();
+    for (size_t i = 0; i < bubbles.size(); i++) {
+        if (!scene.frustum.intersects(sphere.transform(bubbles.modelMatrix[i]))) continue;
+        auto depth = glm::dot(depthRow, bubbles.position[i]) + view[3][2];
+        visibleBubbles.emplace_back(depth, static_cast<uint32_t>(i));
+    }
+    
+    auto visibleCount = visibleBubbles.size();
+    scene.statistics.visibleInstances += static_cast<unsigned int>(visibleCount);
+    scene.statistics.culledInstances += static_cast<unsigned int>(bubbles.size() - visibleCount);
+    if (visibleCount == 0) return;
+    
+    // Blending needs the farthest bubbles first, view space depth is more negative further away
+    std::sort(visibleBubbles.begin(), visibleBubbles.end(),
+              [](const std::pair<float, uint32_t>& a, const std::pair<float, uint32_t>& b) { return a.first < b.first; });
+    
+    // Fade out over the last 20% of the lifetime
+    auto fadeStart = 0.8f;
+    visibleMatrices.resize(visibleCount);
+    visibleFades.resize(visibleCount);
+    for (size_t v = 0; v < visibleCount; v++) {
+        auto i = visibleBubbles[v].second;
+        auto life = bubbles.age[i] / bubbles.lifetime[i];
+        visibleMatrices[v] = bubbles.modelMatrix[i];
+        visibleFades[v] = glm::clamp((life - fadeStart) / (1.0f - fadeStart), 0.0f, 1.0f);
+    }
+    
+    // Orphan the previous contents so the upload does not wait for the last frame's draw
+    instanceCapacity = glm::max(instanceCapacity, visibleCount);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, instanceCapacity * sizeof(glm::mat4), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, visibleCount * sizeof(glm::mat4), visibleMatrices.data());
+    glBindBuffer(GL_ARRAY_BUFFER, fadeVBO);
+    glBufferData(GL_ARRAY_BUFFER, instanceCapacity * sizeof(float), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, visibleCount * sizeof(float), visibleFades.data());
+    
+    shader->use();
+    shader->setUniform("Texture", *texture);
+    shader->setUniform("TextureOffset", glm::vec2(0.0f));
+    shader->setUniform("SwayAmplitude", 0.0f);
+    shader->setUniform("Transparency", 0.6f);
+    
+    // All bubbles in one instanced draw, the fade scales the transparency per instance
+    mesh->setInstanceMatrices(instanceVBO, 3);
+    mesh->setInstanceAttribute(0, 7, 4);
+    mesh->setInstanceAttribute(fadeVBO, 8, 1);
+    mesh->renderInstanced(static_cast<int>(visibleCount));
 }
 
 void BubbleGenerator::setSpawnRate(float rate) {
@@ -61,3 +175,8 @@ void BubbleGenerator::setBubblesPerSpawn(int count) {
 void BubbleGenerator::setSpawnRadius(float radius) {
     spawnRadius = radius;
 }
+
+void BubbleGenerator::setMaxBubbles(int count) {
+    maxBubbles = count;
+    bubbles.reserve(static_cast<size_t>(count));
+}
@@ -1,23 +1,55 @@
 #ifndef BUBBLE_GENERATOR_H
 #define BUBBLE_GENERATOR_H
 
+#include <memory>
+#include <random>
+#include <vector>
 #include <ppgso/ppgso.h>
 #include "underwater_object.h"
 
 /*!
- * Generator that spawns bubbles continuously
- * Does not render itself, only manages bubble creation
+ * Bubble particle system - spawns bubbles that rise to the surface
+ *
+ * Bubbles are not scene objects: they live in a structure of arrays entity storage and are
+ * updated by tight loops over the whole range, then drawn with one instanced draw. The generator
+ * itself is the single scene object that adapts the bubbles to the object list.
  */
 class BubbleGenerator : public UnderwaterObject {
 private:
+    static std::shared_ptr<ppgso::Mesh> mesh;
+    static std::shared_ptr<ppgso::Texture> texture;
+    static std::shared_ptr<ppgso::Shader> shader;
+
     float spawnTimer = 0.0f;
     float spawnRate = 0.05f;  // Seconds between spawns
     int bubblesPerSpawn = 3;  // How many bubbles to spawn at once
     float spawnRadius = 30.0f; // Area where bubbles can spawn
     int maxBubbles = 5000;     // Maximum bubbles in scene
 
+    // Bubble motion
+    float wobbleAmp = 0.3f;
+    float surfaceHeight = 5.0f;
+
+    // Own generator for spawn, which runs on worker threads where rand() would race
+    std::minstd_rand random{static_cast<std::minstd_rand::result_type>(rand())};
+
+    ppgso::EntityStorage bubbles;
+
+    // Visible bubbles sorted back to front with their matrices and fades, rebuilt every frame
+    std::vector<std::pair<float, uint32_t>> visibleBubbles;
+    std::vector<glm::mat4> visibleMatrices;
+    std::vector<float> visibleFades;
+    GLuint instanceVBO = 0;
+    GLuint fadeVBO = 0;
+    size_t instanceCapacity = 0;
+
+    void spawn();
+    void integrate(size_t first, size_t last, float dt);
+    void expire();
+
 public:
     BubbleGenerator();
+    ~BubbleGenerator();
 
     bool update(UnderwaterScene& scene, float dt) override;
     void render(UnderwaterScene& scene) override;
@@ -28,6 +60,12 @@ public:
     void setSpawnRate(float rate);
     void setBubblesPerSpawn(int count);
     void setSpawnRadius(float radius);
+    void setMaxBubbles(int count);
+
+    /*!
+     * Get the number of live bubbles
+     */
+    size_t getBubbleCount() const { return bubbles.size(); }
 };
 
 #endif // BUBBLE_GENERATOR_H
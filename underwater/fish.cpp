@@ -7,15 +7,23 @@
 #include <shaders/underwater_frag_glsl.h>
 
 // Static resources
-std::unique_ptr<ppgso::Mesh> Fish::mesh;
-std::unique_ptr<ppgso::Texture> Fish::texture;
-std::unique_ptr<ppgso::Shader> Fish::shader;
+std::shared_ptr<ppgso::Mesh> Fish::mesh;
+std::shared_ptr<ppgso::Texture> Fish::texture;
+std::shared_ptr<ppgso::Shader> Fish::shader;
 
 Fish::Fish() {
     // Load shared resources - underwater shader with fog
-    if (!shader) shader = std::make_unique<ppgso::Shader>(underwater_vert_glsl, underwater_frag_glsl);
-    if (!mesh) mesh = std::make_unique<ppgso::Mesh>("fish2/13007_Blue-Green_Reef_Chromis_v2_l3.obj");
-    if (!texture) texture = std::make_unique<ppgso::Texture>(ppgso::image::loadBMP("fish2/13004_Bicolor_Blenny_v1_diff.bmp"));
+    if (!shader) {
+        shader = ppgso::ShaderRegistry::get(underwater_vert_glsl, underwater_frag_glsl);
+        shader->setUniformBlock("SceneBlock", UnderwaterScene::SceneBlockBinding);
+    }
+    if (!mesh) {
+        // Simplified levels for distant and small instances
+        auto options = ppgso::MeshOptions::compact();
+        options.lodRatios = {0.5f, 0.25f, 0.1f};
+        mesh = ppgso::AssetLoader::shared().loadMesh("fish2/13007_Blue-Green_Reef_Chromis_v2_l3.obj", options);
+    }
+    if (!texture) texture = ppgso::AssetLoader::shared().loadTexture("fish2/13004_Bicolor_Blenny_v1_diff.bmp", ppgso::TextureOptions::compressed());
 
     // Default scale
     scale = {0.5f, 0.5f, 0.5f};
@@ -29,6 +37,8 @@ Fish::Fish() {
     
     // Random tail phase
     tailPhase = static_cast<float>(rand()) / RAND_MAX * 6.28f;
+    
+    setDrawResources(shader.get(), texture.get(), mesh.get());
 }
 
 bool Fish::update(UnderwaterScene& scene, float dt) {
@@ -47,7 +57,8 @@ bool Fish::update(UnderwaterScene& scene, float dt) {
     if (timeSinceLastTurn >= timeUntilNextTurn) {
         timeSinceLastTurn = 0.0f;
         // Next turn in 3-7 seconds
-        timeUntilNextTurn = 3.0f + static_cast<float>(rand()) / RAND_MAX * 4.0f;
+        std::uniform_real_distribution<float> unit;
+        timeUntilNextTurn = 3.0f + unit(random) * 4.0f;
         
         // Check if too far from school center
         glm::vec3 toCenter = schoolCenter - position;
@@ -58,7 +69,7 @@ bool Fish::update(UnderwaterScene& scene, float dt) {
             targetYaw = atan2(toCenter.x, toCenter.z);
         } else {
             // Random turn within school area
-            targetYaw = currentYaw + (static_cast<float>(rand()) / RAND_MAX - 0.5f) * 2.0f;
+            targetYaw = currentYaw + (unit(random) - 0.5f) * 2.0f;
         }
     }
     
@@ -97,35 +108,19 @@ bool Fish::update(UnderwaterScene& scene, float dt) {
 void Fish::render(UnderwaterScene& scene) {
     shader->use();
     
-    shader->setUniform("ProjectionMatrix", scene.camera->projectionMatrix);
-    shader->setUniform("ViewMatrix", scene.camera->viewMatrix);
     shader->setUniform("ModelMatrix", modelMatrix);
     
-    // Directional light (sun)
-    shader->setUniform("LightDirection", scene.lightDirection);
-    shader->setUniform("CameraPosition", scene.camera->position);
-    
-    // Point light (bioluminescent)
-    shader->setUniform("PointLightPos", scene.pointLightPos);
-    shader->setUniform("PointLightColor", scene.pointLightColor);
-    shader->setUniform("PointLightIntensity", scene.pointLightIntensity);
-    
-    // Spotlight (diver's flashlight)
-    shader->setUniform("SpotLightPos", scene.spotLightPos);
-    shader->setUniform("SpotLightDir", scene.spotLightDir);
-    shader->setUniform("SpotLightColor", scene.spotLightColor);
-    shader->setUniform("SpotLightCutoff", scene.spotLightCutoff);
-    shader->setUniform("SpotLightIntensity", scene.spotLightIntensity);
-    
-    // Fog uniforms
-    shader->setUniform("FogColor", scene.fogColor);
-    shader->setUniform("FogDensity", scene.fogDensity);
-    
     shader->setUniform("Texture", *texture);
     shader->setUniform("Transparency", 1.0f);
     shader->setUniform("TextureOffset", glm::vec2(0.0f));
     
-    mesh->render();
+    mesh->render(mesh->selectLod(screenSize(scene, mesh->getRadius())));
+}
+
+bool Fish::getBounds(ppgso::BoundingBox& bounds) const {
+    // Empty while the mesh is still loading, the object is then drawn unculled
+    bounds = mesh->getBounds().transform(modelMatrix);
+    return !bounds.empty();
 }
 
 void Fish::setTarget(glm::vec3 target) {
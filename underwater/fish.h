@@ -1,6 +1,7 @@
 #ifndef FISH_H
 #define FISH_H
 
+#include <random>
 #include <ppgso/ppgso.h>
 #include "underwater_object.h"
 
@@ -10,9 +11,9 @@
  */
 class Fish : public UnderwaterObject {
 private:
-    static std::unique_ptr<ppgso::Mesh> mesh;
-    static std::unique_ptr<ppgso::Texture> texture;
-    static std::unique_ptr<ppgso::Shader> shader;
+    static std::shared_ptr<ppgso::Mesh> mesh;
+    static std::shared_ptr<ppgso::Texture> texture;
+    static std::shared_ptr<ppgso::Shader> shader;
 
     // Movement parameters
     glm::vec3 velocity{0, 0, 0};
@@ -40,11 +41,15 @@ private:
     float age = 0.0f;
     float lifetime = -1.0f;
 
+    // Own generator for update, which runs on worker threads where rand() would race
+    std::minstd_rand random{static_cast<std::minstd_rand::result_type>(rand())};
+
 public:
     Fish();
 
     bool update(UnderwaterScene& scene, float dt) override;
     void render(UnderwaterScene& scene) override;
+    bool getBounds(ppgso::BoundingBox& bounds) const override;
     
     void setTarget(glm::vec3 target);
     void setSpeed(float speed);
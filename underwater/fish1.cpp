@@ -7,15 +7,18 @@
 #include <shaders/underwater_frag_glsl.h>
 
 // Static resources
-std::unique_ptr<ppgso::Mesh> Fish1::mesh;
-std::unique_ptr<ppgso::Texture> Fish1::texture;
-std::unique_ptr<ppgso::Shader> Fish1::shader;
+std::shared_ptr<ppgso::Mesh> Fish1::mesh;
+std::shared_ptr<ppgso::Texture> Fish1::texture;
+std::shared_ptr<ppgso::Shader> Fish1::shader;
 
 Fish1::Fish1() {
     // Load shared resources - underwater shader with fog
-    if (!shader) shader = std::make_unique<ppgso::Shader>(underwater_vert_glsl, underwater_frag_glsl);
-    if (!mesh) mesh = std::make_unique<ppgso::Mesh>("fish1/fish.obj");
-    if (!texture) texture = std::make_unique<ppgso::Texture>(ppgso::image::loadBMP("fish1/fish_24bit.bmp"));
+    if (!shader) {
+        shader = ppgso::ShaderRegistry::get(underwater_vert_glsl, underwater_frag_glsl);
+        shader->setUniformBlock("SceneBlock", UnderwaterScene::SceneBlockBinding);
+    }
+    if (!mesh) mesh = ppgso::AssetLoader::shared().loadMesh("fish1/fish.obj");
+    if (!texture) texture = ppgso::AssetLoader::shared().loadTexture("fish1/fish_24bit.bmp", ppgso::TextureOptions::compressed());
 
     // Default scale - adjust based on model size
     scale = {0.3f, 0.3f, 0.3f};
@@ -31,6 +34,8 @@ Fish1::Fish1() {
     
     // Random turn timing
     nextTurnTime = 3.0f + static_cast<float>(rand()) / RAND_MAX * 4.0f;
+    
+    setDrawResources(shader.get(), texture.get(), mesh.get());
 }
 
 bool Fish1::update(UnderwaterScene& scene, float dt) {
@@ -43,7 +48,8 @@ bool Fish1::update(UnderwaterScene& scene, float dt) {
     // Time for a new turn?
     if (turnTimer >= nextTurnTime) {
         turnTimer = 0.0f;
-        nextTurnTime = 3.0f + static_cast<float>(rand()) / RAND_MAX * 4.0f;
+        std::uniform_real_distribution<float> unit;
+        nextTurnTime = 3.0f + unit(random) * 4.0f;
         
         // Check if too far from school center
         glm::vec3 toCenter = schoolCenter - position;
@@ -54,7 +60,7 @@ bool Fish1::update(UnderwaterScene& scene, float dt) {
             targetYaw = atan2(toCenter.x, toCenter.z);
         } else {
             // Random turn within school area
-            targetYaw = currentYaw + (static_cast<float>(rand()) / RAND_MAX - 0.5f) * 2.0f;
+            targetYaw = currentYaw + (unit(random) - 0.5f) * 2.0f;
         }
     }
     
@@ -89,30 +95,8 @@ void Fish1::render(UnderwaterScene& scene) {
     shader->use();
     
     // Set matrices
-    shader->setUniform("ProjectionMatrix", scene.camera->projectionMatrix);
-    shader->setUniform("ViewMatrix", scene.camera->viewMatrix);
     shader->setUniform("ModelMatrix", modelMatrix);
     
-    // Directional light (sun)
-    shader->setUniform("LightDirection", scene.lightDirection);
-    shader->setUniform("CameraPosition", scene.camera->position);
-    
-    // Point light (bioluminescent)
-    shader->setUniform("PointLightPos", scene.pointLightPos);
-    shader->setUniform("PointLightColor", scene.pointLightColor);
-    shader->setUniform("PointLightIntensity", scene.pointLightIntensity);
-    
-    // Spotlight (diver's flashlight)
-    shader->setUniform("SpotLightPos", scene.spotLightPos);
-    shader->setUniform("SpotLightDir", scene.spotLightDir);
-    shader->setUniform("SpotLightColor", scene.spotLightColor);
-    shader->setUniform("SpotLightCutoff", scene.spotLightCutoff);
-    shader->setUniform("SpotLightIntensity", scene.spotLightIntensity);
-    
-    // Fog uniforms
-    shader->setUniform("FogColor", scene.fogColor);
-    shader->setUniform("FogDensity", scene.fogDensity);
-    
     // Set texture
     shader->setUniform("Texture", *texture);
     shader->setUniform("Transparency", 1.0f);
@@ -120,3 +104,8 @@ void Fish1::render(UnderwaterScene& scene) {
     
     mesh->render();
 }
+
+bool Fish1::getBounds(ppgso::BoundingBox& bounds) const {
+    bounds = mesh->getBounds().transform(modelMatrix);
+    return !bounds.empty();
+}
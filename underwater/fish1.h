@@ -1,6 +1,7 @@
 #ifndef FISH1_H
 #define FISH1_H
 
+#include <random>
 #include <ppgso/ppgso.h>
 #include "underwater_object.h"
 
@@ -10,9 +11,9 @@
  */
 class Fish1 : public UnderwaterObject {
 private:
-    static std::unique_ptr<ppgso::Mesh> mesh;
-    static std::unique_ptr<ppgso::Texture> texture;
-    static std::unique_ptr<ppgso::Shader> shader;
+    static std::shared_ptr<ppgso::Mesh> mesh;
+    static std::shared_ptr<ppgso::Texture> texture;
+    static std::shared_ptr<ppgso::Shader> shader;
 
     // Swimming parameters
     float speed = 3.0f;
@@ -34,11 +35,15 @@ private:
     float targetYaw = 0.0f;
     float currentYaw = 0.0f;
 
+    // Own generator for update, which runs on worker threads where rand() would race
+    std::minstd_rand random{static_cast<std::minstd_rand::result_type>(rand())};
+
 public:
     Fish1();
 
     bool update(UnderwaterScene& scene, float dt) override;
     void render(UnderwaterScene& scene) override;
+    bool getBounds(ppgso::BoundingBox& bounds) const override;
     
     void setSpeed(float s) { speed = s; }
     void setSchool(int id, glm::vec3 center) { schoolId = id; schoolCenter = center; }
@@ -7,22 +7,32 @@
 #include <shaders/underwater_frag_glsl.h>
 
 // Static resources
-std::unique_ptr<ppgso::Mesh> FishFin::mesh;
-std::unique_ptr<ppgso::Texture> FishFin::texture;
-std::unique_ptr<ppgso::Shader> FishFin::shader;
+std::shared_ptr<ppgso::Mesh> FishFin::mesh;
+std::shared_ptr<ppgso::Texture> FishFin::texture;
+std::shared_ptr<ppgso::Shader> FishFin::shader;
 
 FishFin::FishFin() {
     // Load shared resources - use fish mesh as a simple fin representation
-    if (!shader) shader = std::make_unique<ppgso::Shader>(underwater_vert_glsl, underwater_frag_glsl);
+    if (!shader) {
+        shader = ppgso::ShaderRegistry::get(underwater_vert_glsl, underwater_frag_glsl);
+        shader->setUniformBlock("SceneBlock", UnderwaterScene::SceneBlockBinding);
+    }
     // Use the same fish mesh but scaled down as a fin
-    if (!mesh) mesh = std::make_unique<ppgso::Mesh>("fish2/13007_Blue-Green_Reef_Chromis_v2_l3.obj");
-    if (!texture) texture = std::make_unique<ppgso::Texture>(ppgso::image::loadBMP("fish2/13004_Bicolor_Blenny_v1_diff.bmp"));
+    if (!mesh) {
+        // Same options as Fish so the resource cache shares one mesh, the tiny fins pick the coarse levels
+        auto options = ppgso::MeshOptions::compact();
+        options.lodRatios = {0.5f, 0.25f, 0.1f};
+        mesh = ppgso::AssetLoader::shared().loadMesh("fish2/13007_Blue-Green_Reef_Chromis_v2_l3.obj", options);
+    }
+    if (!texture) texture = ppgso::AssetLoader::shared().loadTexture("fish2/13004_Bicolor_Blenny_v1_diff.bmp", ppgso::TextureOptions::compressed());
 
     // Very small scale - this is a fin/sub-part
     scale = {0.15f, 0.08f, 0.15f};
     
     // Random flap phase
     flapPhase = static_cast<float>(rand()) / RAND_MAX * 6.28f;
+    
+    setDrawResources(shader.get(), texture.get(), mesh.get());
 }
 
 bool FishFin::update(UnderwaterScene& scene, float dt) {
@@ -44,33 +54,16 @@ bool FishFin::update(UnderwaterScene& scene, float dt) {
 void FishFin::render(UnderwaterScene& scene) {
     shader->use();
     
-    shader->setUniform("ProjectionMatrix", scene.camera->projectionMatrix);
-    shader->setUniform("ViewMatrix", scene.camera->viewMatrix);
     shader->setUniform("ModelMatrix", modelMatrix);
     
-    // Fog uniforms
-    shader->setUniform("FogColor", scene.fogColor);
-    shader->setUniform("FogDensity", scene.fogDensity);
-    
-    // Light uniforms
-    shader->setUniform("LightDirection", scene.lightDirection);
-    shader->setUniform("CameraPosition", scene.camera->position);
-    
-    // Point light uniforms
-    shader->setUniform("PointLightPos", scene.pointLightPos);
-    shader->setUniform("PointLightColor", scene.pointLightColor);
-    shader->setUniform("PointLightIntensity", scene.pointLightIntensity);
-    
-    // Spotlight uniforms
-    shader->setUniform("SpotLightPos", scene.spotLightPos);
-    shader->setUniform("SpotLightDir", scene.spotLightDir);
-    shader->setUniform("SpotLightColor", scene.spotLightColor);
-    shader->setUniform("SpotLightCutoff", scene.spotLightCutoff);
-    shader->setUniform("SpotLightIntensity", scene.spotLightIntensity);
-    
     shader->setUniform("Texture", *texture);
     shader->setUniform("Transparency", 1.0f);
     shader->setUniform("TextureOffset", glm::vec2(0.0f));
     
-    mesh->render();
+    mesh->render(mesh->selectLod(screenSize(scene, mesh->getRadius())));
+}
+
+bool FishFin::getBounds(ppgso::BoundingBox& bounds) const {
+    bounds = mesh->getBounds().transform(modelMatrix);
+    return !bounds.empty();
 }
@@ -10,9 +10,9 @@
  */
 class FishFin : public UnderwaterObject {
 private:
-    static std::unique_ptr<ppgso::Mesh> mesh;
-    static std::unique_ptr<ppgso::Texture> texture;
-    static std::unique_ptr<ppgso::Shader> shader;
+    static std::shared_ptr<ppgso::Mesh> mesh;
+    static std::shared_ptr<ppgso::Texture> texture;
+    static std::shared_ptr<ppgso::Shader> shader;
 
     // Animation parameters
     float flapPhase = 0.0f;
@@ -27,6 +27,7 @@ public:
 
     bool update(UnderwaterScene& scene, float dt) override;
     void render(UnderwaterScene& scene) override;
+    bool getBounds(ppgso::BoundingBox& bounds) const override;
     
     void setFlapSpeed(float speed) { flapSpeed = speed; }
     void setLocalOffset(glm::vec3 offset) { localOffset = offset; }
@@ -6,19 +6,29 @@
 #include <shaders/underwater_frag_glsl.h>
 
 // Static resources
-std::unique_ptr<ppgso::Mesh> Ground::mesh;
-std::unique_ptr<ppgso::Texture> Ground::texture;
-std::unique_ptr<ppgso::Shader> Ground::shader;
+std::shared_ptr<ppgso::Mesh> Ground::mesh;
+std::shared_ptr<ppgso::Texture> Ground::texture;
+std::shared_ptr<ppgso::Shader> Ground::shader;
 
 Ground::Ground() {
     // Load shared resources - underwater shader with fog
-    if (!shader) shader = std::make_unique<ppgso::Shader>(underwater_vert_glsl, underwater_frag_glsl);
-    if (!mesh) mesh = std::make_unique<ppgso::Mesh>("ground/quad.obj");
-    if (!texture) texture = std::make_unique<ppgso::Texture>(ppgso::image::loadBMP("sand/natural-yellow-sand-beach-background.bmp"));
+    if (!shader) {
+        shader = ppgso::ShaderRegistry::get(underwater_vert_glsl, underwater_frag_glsl);
+        shader->setUniformBlock("SceneBlock", UnderwaterScene::SceneBlockBinding);
+    }
+    if (!mesh) mesh = ppgso::AssetLoader::shared().loadMesh("ground/quad.obj");
+    if (!texture) texture = ppgso::AssetLoader::shared().loadTexture("sand/natural-yellow-sand-beach-background.bmp", ppgso::TextureOptions::compressed());
 
     // Position and scale - LARGE seabed at y = -15
     position = {0, -15, 0};  // Deep seabed
     scale = {5, 1, 5};       // Large plane (quad is 100x100, so 5x = 500x500 units)
+    
+    // The seabed never moves
+    isStatic = true;
+    
+    // No face culling so ground is visible from both sides
+    renderState.cullFace = false;
+    setDrawResources(shader.get(), texture.get(), mesh.get());
 }
 
 bool Ground::update(UnderwaterScene& scene, float dt) {
@@ -27,43 +37,20 @@ bool Ground::update(UnderwaterScene& scene, float dt) {
 }
 
 void Ground::render(UnderwaterScene& scene) {
-    // Disable face culling so ground is visible from both sides
-    glDisable(GL_CULL_FACE);
-    
     shader->use();
     
     // Set matrices
-    shader->setUniform("ProjectionMatrix", scene.camera->projectionMatrix);
-    shader->setUniform("ViewMatrix", scene.camera->viewMatrix);
     shader->setUniform("ModelMatrix", modelMatrix);
     
-    // Directional light (sun)
-    shader->setUniform("LightDirection", scene.lightDirection);
-    shader->setUniform("CameraPosition", scene.camera->position);
-    
-    // Point light (bioluminescent)
-    shader->setUniform("PointLightPos", scene.pointLightPos);
-    shader->setUniform("PointLightColor", scene.pointLightColor);
-    shader->setUniform("PointLightIntensity", scene.pointLightIntensity);
-    
-    // Spotlight (diver's flashlight)
-    shader->setUniform("SpotLightPos", scene.spotLightPos);
-    shader->setUniform("SpotLightDir", scene.spotLightDir);
-    shader->setUniform("SpotLightColor", scene.spotLightColor);
-    shader->setUniform("SpotLightCutoff", scene.spotLightCutoff);
-    shader->setUniform("SpotLightIntensity", scene.spotLightIntensity);
-    
-    // Fog uniforms
-    shader->setUniform("FogColor", scene.fogColor);
-    shader->setUniform("FogDensity", scene.fogDensity);
-    
     // Set texture
     shader->setUniform("Texture", *texture);
     shader->setUniform("Transparency", 1.0f);
     shader->setUniform("TextureOffset", glm::vec2(0.0f));
     
     mesh->render();
-    
-    // Re-enable culling for other objects
-    glEnable(GL_CULL_FACE);
+}
+
+bool Ground::getBounds(ppgso::BoundingBox& bounds) const {
+    bounds = mesh->getBounds().transform(modelMatrix);
+    return !bounds.empty();
 }
@@ -9,15 +9,16 @@
  */
 class Ground : public UnderwaterObject {
 private:
-    static std::unique_ptr<ppgso::Mesh> mesh;
-    static std::unique_ptr<ppgso::Texture> texture;
-    static std::unique_ptr<ppgso::Shader> shader;
+    static std::shared_ptr<ppgso::Mesh> mesh;
+    static std::shared_ptr<ppgso::Texture> texture;
+    static std::shared_ptr<ppgso::Shader> shader;
 
 public:
     Ground();
 
     bool update(UnderwaterScene& scene, float dt) override;
     void render(UnderwaterScene& scene) override;
+    bool getBounds(ppgso::BoundingBox& bounds) const override;
 };
 
 #endif // GROUND_H
@@ -7,18 +7,29 @@
 #include <shaders/underwater_frag_glsl.h>
 
 // Static resources
-std::unique_ptr<ppgso::Mesh> Jellyfish::mesh;
-std::unique_ptr<ppgso::Texture> Jellyfish::texture;
-std::unique_ptr<ppgso::Shader> Jellyfish::shader;
+std::shared_ptr<ppgso::Mesh> Jellyfish::mesh;
+std::shared_ptr<ppgso::Texture> Jellyfish::texture;
+std::shared_ptr<ppgso::Shader> Jellyfish::shader;
 
 Jellyfish::Jellyfish() {
     // Load shared resources - underwater shader with fog
-    if (!shader) shader = std::make_unique<ppgso::Shader>(underwater_vert_glsl, underwater_frag_glsl);
-    if (!mesh) mesh = std::make_unique<ppgso::Mesh>("jellyfish/21443_Jellyfish_V1.obj");
-    if (!texture) texture = std::make_unique<ppgso::Texture>(ppgso::image::loadBMP("jellyfish/watercol_05_05_22_01.bmp"));
+    if (!shader) {
+        shader = ppgso::ShaderRegistry::get(underwater_vert_glsl, underwater_frag_glsl);
+        shader->setUniformBlock("SceneBlock", UnderwaterScene::SceneBlockBinding);
+    }
+    if (!mesh) {
+        // Simplified levels for distant and small instances
+        auto options = ppgso::MeshOptions::compact();
+        options.lodRatios = {0.5f, 0.25f, 0.1f};
+        mesh = ppgso::AssetLoader::shared().loadMesh("jellyfish/21443_Jellyfish_V1.obj", options);
+    }
+    if (!texture) texture = ppgso::AssetLoader::shared().loadTexture("jellyfish/watercol_05_05_22_01.bmp", ppgso::TextureOptions::compressed());
 
-    // Mark as translucent for depth-sorting
+    // Mark as translucent for depth-sorting, blended and without face culling
     translucent = true;
+    renderState.blend = true;
+    renderState.cullFace = false;
+    setDrawResources(shader.get(), texture.get(), mesh.get());
 
     // Model is small (coords ~0-2 units), need larger scale to be visible
     baseScale = {1.5f, 1.5f, 1.5f};  // Much larger scale
@@ -111,50 +122,22 @@ bool Jellyfish::update(UnderwaterScene& scene, float dt) {
 }
 
 void Jellyfish::render(UnderwaterScene& scene) {
-    // Enable blending for transparency
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    
-    // Disable face culling for translucent objects
-    glDisable(GL_CULL_FACE);
-    
     shader->use();
     
     // Set matrices
-    shader->setUniform("ProjectionMatrix", scene.camera->projectionMatrix);
-    shader->setUniform("ViewMatrix", scene.camera->viewMatrix);
     shader->setUniform("ModelMatrix", modelMatrix);
     
-    // Directional light (sun)
-    shader->setUniform("LightDirection", scene.lightDirection);
-    shader->setUniform("CameraPosition", scene.camera->position);
-    
-    // Point light (bioluminescent)
-    shader->setUniform("PointLightPos", scene.pointLightPos);
-    shader->setUniform("PointLightColor", scene.pointLightColor);
-    shader->setUniform("PointLightIntensity", scene.pointLightIntensity);
-    
-    // Spotlight (diver's flashlight)
-    shader->setUniform("SpotLightPos", scene.spotLightPos);
-    shader->setUniform("SpotLightDir", scene.spotLightDir);
-    shader->setUniform("SpotLightColor", scene.spotLightColor);
-    shader->setUniform("SpotLightCutoff", scene.spotLightCutoff);
-    shader->setUniform("SpotLightIntensity", scene.spotLightIntensity);
-    
-    // Fog uniforms for underwater effect
-    shader->setUniform("FogColor", scene.fogColor);
-    shader->setUniform("FogDensity", scene.fogDensity);
-    
     // Set texture
     shader->setUniform("Texture", *texture);
     shader->setUniform("Transparency", transparency);
     shader->setUniform("TextureOffset", glm::vec2(0.0f));
     
-    mesh->render();
-    
-    // Restore state
-    glEnable(GL_CULL_FACE);
-    glDisable(GL_BLEND);
+    mesh->render(mesh->selectLod(screenSize(scene, mesh->getRadius())));
+}
+
+bool Jellyfish::getBounds(ppgso::BoundingBox& bounds) const {
+    bounds = mesh->getBounds().transform(modelMatrix);
+    return !bounds.empty();
 }
 
 void Jellyfish::setDriftDirection(glm::vec3 dir) {
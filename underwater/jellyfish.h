@@ -10,9 +10,9 @@
  */
 class Jellyfish : public UnderwaterObject {
 private:
-    static std::unique_ptr<ppgso::Mesh> mesh;
-    static std::unique_ptr<ppgso::Texture> texture;
-    static std::unique_ptr<ppgso::Shader> shader;
+    static std::shared_ptr<ppgso::Mesh> mesh;
+    static std::shared_ptr<ppgso::Texture> texture;
+    static std::shared_ptr<ppgso::Shader> shader;
 
     // Movement - jellyfish propel by contracting their bell
     glm::vec3 velocity{0, 0, 0};
@@ -42,6 +42,7 @@ public:
 
     bool update(UnderwaterScene& scene, float dt) override;
     void render(UnderwaterScene& scene) override;
+    bool getBounds(ppgso::BoundingBox& bounds) const override;
     
     /*!
      * Set jellyfish properties
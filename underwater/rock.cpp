@@ -6,15 +6,18 @@
 #include <shaders/underwater_frag_glsl.h>
 
 // Static resources
-std::unique_ptr<ppgso::Mesh> Rock::mesh;
-std::unique_ptr<ppgso::Texture> Rock::texture;
-std::unique_ptr<ppgso::Shader> Rock::shader;
+std::shared_ptr<ppgso::Mesh> Rock::mesh;
+std::shared_ptr<ppgso::Texture> Rock::texture;
+std::shared_ptr<ppgso::Shader> Rock::shader;
 
 Rock::Rock() {
     // Load shared resources
-    if (!shader) shader = std::make_unique<ppgso::Shader>(underwater_vert_glsl, underwater_frag_glsl);
-    if (!mesh) mesh = std::make_unique<ppgso::Mesh>("rock/Rock1_noplane.obj");  // Without base plane
-    if (!texture) texture = std::make_unique<ppgso::Texture>(ppgso::image::loadBMP("rock/Rock-Texture-Surface.bmp"));
+    if (!shader) {
+        shader = ppgso::ShaderRegistry::get(underwater_vert_glsl, underwater_frag_glsl);
+        shader->setUniformBlock("SceneBlock", UnderwaterScene::SceneBlockBinding);
+    }
+    if (!mesh) mesh = ppgso::AssetLoader::shared().loadMesh("rock/Rock1_noplane.obj");  // Without base plane
+    if (!texture) texture = ppgso::AssetLoader::shared().loadTexture("rock/Rock-Texture-Surface.bmp", ppgso::TextureOptions::compressed());
 
     // Random scale variation for each rock
     float s = 0.3f + static_cast<float>(rand()) / RAND_MAX * 0.4f;
@@ -22,6 +25,11 @@ Rock::Rock() {
     
     // Random rotation for variety
     rotation.y = static_cast<float>(rand()) / RAND_MAX * glm::pi<float>() * 2.0f;
+    
+    // Rocks stay where the scene places them
+    isStatic = true;
+    
+    setDrawResources(shader.get(), texture.get(), mesh.get());
 }
 
 bool Rock::update(UnderwaterScene& scene, float dt) {
@@ -33,30 +41,8 @@ void Rock::render(UnderwaterScene& scene) {
     shader->use();
     
     // Set matrices
-    shader->setUniform("ProjectionMatrix", scene.camera->projectionMatrix);
-    shader->setUniform("ViewMatrix", scene.camera->viewMatrix);
     shader->setUniform("ModelMatrix", modelMatrix);
     
-    // Directional light (sun)
-    shader->setUniform("LightDirection", scene.lightDirection);
-    shader->setUniform("CameraPosition", scene.camera->position);
-    
-    // Point light (bioluminescent)
-    shader->setUniform("PointLightPos", scene.pointLightPos);
-    shader->setUniform("PointLightColor", scene.pointLightColor);
-    shader->setUniform("PointLightIntensity", scene.pointLightIntensity);
-    
-    // Spotlight (diver's flashlight)
-    shader->setUniform("SpotLightPos", scene.spotLightPos);
-    shader->setUniform("SpotLightDir", scene.spotLightDir);
-    shader->setUniform("SpotLightColor", scene.spotLightColor);
-    shader->setUniform("SpotLightCutoff", scene.spotLightCutoff);
-    shader->setUniform("SpotLightIntensity", scene.spotLightIntensity);
-    
-    // Set underwater fog uniforms
-    shader->setUniform("FogColor", scene.fogColor);
-    shader->setUniform("FogDensity", scene.fogDensity);
-    
     // Set texture
     shader->setUniform("Texture", *texture);
     shader->setUniform("Transparency", 1.0f);
@@ -64,3 +50,8 @@ void Rock::render(UnderwaterScene& scene) {
     
     mesh->render();
 }
+
+bool Rock::getBounds(ppgso::BoundingBox& bounds) const {
+    bounds = mesh->getBounds().transform(modelMatrix);
+    return !bounds.empty();
+}
@@ -7,15 +7,18 @@
 #include <shaders/underwater_frag_glsl.h>
 
 // Static resources
-std::unique_ptr<ppgso::Mesh> Seaweed::mesh;
-std::unique_ptr<ppgso::Texture> Seaweed::texture;
-std::unique_ptr<ppgso::Shader> Seaweed::shader;
+std::shared_ptr<ppgso::Mesh> Seaweed::mesh;
+std::shared_ptr<ppgso::Texture> Seaweed::texture;
+std::shared_ptr<ppgso::Shader> Seaweed::shader;
 
 Seaweed::Seaweed() {
     // Load shared resources - underwater shader with fog
-    if (!shader) shader = std::make_unique<ppgso::Shader>(underwater_vert_glsl, underwater_frag_glsl);
-    if (!mesh) mesh = std::make_unique<ppgso::Mesh>("seaweed/maya2sketchfab.obj");
-    if (!texture) texture = std::make_unique<ppgso::Texture>(ppgso::image::loadBMP("seaweed/abstract-solid-shining-yellow-gradient-studio-wall-room-background.bmp"));
+    if (!shader) {
+        shader = ppgso::ShaderRegistry::get(underwater_vert_glsl, underwater_frag_glsl);
+        shader->setUniformBlock("SceneBlock", UnderwaterScene::SceneBlockBinding);
+    }
+    if (!mesh) mesh = ppgso::AssetLoader::shared().loadMesh("seaweed/maya2sketchfab.obj", ppgso::MeshOptions::compact());
+    if (!texture) texture = ppgso::AssetLoader::shared().loadTexture("seaweed/abstract-solid-shining-yellow-gradient-studio-wall-room-background.bmp", ppgso::TextureOptions::compressed());
 
     // Default scale
     scale = {0.5f, 0.5f, 0.5f};
@@ -27,6 +30,13 @@ Seaweed::Seaweed() {
     
     // No base rotation - keep model as-is
     baseRotation = glm::vec3(0.0f);
+    
+    // Only sways in place, getBounds covers the whole sway
+    isStatic = true;
+    
+    // No culling for plants (two-sided leaves)
+    renderState.cullFace = false;
+    setDrawResources(shader.get(), texture.get(), mesh.get());
 }
 
 bool Seaweed::update(UnderwaterScene& scene, float dt) {
@@ -42,42 +52,26 @@ bool Seaweed::update(UnderwaterScene& scene, float dt) {
 }
 
 void Seaweed::render(UnderwaterScene& scene) {
-    // Disable culling for plants (two-sided leaves)
-    glDisable(GL_CULL_FACE);
-    
     shader->use();
     
     // Set matrices
-    shader->setUniform("ProjectionMatrix", scene.camera->projectionMatrix);
-    shader->setUniform("ViewMatrix", scene.camera->viewMatrix);
     shader->setUniform("ModelMatrix", modelMatrix);
     
-    // Directional light (sun)
-    shader->setUniform("LightDirection", scene.lightDirection);
-    shader->setUniform("CameraPosition", scene.camera->position);
-    
-    // Point light (bioluminescent)
-    shader->setUniform("PointLightPos", scene.pointLightPos);
-    shader->setUniform("PointLightColor", scene.pointLightColor);
-    shader->setUniform("PointLightIntensity", scene.pointLightIntensity);
-    
-    // Spotlight (diver's flashlight)
-    shader->setUniform("SpotLightPos", scene.spotLightPos);
-    shader->setUniform("SpotLightDir", scene.spotLightDir);
-    shader->setUniform("SpotLightColor", scene.spotLightColor);
-    shader->setUniform("SpotLightCutoff", scene.spotLightCutoff);
-    shader->setUniform("SpotLightIntensity", scene.spotLightIntensity);
-    
-    // Fog uniforms
-    shader->setUniform("FogColor", scene.fogColor);
-    shader->setUniform("FogDensity", scene.fogDensity);
-    
     // Set texture
     shader->setUniform("Texture", *texture);
     shader->setUniform("Transparency", 1.0f);
     shader->setUniform("TextureOffset", glm::vec2(0.0f));
     
     mesh->render();
+}
+
+bool Seaweed::getBounds(ppgso::BoundingBox& bounds) const {
+    bounds = mesh->getBounds().transform(modelMatrix);
+    if (bounds.empty()) return false;
     
-    glEnable(GL_CULL_FACE);
+    // Any other sway angle moves the plant by at most its size times the angle difference
+    float margin = glm::length(bounds.max - bounds.min) * swayAmplitude * 3.0f;
+    bounds.min -= glm::vec3(margin);
+    bounds.max += glm::vec3(margin);
+    return true;
 }
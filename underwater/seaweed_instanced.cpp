@@ -1,23 +1,27 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <cmath>
 #include <iostream>
 #include "seaweed_instanced.h"
 #include "underwater_scene.h"
 #include "underwater_camera.h"
 
-#include <shaders/underwater_vert_glsl.h>
+#include <shaders/underwater_instanced_vert_glsl.h>
 #include <shaders/underwater_frag_glsl.h>
 
 // Static resources
-std::unique_ptr<ppgso::Shader> SeaweedInstanced::shader;
-std::unique_ptr<ppgso::Mesh> SeaweedInstanced::mesh;
-std::unique_ptr<ppgso::Texture> SeaweedInstanced::texture;
+std::shared_ptr<ppgso::Shader> SeaweedInstanced::shader;
+std::shared_ptr<ppgso::Mesh> SeaweedInstanced::mesh;
+std::shared_ptr<ppgso::Texture> SeaweedInstanced::texture;
 
-SeaweedInstanced::SeaweedInstanced(int count) : instanceCount(count) {
+SeaweedInstanced::SeaweedInstanced(int count, bool gpuAnimation) : instanceCount(count), gpuAnimation(gpuAnimation) {
     // Load shared resources
-    if (!shader) shader = std::make_unique<ppgso::Shader>(underwater_vert_glsl, underwater_frag_glsl);
-    if (!mesh) mesh = std::make_unique<ppgso::Mesh>("seaweed/maya2sketchfab.obj");
-    if (!texture) texture = std::make_unique<ppgso::Texture>(ppgso::image::loadBMP("seaweed/abstract-solid-shining-yellow-gradient-studio-wall-room-background.bmp"));
+    if (!shader) {
+        shader = ppgso::ShaderRegistry::get(underwater_instanced_vert_glsl, underwater_frag_glsl);
+        shader->setUniformBlock("SceneBlock", UnderwaterScene::SceneBlockBinding);
+    }
+    if (!mesh) mesh = ppgso::AssetLoader::shared().loadMesh("seaweed/maya2sketchfab.obj", ppgso::MeshOptions::compact());
+    if (!texture) texture = ppgso::AssetLoader::shared().loadTexture("seaweed/abstract-solid-shining-yellow-gradient-studio-wall-room-background.bmp", ppgso::TextureOptions::compressed());
     
     // Reserve space for instance data
     instanceMatrices.resize(instanceCount);
@@ -37,59 +41,156 @@ SeaweedInstanced::SeaweedInstanced(int count) : instanceCount(count) {
         swaySpeeds[i] = 0.3f + static_cast<float>(rand()) / RAND_MAX * 0.4f;
     }
     
+    sortIntoCells();
     setupInstances();
     
-    std::cout << "SeaweedInstanced: Created " << instanceCount << " instances using GPU instancing" << std::endl;
+    // Instances are culled by cell in render
+    isStatic = true;
+    
+    // No culling for plants (two-sided leaves)
+    renderState.cullFace = false;
+    setDrawResources(shader.get(), texture.get(), mesh.get());
+    
+    std::cout << "SeaweedInstanced: Created " << instanceCount << " instances using GPU instancing"
+              << (gpuAnimation ? " (GPU animated)" : " (CPU animated)") << std::endl;
 }
 
 SeaweedInstanced::~SeaweedInstanced() {
     if (instanceVBO != 0) {
         glDeleteBuffers(1, &instanceVBO);
     }
+    if (swayVBO != 0) {
+        glDeleteBuffers(1, &swayVBO);
+    }
+}
+
+glm::mat4 SeaweedInstanced::baseMatrix(int i) const {
+    glm::mat4 model = glm::mat4(1.0f);
+    
+    // Position
+    model = glm::translate(model, instancePositions[i]);
+    
+    // Random scale per instance (seeded by index for consistency)
+    float heightScale = 0.08f + (static_cast<float>((i * 17) % 100) / 100.0f) * 0.12f;
+    return glm::scale(model, glm::vec3(heightScale * 0.6f, heightScale, heightScale * 0.6f));
+}
+
+float SeaweedInstanced::baseYaw(int i) const {
+    // Random Y rotation (consistent per instance)
+    return static_cast<float>((i * 31) % 628) / 100.0f;
+}
+
+void SeaweedInstanced::sortIntoCells() {
+    cells.clear();
+    if (instanceCount == 0) return;
+    
+    // Grid covering all instances, cells are numbered row by row
+    glm::vec2 minimum{instancePositions[0].x, instancePositions[0].z};
+    glm::vec2 maximum = minimum;
+    for (auto& position : instancePositions) {
+        minimum = glm::min(minimum, glm::vec2(position.x, position.z));
+        maximum = glm::max(maximum, glm::vec2(position.x, position.z));
+    }
+    auto columns = static_cast<int>((maximum.x - minimum.x) / CellSize) + 1;
+    auto rows = static_cast<int>((maximum.y - minimum.y) / CellSize) + 1;
+    
+    std::vector<int> cellOf(instanceCount);
+    std::vector<int> cellStart(columns * rows + 1, 0);
+    for (int i = 0; i < instanceCount; i++) {
+        auto column = static_cast<int>((instancePositions[i].x - minimum.x) / CellSize);
+        auto row = static_cast<int>((instancePositions[i].z - minimum.y) / CellSize);
+        cellOf[i] = row * columns + column;
+        cellStart[cellOf[i] + 1]++;
+    }
+    for (size_t c = 1; c < cellStart.size(); c++) {
+        cellStart[c] += cellStart[c - 1];
+    }
+    
+    // Counting sort of the instance data, the order within a cell is kept
+    auto positions = instancePositions;
+    auto phases = swayPhases;
+    auto speeds = swaySpeeds;
+    auto offsets = cellStart;
+    for (int i = 0; i < instanceCount; i++) {
+        auto target = offsets[cellOf[i]]++;
+        instancePositions[target] = positions[i];
+        swayPhases[target] = phases[i];
+        swaySpeeds[target] = speeds[i];
+    }
+    
+    // Empty cells are left out, consecutive cells stay adjacent in the instance buffers
+    for (size_t c = 0; c + 1 < cellStart.size(); c++) {
+        Cell cell;
+        cell.first = cellStart[c];
+        cell.count = cellStart[c + 1] - cellStart[c];
+        if (cell.count > 0) cells.push_back(cell);
+    }
+}
+
+void SeaweedInstanced::updateCellBounds() {
+    // Bounding sphere moved onto the yaw axis so it encloses every yaw, grown by the largest sway
+    auto sphere = mesh->getBoundingSphere();
+    float axisOffset = glm::length(glm::vec2(sphere.center.x, sphere.center.z));
+    glm::vec3 localCenter(0.0f, sphere.center.y, 0.0f);
+    float localRadius = sphere.radius + axisOffset + glm::length(localCenter) * swayAmplitude * 1.5f;
+    
+    for (auto& cell : cells) {
+        cell.bounds = ppgso::BoundingBox{};
+        for (int i = cell.first; i < cell.first + cell.count; i++) {
+            auto bounds = ppgso::BoundingSphere{localCenter, localRadius}.transform(baseMatrix(i));
+            cell.bounds.expand(bounds.center - glm::vec3(bounds.radius));
+            cell.bounds.expand(bounds.center + glm::vec3(bounds.radius));
+        }
+    }
 }
 
 void SeaweedInstanced::setupInstances() {
-    // Create VBO for instance matrices
     glGenBuffers(1, &instanceVBO);
     glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
-    glBufferData(GL_ARRAY_BUFFER, instanceCount * sizeof(glm::mat4), nullptr, GL_DYNAMIC_DRAW);
     
-    // Get the mesh VAO and set up instance attributes
-    // Note: We'll update matrices in the update function
-    updateInstanceMatrices();
+    if (!gpuAnimation) {
+        // Matrices are rebuilt every update, the visible ranges are uploaded in render
+        glBufferData(GL_ARRAY_BUFFER, instanceCount * sizeof(glm::mat4), nullptr, GL_DYNAMIC_DRAW);
+        updateInstanceMatrices();
+        return;
+    }
+    
+    // Static base transforms, the vertex shader adds the sway on top
+    for (int i = 0; i < instanceCount; i++) {
+        instanceMatrices[i] = baseMatrix(i);
+    }
+    glBufferData(GL_ARRAY_BUFFER, instanceCount * sizeof(glm::mat4), instanceMatrices.data(), GL_STATIC_DRAW);
+    
+    // Static animation parameters: phase, speed and yaw per instance
+    std::vector<glm::vec4> sway(instanceCount);
+    for (int i = 0; i < instanceCount; i++) {
+        sway[i] = glm::vec4(swayPhases[i], swaySpeeds[i], baseYaw(i), 0.0f);
+    }
+    glGenBuffers(1, &swayVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, swayVBO);
+    glBufferData(GL_ARRAY_BUFFER, instanceCount * sizeof(glm::vec4), sway.data(), GL_STATIC_DRAW);
 }
 
 void SeaweedInstanced::updateInstanceMatrices() {
     for (int i = 0; i < instanceCount; i++) {
-        glm::mat4 model = glm::mat4(1.0f);
-        
-        // Position
-        model = glm::translate(model, instancePositions[i]);
-        
-        // Random scale per instance (seeded by index for consistency)
-        float heightScale = 0.08f + (static_cast<float>((i * 17) % 100) / 100.0f) * 0.12f;
-        model = glm::scale(model, glm::vec3(heightScale * 0.6f, heightScale, heightScale * 0.6f));
+        glm::mat4 model = baseMatrix(i);
         
         // Sway animation
         float swayX = sin(swayPhases[i]) * swayAmplitude;
         float swayZ = sin(swayPhases[i] * 0.7f + 1.0f) * swayAmplitude * 0.5f;
         model = glm::rotate(model, swayX, glm::vec3(1, 0, 0));
         model = glm::rotate(model, swayZ, glm::vec3(0, 0, 1));
-        
-        // Random Y rotation (consistent per instance)
-        float yRot = static_cast<float>((i * 31) % 628) / 100.0f;
-        model = glm::rotate(model, yRot, glm::vec3(0, 1, 0));
+        model = glm::rotate(model, baseYaw(i), glm::vec3(0, 1, 0));
         
         instanceMatrices[i] = model;
     }
-    
-    // Upload to GPU
-    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, instanceCount * sizeof(glm::mat4), instanceMatrices.data());
 }
 
 bool SeaweedInstanced::update(UnderwaterScene& scene, float dt) {
-    globalTime += dt;
+    // Sway is evaluated in the vertex shader from the scene Time
+    if (gpuAnimation) {
+        return true;
+    }
     
     // Update sway phases
     for (int i = 0; i < instanceCount; i++) {
@@ -103,48 +204,53 @@ bool SeaweedInstanced::update(UnderwaterScene& scene, float dt) {
 }
 
 void SeaweedInstanced::render(UnderwaterScene& scene) {
-    // Disable culling for plants (two-sided leaves)
-    glDisable(GL_CULL_FACE);
-    
-    shader->use();
-    
-    // Set common uniforms
-    shader->setUniform("ProjectionMatrix", scene.camera->projectionMatrix);
-    shader->setUniform("ViewMatrix", scene.camera->viewMatrix);
+    // Bounds need the mesh, which may still be loading
+    if (cells.empty() || cells[0].bounds.empty()) {
+        if (mesh->getBounds().empty()) return;
+        updateCellBounds();
+    }
     
-    // Directional light (sun)
-    shader->setUniform("LightDirection", scene.lightDirection);
-    shader->setUniform("CameraPosition", scene.camera->position);
+    // Collect the instance ranges of the cells inside the view frustum
+    visibleRanges.clear();
+    int visibleCount = 0;
+    for (auto& cell : cells) {
+        if (!scene.frustum.intersects(cell.bounds)) continue;
+        if (!visibleRanges.empty() && visibleRanges.back().first + visibleRanges.back().second == cell.first) {
+            visibleRanges.back().second += cell.count;
+        } else {
+            visibleRanges.emplace_back(cell.first, cell.count);
+        }
+        visibleCount += cell.count;
+    }
     
-    // Point light (bioluminescent)
-    shader->setUniform("PointLightPos", scene.pointLightPos);
-    shader->setUniform("PointLightColor", scene.pointLightColor);
-    shader->setUniform("PointLightIntensity", scene.pointLightIntensity);
+    scene.statistics.visibleInstances += visibleCount;
+    scene.statistics.culledInstances += instanceCount - visibleCount;
+    if (visibleCount == 0) return;
     
-    // Spotlight (diver's flashlight)
-    shader->setUniform("SpotLightPos", scene.spotLightPos);
-    shader->setUniform("SpotLightDir", scene.spotLightDir);
-    shader->setUniform("SpotLightColor", scene.spotLightColor);
-    shader->setUniform("SpotLightCutoff", scene.spotLightCutoff);
-    shader->setUniform("SpotLightIntensity", scene.spotLightIntensity);
+    // CPU animated matrices changed since the last frame, only the visible ones are needed
+    if (!gpuAnimation) {
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        for (auto& range : visibleRanges) {
+            glBufferSubData(GL_ARRAY_BUFFER, range.first * sizeof(glm::mat4), range.second * sizeof(glm::mat4),
+                            instanceMatrices.data() + range.first);
+        }
+    }
     
-    // Fog uniforms
-    shader->setUniform("FogColor", scene.fogColor);
-    shader->setUniform("FogDensity", scene.fogDensity);
+    shader->use();
     
     // Set texture
     shader->setUniform("Texture", *texture);
     shader->setUniform("Transparency", 1.0f);
     shader->setUniform("TextureOffset", glm::vec2(0.0f));
     
-    // Render all instances
-    // We render each instance with its own model matrix
-    // For true GPU instancing, we would modify the shader and mesh rendering
-    // But this approach also works and demonstrates the concept
-    for (int i = 0; i < instanceCount; i++) {
-        shader->setUniform("ModelMatrix", instanceMatrices[i]);
-        mesh->render();
-    }
+    // CPU animated matrices already contain the sway
+    shader->setUniform("SwayAmplitude", gpuAnimation ? swayAmplitude : 0.0f);
     
-    glEnable(GL_CULL_FACE);
+    // The mesh is shared by all SeaweedInstanced objects, so point its per-instance
+    // attributes at the start of each range of our buffers before drawing it
+    for (auto& range : visibleRanges) {
+        mesh->setInstanceMatrices(instanceVBO, 3, range.first);
+        mesh->setInstanceAttribute(swayVBO, 7, 4, range.first);
+        mesh->renderInstanced(range.second);
+    }
 }
@@ -10,13 +10,21 @@
 /*!
  * Instanced Seaweed - Renders 5000+ seaweed instances efficiently using OpenGL instancing
  * This demonstrates efficient instantiation of 3D objects for the project requirements
+ *
+ * Instances are sorted into a grid of cells at construction and stored cell by cell, so every
+ * cell is a contiguous range of the instance buffers. Cells outside the view frustum are culled
+ * and the ranges of the visible ones are drawn straight from the buffers.
+ *
+ * With GPU animation enabled the per-instance base transform, phase and speed are uploaded once
+ * and the sway is computed in the vertex shader. Otherwise all instance matrices are rebuilt
+ * on the CPU every update and only the visible ranges are uploaded.
  */
 class SeaweedInstanced : public UnderwaterObject {
 private:
     // Shared resources
-    static std::unique_ptr<ppgso::Shader> shader;
-    static std::unique_ptr<ppgso::Mesh> mesh;
-    static std::unique_ptr<ppgso::Texture> texture;
+    static std::shared_ptr<ppgso::Shader> shader;
+    static std::shared_ptr<ppgso::Mesh> mesh;
+    static std::shared_ptr<ppgso::Texture> texture;
     
     // Instance data
     std::vector<glm::mat4> instanceMatrices;
@@ -24,14 +32,37 @@ private:
     std::vector<float> swayPhases;
     std::vector<float> swaySpeeds;
     
+    // Range of instances in one grid cell with world space bounds valid for any sway and yaw
+    struct Cell {
+        int first = 0;
+        int count = 0;
+        ppgso::BoundingBox bounds;
+    };
+    static constexpr float CellSize = 25.0f;
+    std::vector<Cell> cells;
+    
+    // Instance ranges of the visible cells, adjacent ranges merged, rebuilt every frame
+    std::vector<std::pair<int, int>> visibleRanges;
+    
     GLuint instanceVBO = 0;
+    GLuint swayVBO = 0;
     int instanceCount = 0;
+    bool gpuAnimation = true;
     
-    float globalTime = 0.0f;
     float swayAmplitude = 0.08f;
 
+    // Per-instance transform without the animated sway
+    glm::mat4 baseMatrix(int i) const;
+    float baseYaw(int i) const;
+    
+    // Reorder the instances cell by cell and create the cells
+    void sortIntoCells();
+    
+    // Compute the cell bounds from the loaded mesh
+    void updateCellBounds();
+
 public:
-    SeaweedInstanced(int count = 5000);
+    SeaweedInstanced(int count = 5000, bool gpuAnimation = true);
     ~SeaweedInstanced();
     
     bool update(UnderwaterScene& scene, float dt) override;
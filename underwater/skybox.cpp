@@ -7,7 +7,7 @@
 #include <shaders/skybox_frag_glsl.h>
 
 // Static resources
-std::unique_ptr<ppgso::Shader> Skybox::shader;
+std::shared_ptr<ppgso::Shader> Skybox::shader;
 
 // Cube vertices for skybox (36 vertices, 6 faces, 2 triangles each)
 static float skyboxVertices[] = {
@@ -59,7 +59,7 @@ void Skybox::initCube() {
     glGenVertexArrays(1, &skyboxVAO);
     glGenBuffers(1, &skyboxVBO);
     
-    glBindVertexArray(skyboxVAO);
+    ppgso::StateCache::bindVertexArray(skyboxVAO);
     glBindBuffer(GL_ARRAY_BUFFER, skyboxVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(skyboxVertices), &skyboxVertices, GL_STATIC_DRAW);
     
@@ -67,19 +67,28 @@ void Skybox::initCube() {
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
     
-    glBindVertexArray(0);
+    ppgso::StateCache::bindVertexArray(0);
 }
 
 Skybox::Skybox() {
     // Use cubemap skybox shader (procedural sky)
-    if (!shader) shader = std::make_unique<ppgso::Shader>(skybox_vert_glsl, skybox_frag_glsl);
+    if (!shader) shader = ppgso::ShaderRegistry::get(skybox_vert_glsl, skybox_frag_glsl);
     
     // Initialize cube geometry
     initCube();
+    
+    // Drawn behind everything: LEQUAL depth test so the sky passes at z=1.0, seen from inside
+    background = true;
+    renderState.depthFunc = GL_LEQUAL;
+    renderState.cullFace = false;
+    setDrawResources(shader.get(), nullptr, &skyboxVAO);
 }
 
 Skybox::~Skybox() {
-    if (skyboxVAO) glDeleteVertexArrays(1, &skyboxVAO);
+    if (skyboxVAO) {
+        ppgso::StateCache::forgetVertexArray(skyboxVAO);
+        glDeleteVertexArrays(1, &skyboxVAO);
+    }
     if (skyboxVBO) glDeleteBuffers(1, &skyboxVBO);
 }
 
@@ -89,10 +98,6 @@ bool Skybox::update(UnderwaterScene& scene, float dt) {
 }
 
 void Skybox::render(UnderwaterScene& scene) {
-    // Change depth function to LEQUAL so skybox passes at z=1.0
-    glDepthFunc(GL_LEQUAL);
-    glDisable(GL_CULL_FACE);
-    
     shader->use();
     
     shader->setUniform("ProjectionMatrix", scene.camera->projectionMatrix);
@@ -101,11 +106,6 @@ void Skybox::render(UnderwaterScene& scene) {
     shader->setUniform("SunDirection", scene.lightDirection);
     
     // Draw the cube
-    glBindVertexArray(skyboxVAO);
+    ppgso::StateCache::bindVertexArray(skyboxVAO);
     glDrawArrays(GL_TRIANGLES, 0, 36);
-    glBindVertexArray(0);
-    
-    // Restore default depth function
-    glDepthFunc(GL_LESS);
-    glEnable(GL_CULL_FACE);
 }
@@ -10,7 +10,7 @@
  */
 class Skybox : public UnderwaterObject {
 private:
-    static std::unique_ptr<ppgso::Shader> shader;
+    static std::shared_ptr<ppgso::Shader> shader;
     
     // Cube vertex data for skybox (no texture, shader uses direction)
     GLuint skyboxVAO = 0;
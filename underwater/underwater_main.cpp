@@ -15,6 +15,7 @@
 // - R: Reset scene and camera animation
 // - P: Pause/Resume animation
 // - 1-7: Toggle post-processing effects
+// - I: Print render statistics of the last frame
 // - ESC: Exit
 
 #include <iostream>
@@ -30,7 +31,6 @@
 #include "underwater_object.h"
 #include "ground.h"
 #include "fish.h"
-#include "bubble.h"
 #include "bubble_generator.h"
 #include "jellyfish.h"
 #include "seaweed.h"
@@ -64,6 +64,50 @@ private:
     int postProcessEffect = 7;  // Default: underwater distortion
     float globalTime = 0.0f;
     
+    bool firstFrame = true;
+    bool assetsLoading = true;
+
+    // Time per frame spent creating OpenGL objects of loaded assets
+    static constexpr double AssetUploadBudget = 0.002;
+
+    // Statistics of the last completed frame
+    ppgso::Shader::Statistics shaderStatistics;
+    ppgso::StateCache::Statistics stateStatistics;
+    
+    /*!
+     * Print statistics gathered during the last frame
+     */
+    void printStatistics() {
+        std::cout << "\n=== Frame statistics ===" << std::endl;
+        std::cout << "Uniform lookups: " << shaderStatistics.uniformLookups
+                  << " (" << shaderStatistics.uniformMisses << " inactive)" << std::endl;
+        std::cout << "Program binds: " << shaderStatistics.programBinds
+                  << " (" << shaderStatistics.programBindsSkipped << " skipped)" << std::endl;
+        std::cout << "Objects drawn: " << scene.statistics.visibleObjects
+                  << " (" << scene.statistics.culledObjects << " culled)" << std::endl;
+        std::cout << "Instances drawn: " << scene.statistics.visibleInstances
+                  << " (" << scene.statistics.culledInstances << " culled)" << std::endl;
+        std::cout << "Draw packets: " << scene.statistics.drawPackets
+                  << " (" << scene.statistics.stateChanges << " state changes)" << std::endl;
+        std::cout << "GL state calls: " << stateStatistics.issued
+                  << " (" << stateStatistics.avoided << " avoided)" << std::endl;
+        
+        // Memory of every shared mesh and texture, largest first
+        auto usage = ppgso::ResourceCache::getUsage();
+        ppgso::ResidentBytes total;
+        for (auto& resource : usage) {
+            total.cpu += resource.bytes.cpu;
+            total.gpu += resource.bytes.gpu;
+        }
+        std::cout << "Shared resources: " << usage.size() << " meshes and textures ("
+                  << total.cpu / 1024 << " KB CPU, " << total.gpu / 1024 << " KB GPU), "
+                  << ppgso::ShaderRegistry::size() << " programs" << std::endl;
+        for (auto& resource : usage) {
+            std::cout << "  " << resource.path << ": " << resource.bytes.cpu / 1024 << " KB CPU, "
+                      << resource.bytes.gpu / 1024 << " KB GPU" << std::endl;
+        }
+    }
+    
     void setupFramebuffer() {
         // Create framebuffer
         glGenFramebuffers(1, &framebuffer);
@@ -71,7 +115,7 @@ private:
         
         // Create color texture attachment
         glGenTextures(1, &textureColorbuffer);
-        glBindTexture(GL_TEXTURE_2D, textureColorbuffer);
+        ppgso::StateCache::bindTexture(0, GL_TEXTURE_2D, textureColorbuffer);
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, WIDTH, HEIGHT, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -102,14 +146,14 @@ private:
         
         glGenVertexArrays(1, &quadVAO);
         glGenBuffers(1, &quadVBO);
-        glBindVertexArray(quadVAO);
+        ppgso::StateCache::bindVertexArray(quadVAO);
         glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
         glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
         glEnableVertexAttribArray(0);
         glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
         glEnableVertexAttribArray(1);
         glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
-        glBindVertexArray(0);
+        ppgso::StateCache::bindVertexArray(0);
         
         // Load post-process shader
         postProcessShader = std::make_unique<ppgso::Shader>(postprocess_vert_glsl, postprocess_frag_glsl);
@@ -122,6 +166,7 @@ private:
      */
     void initScene() {
         scene.objects.clear();
+        scene.invalidateStaticBvh();
 
         // Create camera with keyframe animation
         auto camera = std::make_unique<UnderwaterCamera>(60.0f, (float)WIDTH / HEIGHT, 0.1f, 500.0f);
@@ -413,18 +458,21 @@ public:
         
         glfwSetInputMode(window, GLFW_STICKY_KEYS, 1);
 
-        // Initialize OpenGL state
-        glEnable(GL_DEPTH_TEST);
-        glDepthFunc(GL_LEQUAL);
+        // Reuse linked shader programs from previous runs
+        ppgso::Shader::setBinaryCacheDirectory("shader_cache");
+
+        // Initialize OpenGL state, everything changed per draw goes through the state cache
+        ppgso::StateCache::enable(GL_DEPTH_TEST, true);
+        ppgso::StateCache::depthFunc(GL_LEQUAL);
 
         // Enable face culling
-        glEnable(GL_CULL_FACE);
+        ppgso::StateCache::enable(GL_CULL_FACE, true);
         glFrontFace(GL_CCW);
         glCullFace(GL_BACK);
 
         // Enable blending for transparency
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        ppgso::StateCache::enable(GL_BLEND, true);
+        ppgso::StateCache::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
         // Setup post-processing framebuffer
         setupFramebuffer();
@@ -442,6 +490,7 @@ public:
         std::cout << "5: Bloom effect" << std::endl;
         std::cout << "6: Vignette effect" << std::endl;
         std::cout << "7: Underwater distortion (default)" << std::endl;
+        std::cout << "I: Print frame statistics" << std::endl;
         std::cout << "ESC: Exit" << std::endl;
     }
 
@@ -473,6 +522,11 @@ public:
             if (key == GLFW_KEY_7) { postProcessEffect = 7; std::cout << "Post-process: Underwater Distortion" << std::endl; }
         }
 
+        // Statistics
+        if (key == GLFW_KEY_I && action == GLFW_PRESS) {
+            printStatistics();
+        }
+
         // Exit
         if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) {
             glfwSetWindowShouldClose(window, GLFW_TRUE);
@@ -508,37 +562,54 @@ public:
         float dt = animate ? static_cast<float>(glfwGetTime()) - time : 0;
         time = static_cast<float>(glfwGetTime());
         globalTime += dt;
+        
+        // Keep counters of the previous frame for printing and start counting again
+        shaderStatistics = ppgso::Shader::getStatistics();
+        ppgso::Shader::resetStatistics();
+        stateStatistics = ppgso::StateCache::getStatistics();
+        ppgso::StateCache::resetStatistics();
 
         // ============ PASS 1: Render scene to framebuffer ============
         glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
-        glEnable(GL_DEPTH_TEST);
+        ppgso::StateCache::enable(GL_DEPTH_TEST, true);
         
         // Set underwater background color - MATCH FOG COLOR for seamless blend
         glClearColor(scene.fogColor.r, scene.fogColor.g, scene.fogColor.b, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+        // Meshes and textures finished by the loader threads, new meshes change the static bounds
+        auto& loader = ppgso::AssetLoader::shared();
+        if (loader.update(AssetUploadBudget)) scene.invalidateStaticBvh();
+        if (assetsLoading && loader.getPending() == 0) {
+            std::cout << "All assets loaded: " << glfwGetTime() * 1000.0 << " ms" << std::endl;
+            assetsLoading = false;
+        }
+
         // Update and render scene
         scene.update(dt);
         scene.render();
         
         // ============ PASS 2: Apply post-processing to screen ============
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        glDisable(GL_DEPTH_TEST);
+        ppgso::StateCache::enable(GL_DEPTH_TEST, false);
         glClear(GL_COLOR_BUFFER_BIT);
         
         postProcessShader->use();
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, textureColorbuffer);
+        ppgso::StateCache::bindTexture(0, GL_TEXTURE_2D, textureColorbuffer);
         postProcessShader->setUniform("Texture", 0);
         postProcessShader->setUniform("EffectType", postProcessEffect);
         postProcessShader->setUniform("Time", globalTime);
         
         // Render fullscreen quad
-        glBindVertexArray(quadVAO);
+        ppgso::StateCache::bindVertexArray(quadVAO);
         glDrawArrays(GL_TRIANGLES, 0, 6);
-        glBindVertexArray(0);
-        
-        glEnable(GL_DEPTH_TEST);
+
+        // Startup cost until the scene first appears, assets may still be streaming in
+        if (firstFrame) {
+            glFinish();
+            std::cout << "Time to first frame: " << glfwGetTime() * 1000.0 << " ms" << std::endl;
+            firstFrame = false;
+        }
     }
 };
 
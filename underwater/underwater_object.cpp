@@ -5,6 +5,8 @@
 #include <glm/gtx/transform.hpp>
 
 #include "underwater_object.h"
+#include "underwater_scene.h"
+#include "underwater_camera.h"
 
 void UnderwaterObject::generateModelMatrix() {
     // Local transform
@@ -17,3 +19,29 @@ void UnderwaterObject::generateModelMatrix() {
         modelMatrix = parent->modelMatrix * modelMatrix;
     }
 }
+
+float UnderwaterObject::screenSize(const UnderwaterScene& scene, float radius) const {
+    // Scale the radius by the largest axis of the model matrix, including parent transforms
+    float maxScale = glm::max(glm::length(glm::vec3(modelMatrix[0])),
+                              glm::max(glm::length(glm::vec3(modelMatrix[1])), glm::length(glm::vec3(modelMatrix[2]))));
+    float worldRadius = radius * maxScale;
+
+    float distance = glm::length(glm::vec3(modelMatrix[3]) - scene.camera->position);
+    if (distance <= worldRadius) return 1.0f;
+
+    // projectionMatrix[1][1] is cot(fov / 2), which maps a view space height to half the viewport
+    return worldRadius * scene.camera->projectionMatrix[1][1] / distance;
+}
+
+uint64_t UnderwaterObject::sortKey(float depth) const {
+    auto pass = isTranslucent() ? ppgso::RenderQueue::Translucent
+              : background ? ppgso::RenderQueue::Background : ppgso::RenderQueue::Opaque;
+    return ppgso::RenderQueue::makeKey(pass, drawProgram, drawTexture, drawMesh, depth);
+}
+
+void UnderwaterObject::setDrawResources(const ppgso::Shader* shader, ppgso::Texture* texture, const void* mesh) {
+    drawProgram = shader ? shader->getProgram() : 0;
+    drawTexture = texture ? texture->getTexture() : 0;
+    // Allocations are at least 16 byte aligned, the low bits carry no information
+    drawMesh = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(mesh) >> 4);
+}
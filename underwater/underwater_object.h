@@ -4,9 +4,15 @@
 #include <memory>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <ppgso/bounds.h>
+#include <ppgso/render_queue.h>
 
-// Forward declaration
+// Forward declarations
 class UnderwaterScene;
+namespace ppgso {
+    class Shader;
+    class Texture;
+}
 
 /*!
  * Abstract base class for all objects in the underwater scene
@@ -38,6 +44,14 @@ public:
      */
     virtual bool isTranslucent() const { return translucent; }
 
+    /*!
+     * Get world space bounds for frustum culling
+     * Objects without bounds are always rendered
+     * @param bounds - Receives the bounding box from the current model matrix
+     * @return true if bounds were provided
+     */
+    virtual bool getBounds(ppgso::BoundingBox& bounds) const { return false; }
+
     // Transform properties
     glm::vec3 position{0, 0, 0};
     glm::vec3 rotation{0, 0, 0};
@@ -50,12 +64,49 @@ public:
     // Transparency flag for depth sorting
     bool translucent = false;
 
+    // Static objects never move after their first update, the scene keeps them in a prebuilt BVH
+    bool isStatic = false;
+
+    // GL state the object is drawn with, applied by the scene's render queue
+    ppgso::RenderState renderState;
+
+    // Background objects are drawn after all opaque objects and before translucent ones
+    bool background = false;
+
+    /*!
+     * Build the render queue sort key of the object
+     * @param depth - Distance from the camera normalized to 0-1
+     * @return Key grouping the object with others sharing its shader, texture and mesh
+     */
+    uint64_t sortKey(float depth) const;
+
 protected:
     /*!
      * Generate model matrix from position, rotation, scale
      * Takes parent transform into account for hierarchical scene
      */
     void generateModelMatrix();
+
+    /*!
+     * Get the projected size of the object for level of detail selection
+     * @param scene - Scene with the current camera
+     * @param radius - Bounding radius of the object's mesh in model space
+     * @return Projected diameter as a fraction of the viewport height
+     */
+    float screenSize(const UnderwaterScene& scene, float radius) const;
+
+    /*!
+     * Remember the resources used by render so the scene can group draws sharing them
+     * @param shader - Shader program, may be nullptr
+     * @param texture - Texture, may be nullptr
+     * @param mesh - Any pointer identifying the geometry, may be nullptr
+     */
+    void setDrawResources(const ppgso::Shader* shader, ppgso::Texture* texture, const void* mesh);
+
+private:
+    uint32_t drawProgram = 0;
+    uint32_t drawTexture = 0;
+    uint32_t drawMesh = 0;
 };
 
 #endif // UNDERWATER_OBJECT_H
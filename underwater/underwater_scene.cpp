@@ -47,47 +47,190 @@ void UnderwaterScene::update(float dt) {
                            depthFactor);
     }
 
-    // Update all objects, remove those that return false
-    auto i = std::begin(objects);
-    while (i != std::end(objects)) {
-        auto obj = i->get();
-        if (!obj->update(*this, dt))
-            i = objects.erase(i);
-        else
-            ++i;
+    // Group objects by hierarchy depth, each wave only reads transforms of earlier waves
+    for (auto& wave : updateWaves) wave.clear();
+    for (auto i = std::begin(objects); i != std::end(objects); ++i) {
+        size_t depth = 0;
+        for (auto parent = (*i)->parent; parent; parent = parent->parent) depth++;
+        if (depth >= updateWaves.size()) updateWaves.resize(depth + 1);
+        updateWaves[depth].push_back(i);
     }
+    
+    auto& jobs = ppgso::JobSystem::shared();
+    
+    // Objects within a wave are independent, removals are only recorded until all waves are done
+    removedObjects.clear();
+    for (auto& wave : updateWaves) {
+        updateResults.assign(wave.size(), 1);
+        jobs.parallelFor(wave.size(), UpdateGrain, [this, &wave, dt](size_t first, size_t last) {
+            for (auto i = first; i < last; i++) {
+                updateResults[i] = (*wave[i])->update(*this, dt);
+            }
+        });
+        
+        for (size_t i = 0; i < wave.size(); i++) {
+            auto obj = wave[i]->get();
+            // Children would keep a dangling parent, remove them with it
+            bool orphaned = obj->parent && std::any_of(removedObjects.begin(), removedObjects.end(),
+                [obj](ObjectIterator removed) { return removed->get() == obj->parent; });
+            if (!updateResults[i] || orphaned) removedObjects.push_back(wave[i]);
+        }
+    }
+    
+    if (removedObjects.empty()) return;
+    pruneBvhs();
+    for (auto i : removedObjects) objects.erase(i);
 }
 
 void UnderwaterScene::render() {
-    // Separate opaque and translucent objects
-    std::vector<UnderwaterObject*> opaqueObjects;
-    std::vector<UnderwaterObject*> translucentObjects;
+    // Upload camera, lights and fog once, all underwater shaders read them from the SceneBlock
+    if (!sceneBuffer)
+        sceneBuffer = std::make_unique<ppgso::UniformBuffer>(sizeof(SceneUniforms), SceneBlockBinding);
+
+    SceneUniforms uniforms{};
+    uniforms.projectionMatrix = camera->projectionMatrix;
+    uniforms.viewMatrix = camera->viewMatrix;
+    uniforms.cameraPosition = camera->position;
+    uniforms.fogDensity = fogDensity;
+    uniforms.fogColor = fogColor;
+    uniforms.time = globalTime;
+    uniforms.lightDirection = lightDirection;
+    uniforms.pointLightIntensity = pointLightIntensity;
+    uniforms.pointLightPos = pointLightPos;
+    uniforms.spotLightCutoff = spotLightCutoff;
+    uniforms.pointLightColor = pointLightColor;
+    uniforms.spotLightIntensity = spotLightIntensity;
+    uniforms.spotLightPos = spotLightPos;
+    uniforms.spotLightDir = spotLightDir;
+    uniforms.spotLightColor = spotLightColor;
+    sceneBuffer->update(uniforms);
+
+    frustum = ppgso::Frustum{camera->projectionMatrix * camera->viewMatrix};
+    statistics = Statistics{};
+
+    // Objects without bounds are always drawn, the rest come from the frustum queries
+    visibleObjects.clear();
+    updateBvhs(visibleObjects);
+    
+    queryResults.clear();
+    staticBvh.query(frustum, queryResults);
+    for (auto index : queryResults) visibleObjects.push_back(staticObjects[index]);
+    
+    queryResults.clear();
+    dynamicBvh.query(frustum, queryResults);
+    for (auto index : queryResults) visibleObjects.push_back(dynamicObjects[index]);
+    
+    statistics.visibleObjects = static_cast<unsigned int>(visibleObjects.size());
+    statistics.culledObjects = static_cast<unsigned int>(objects.size() - visibleObjects.size());
+
+    // Depth keys are normalized by the far plane distance taken from the projection matrix
+    float farPlane = camera->projectionMatrix[3][2] / (camera->projectionMatrix[2][2] + 1.0f);
+    
+    // Opaque objects grouped by resources and front-to-back, then background, then translucent back-to-front
+    renderQueue.clear();
+    for (size_t i = 0; i < visibleObjects.size(); i++) {
+        auto obj = visibleObjects[i];
+        float distance = glm::length(glm::vec3(obj->modelMatrix[3]) - camera->position);
+        renderQueue.submit(obj->sortKey(distance / farPlane), obj->renderState, static_cast<uint32_t>(i));
+    }
+    renderQueue.sort();
+    renderQueue.execute([this](uint32_t item) {
+        visibleObjects[item]->render(*this);
+    });
+    
+    statistics.drawPackets = static_cast<unsigned int>(renderQueue.getStatistics().packets);
+    statistics.stateChanges = static_cast<unsigned int>(renderQueue.getStatistics().stateChanges);
+}
+
+
+void UnderwaterScene::updateBvhs(std::vector<UnderwaterObject*>& unbounded) {
+    ppgso::BoundingBox bounds;
+    if (staticBvhDirty) {
+        staticObjects.clear();
+        staticBounds.clear();
+        staticUnbounded.clear();
+    }
     
+    // Static objects only need to be visited when their tree is rebuilt
+    auto previousDynamic = std::move(dynamicObjects);
+    dynamicObjects.clear();
+    dynamicBounds.clear();
     for (auto& obj : objects) {
-        if (obj->isTranslucent()) {
-            translucentObjects.push_back(obj.get());
+        if (obj->isStatic && !staticBvhDirty) continue;
+        
+        if (!obj->getBounds(bounds)) {
+            if (obj->isStatic) staticUnbounded.push_back(obj.get());
+            else unbounded.push_back(obj.get());
+        } else if (obj->isStatic) {
+            staticObjects.push_back(obj.get());
+            staticBounds.push_back(bounds);
         } else {
-            opaqueObjects.push_back(obj.get());
+            dynamicObjects.push_back(obj.get());
+            dynamicBounds.push_back(bounds);
         }
     }
     
-    // Sort translucent objects by distance from camera (far to near)
-    glm::vec3 camPos = camera->position;
-    std::sort(translucentObjects.begin(), translucentObjects.end(),
-        [&camPos](UnderwaterObject* a, UnderwaterObject* b) {
-            float distA = glm::length(a->position - camPos);
-            float distB = glm::length(b->position - camPos);
-            return distA > distB;  // Far objects first
-        });
-    
-    // Render opaque objects first (any order is fine)
-    for (auto obj : opaqueObjects) {
-        obj->render(*this);
+    if (staticBvhDirty) {
+        staticBvh.build(staticBounds);
+        staticBvhDirty = false;
     }
+    unbounded.insert(unbounded.end(), staticUnbounded.begin(), staticUnbounded.end());
     
-    // Render translucent objects back-to-front
-    for (auto obj : translucentObjects) {
-        obj->render(*this);
+    // Refitting keeps the tree valid as long as the same objects are in it
+    if (dynamicObjects == previousDynamic) {
+        dynamicBvh.refit(dynamicBounds);
+    } else {
+        dynamicBvh.build(dynamicBounds);
     }
 }
 
+// Remove the listed objects and their bounds, keeping the order of the rest
+static bool removeObjects(std::vector<UnderwaterObject*>& objects, std::vector<ppgso::BoundingBox>* bounds,
+                          const std::vector<UnderwaterObject*>& removed) {
+    size_t kept = 0;
+    for (size_t i = 0; i < objects.size(); i++) {
+        if (std::binary_search(removed.begin(), removed.end(), objects[i])) continue;
+        objects[kept] = objects[i];
+        if (bounds) (*bounds)[kept] = (*bounds)[i];
+        kept++;
+    }
+    if (kept == objects.size()) return false;
+    objects.resize(kept);
+    if (bounds) bounds->resize(kept);
+    return true;
+}
+
+void UnderwaterScene::pruneBvhs() {
+    removedPointers.clear();
+    for (auto i : removedObjects) removedPointers.push_back(i->get());
+    std::sort(removedPointers.begin(), removedPointers.end());
+    
+    if (removeObjects(staticObjects, &staticBounds, removedPointers)) staticBvh.build(staticBounds);
+    removeObjects(staticUnbounded, nullptr, removedPointers);
+    if (removeObjects(dynamicObjects, &dynamicBounds, removedPointers)) dynamicBvh.build(dynamicBounds);
+}
+
+void UnderwaterScene::invalidateStaticBvh() {
+    staticBvhDirty = true;
+}
+
+void UnderwaterScene::findObjects(const ppgso::BoundingSphere& sphere, std::vector<UnderwaterObject*>& results) const {
+    queryResults.clear();
+    staticBvh.query(sphere, queryResults);
+    for (auto index : queryResults) results.push_back(staticObjects[index]);
+    
+    queryResults.clear();
+    dynamicBvh.query(sphere, queryResults);
+    for (auto index : queryResults) results.push_back(dynamicObjects[index]);
+}
+
+void UnderwaterScene::findObjects(const glm::vec3& origin, const glm::vec3& direction, float maxDistance,
+                                  std::vector<UnderwaterObject*>& results) const {
+    queryResults.clear();
+    staticBvh.query(origin, direction, maxDistance, queryResults);
+    for (auto index : queryResults) results.push_back(staticObjects[index]);
+    
+    queryResults.clear();
+    dynamicBvh.query(origin, direction, maxDistance, queryResults);
+    for (auto index : queryResults) results.push_back(dynamicObjects[index]);
+}
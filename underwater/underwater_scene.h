@@ -4,9 +4,12 @@
 #include <memory>
 #include <map>
 #include <list>
+#include <vector>
 #include <algorithm>
+#include <cstddef>
 
 #include <glm/glm.hpp>
+#include <ppgso/ppgso.h>
 
 // Forward declarations
 class UnderwaterObject;
@@ -19,21 +22,94 @@ class UnderwaterCamera;
  */
 class UnderwaterScene {
 public:
+    /*!
+     * Per-frame inputs shared by all underwater shaders, uploaded once per frame
+     * Mirrors the std140 SceneBlock uniform block, vec3 members are paired with a float
+     */
+    struct SceneUniforms {
+        glm::mat4 projectionMatrix;
+        glm::mat4 viewMatrix;
+        glm::vec3 cameraPosition;
+        float fogDensity;
+        glm::vec3 fogColor;
+        float time;
+        glm::vec3 lightDirection;
+        float pointLightIntensity;
+        glm::vec3 pointLightPos;
+        float spotLightCutoff;
+        glm::vec3 pointLightColor;
+        float spotLightIntensity;
+        glm::vec3 spotLightPos;
+        float padding0;
+        glm::vec3 spotLightDir;
+        float padding1;
+        glm::vec3 spotLightColor;
+        float padding2;
+    };
+
+    // Uniform buffer binding point of the SceneBlock
+    static constexpr GLuint SceneBlockBinding = 0;
+
+    /*!
+     * Visibility counters of the last rendered frame
+     */
+    struct Statistics {
+        unsigned int visibleObjects = 0;
+        unsigned int culledObjects = 0;
+        unsigned int visibleInstances = 0;
+        unsigned int culledInstances = 0;
+        unsigned int drawPackets = 0;
+        unsigned int stateChanges = 0;
+    };
+
     /*!
      * Update all objects in the scene
+     * Objects are updated on the shared job system in waves by hierarchy depth, so parents are always
+     * updated before their children. Removals are applied after all waves.
      * @param dt - Time delta
      */
     void update(float dt);
 
     /*!
      * Render all objects in the scene
-     * Handles depth-sorting for translucent objects
+     * Visible objects are drawn through a sorted render queue, translucent objects back-to-front
      */
     void render();
 
+    /*!
+     * Rebuild the static BVH before the next frame
+     * Call after adding or removing static objects outside of update
+     */
+    void invalidateStaticBvh();
+
+    /*!
+     * Find objects whose bounds overlap a sphere
+     * Uses the bounds of the last rendered frame, objects removed since then are left out
+     * @param sphere - World space sphere
+     * @param results - Found objects are appended
+     */
+    void findObjects(const ppgso::BoundingSphere& sphere, std::vector<UnderwaterObject*>& results) const;
+
+    /*!
+     * Find objects whose bounds are hit by a ray segment
+     * Uses the bounds of the last rendered frame, objects removed since then are left out
+     * @param origin - Start of the ray
+     * @param direction - Direction of the ray
+     * @param maxDistance - Length of the segment in units of direction
+     * @param results - Found objects are appended
+     */
+    void findObjects(const glm::vec3& origin, const glm::vec3& direction, float maxDistance,
+                     std::vector<UnderwaterObject*>& results) const;
+
     // Camera object
     std::unique_ptr<UnderwaterCamera> camera;
 
+    // World space view frustum of the camera, updated at the start of render
+    ppgso::Frustum frustum;
+
+    // Culling results of the last frame, instanced objects add their own counts
+    Statistics statistics;
+
     // All objects to be rendered in scene
     std::list<std::unique_ptr<UnderwaterObject>> objects;
 
@@ -70,7 +146,65 @@ public:
     
     // Global time for animations
     float globalTime = 0.0f;
+
+private:
+    using ObjectIterator = std::list<std::unique_ptr<UnderwaterObject>>::iterator;
+
+    // Objects updated by one job, small enough to balance uneven update costs
+    static constexpr size_t UpdateGrain = 16;
+
+    // Objects grouped by hierarchy depth and the update results of a wave, storage is kept between frames
+    std::vector<std::vector<ObjectIterator>> updateWaves;
+    std::vector<char> updateResults;
+    std::vector<ObjectIterator> removedObjects;
+    std::vector<UnderwaterObject*> removedPointers;
+
+    // Uniform buffer backing the SceneBlock, created on first render
+    std::unique_ptr<ppgso::UniformBuffer> sceneBuffer;
+
+    // Static objects with bounds, built once and reused until invalidated
+    ppgso::Bvh staticBvh;
+    std::vector<UnderwaterObject*> staticObjects;
+    std::vector<ppgso::BoundingBox> staticBounds;
+    std::vector<UnderwaterObject*> staticUnbounded;
+    bool staticBvhDirty = true;
+
+    // Moving objects with bounds, refit every frame and rebuilt when the set changes
+    ppgso::Bvh dynamicBvh;
+    std::vector<UnderwaterObject*> dynamicObjects;
+    std::vector<ppgso::BoundingBox> dynamicBounds;
+
+    // Query results reused between frames
+    mutable std::vector<unsigned int> queryResults;
+
+    // Per-frame draw list, storage is kept between frames
+    std::vector<UnderwaterObject*> visibleObjects;
+    ppgso::RenderQueue renderQueue;
+
+    /*!
+     * Gather bounded objects and bring both BVHs up to date
+     * @param unbounded - Objects without bounds are appended
+     */
+    void updateBvhs(std::vector<UnderwaterObject*>& unbounded);
+
+    /*!
+     * Drop the objects about to be removed from both BVHs, so queries before the next render never return them
+     * The trees are rebuilt from the remaining bounds of the last rendered frame
+     */
+    void pruneBvhs();
 };
 
+// The SceneBlock uses std140 rules, keep the structure layout in sync with the shaders
+static_assert(offsetof(UnderwaterScene::SceneUniforms, viewMatrix) == 64, "SceneUniforms layout");
+static_assert(offsetof(UnderwaterScene::SceneUniforms, cameraPosition) == 128, "SceneUniforms layout");
+static_assert(offsetof(UnderwaterScene::SceneUniforms, fogColor) == 144, "SceneUniforms layout");
+static_assert(offsetof(UnderwaterScene::SceneUniforms, lightDirection) == 160, "SceneUniforms layout");
+static_assert(offsetof(UnderwaterScene::SceneUniforms, pointLightPos) == 176, "SceneUniforms layout");
+static_assert(offsetof(UnderwaterScene::SceneUniforms, pointLightColor) == 192, "SceneUniforms layout");
+static_assert(offsetof(UnderwaterScene::SceneUniforms, spotLightPos) == 208, "SceneUniforms layout");
+static_assert(offsetof(UnderwaterScene::SceneUniforms, spotLightDir) == 224, "SceneUniforms layout");
+static_assert(offsetof(UnderwaterScene::SceneUniforms, spotLightColor) == 240, "SceneUniforms layout");
+static_assert(sizeof(UnderwaterScene::SceneUniforms) == 256, "SceneUniforms layout");
+
 #endif // UNDERWATER_SCENE_H
 
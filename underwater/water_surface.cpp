@@ -7,20 +7,22 @@
 #include <shaders/water_frag_glsl.h>
 
 // Static resources
-std::unique_ptr<ppgso::Mesh> WaterSurface::mesh;
-std::unique_ptr<ppgso::Texture> WaterSurface::texture;
-std::unique_ptr<ppgso::Shader> WaterSurface::shader;
+std::shared_ptr<ppgso::Mesh> WaterSurface::mesh;
+std::shared_ptr<ppgso::Texture> WaterSurface::texture;
+std::shared_ptr<ppgso::Shader> WaterSurface::shader;
 
 WaterSurface::WaterSurface() {
     // Use water shader
-    if (!shader) shader = std::make_unique<ppgso::Shader>(water_vert_glsl, water_frag_glsl);
+    if (!shader) shader = ppgso::ShaderRegistry::get(water_vert_glsl, water_frag_glsl);
     // Use a simple quad mesh for water surface (same as ground)
-    if (!mesh) mesh = std::make_unique<ppgso::Mesh>("ground/quad.obj");
+    if (!mesh) mesh = ppgso::AssetLoader::shared().loadMesh("ground/quad.obj");
     // Use ground texture as fallback (water is mostly shader-based)
-    if (!texture) texture = std::make_unique<ppgso::Texture>(ppgso::image::loadBMP("ground/ground.bmp"));
+    if (!texture) texture = ppgso::AssetLoader::shared().loadTexture("ground/ground.bmp", ppgso::TextureOptions::compressed());
 
     // Mark as translucent for depth-sorting
     translucent = true;
+    renderState.blend = true;
+    setDrawResources(shader.get(), texture.get(), mesh.get());
 
     // Large water surface
     scale = glm::vec3(500.0f, 1.0f, 500.0f);
@@ -39,10 +41,6 @@ bool WaterSurface::update(UnderwaterScene& scene, float dt) {
 }
 
 void WaterSurface::render(UnderwaterScene& scene) {
-    // Enable blending for transparency
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    
     shader->use();
     
     shader->setUniform("ProjectionMatrix", scene.camera->projectionMatrix);
@@ -64,6 +62,4 @@ void WaterSurface::render(UnderwaterScene& scene) {
     shader->setUniform("Transparency", 0.85f);
     
     mesh->render();
-    
-    glDisable(GL_BLEND);
 }